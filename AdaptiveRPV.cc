@@ -0,0 +1,59 @@
+/******************************************************************************** 
+*   AdaptiveRPV.cc by Flip Tanedo (pt267@cornell.edu)                           *
+*   Adaptive scan of the RPV stop/gluino plane for the SS2L exclusion contour   *
+*   - same templating and signal_efficiency_b as PartonRPV.cc                   *
+*   - only refines the cells of the grid that the contour passes through       *
+*   - uses FlipAdaptiveScan.h for the refinement                                *
+********************************************************************************/
+
+// Inputs: mass ranges, coarse and fine steps, signal region, event limit
+//  For example:
+//  ./AdaptiveRPV 200 800 400 1400 200 25 8 3.0 CmndTemp.cmnd
+
+
+
+#include "FlipAdaptiveScan.h"       // all of my functions
+#include <sstream>                  // for string stream
+#include <fstream>                  // for file in/out
+
+
+using namespace std;
+
+
+int main(int argc, char *argv[]) { 
+
+    // INITIALIZE
+    // ----------
+    srand((unsigned)time(0));               // Initialize random numbers
+    
+    scansettings settings;                  // see FlipAdaptiveScan.h
+    fill_scansettings(settings);            // defaults
+    
+    
+    // Take in external values
+    // -----------------------
+    if (argc > 1)  settings.mstopMin    = atof(argv[1]);  // stop mass range
+    if (argc > 2)  settings.mstopMax    = atof(argv[2]);
+    if (argc > 3)  settings.mgluMin     = atof(argv[3]);  // gluino mass range
+    if (argc > 4)  settings.mgluMax     = atof(argv[4]);
+    if (argc > 5)  settings.coarseStep  = atof(argv[5]);  // starting grid
+    if (argc > 6)  settings.fineStep    = atof(argv[6]);  // final resolution
+    if (argc > 7)  settings.iSR         = atoi(argv[7]);  // signal region
+    if (argc > 8)  settings.nLimit      = atof(argv[8]);  // upper limit
+    if (argc > 9)  settings.cmndtemp    = argv[9];        // template cmnd
+    if (argc > 10) settings.pointfile   = argv[10];       // sampled points
+    if (argc > 11) settings.contourfile = argv[11];       // contour
+    if (argc > 12) settings.spctemp     = argv[12];       // template spc
+    
+    
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    adaptive_scan(settings);
+    
+    
+    return 0;
+        
+}
+    
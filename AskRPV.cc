@@ -0,0 +1,128 @@
+/********************************************************************************
+*   AskRPV.cc by Flip Tanedo (pt267@cornell.edu)                                *
+*   Sends requests to ServeRPV and prints the answers as they come back         *
+*   - one request from the command line, or one per line from stdin             *
+*   - doesn't need Pythia or FastJet                                            *
+********************************************************************************/
+
+// Inputs: socket, request (see FlipServer.h)
+//  For example:
+//  ./AskRPV flipeff.sock 400 900 8,6 events=5000
+//  ./AskRPV flipeff.sock 400 900 precision=0.05
+//  ./AskRPV flipeff.sock status
+//  or a whole list of points:
+//  ./AskRPV flipeff.sock < points.txt
+// It waits for a done or error line for every point it sent (one status
+//  line for status or shutdown), so it can be used from a script.
+
+
+
+#include <sys/socket.h>             // socket, connect
+#include <sys/un.h>                 // sockaddr_un
+#include <unistd.h>                 // read, write, close
+#include <cstring>                  // strncpy, memset
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+static bool send_all(int fd, string line){
+    // The whole line, or false
+    size_t sent = 0;
+    while (sent < line.size()){
+        ssize_t n = write(fd, line.c_str() + sent, line.size() - sent);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+} // end send_all
+
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    string socketPath = "flipeff.sock";
+    if (argc > 1) socketPath = argv[1];
+
+    // the request on the command line, or every line of stdin
+    vector<string> requests;
+    if (argc > 2){
+        string request;
+        for (int iArg = 2; iArg < argc; iArg++)
+            request += (iArg > 2 ? " " : "") + string(argv[iArg]);
+        requests.push_back(request);
+    }
+    else {
+        string line;
+        while (getline(cin, line))
+            if ((line != "") && (line[0] != '#')) requests.push_back(line);
+    }
+
+
+    // CONNECT
+    // -------
+    struct sockaddr_un address;
+    if (socketPath.size() >= sizeof(address.sun_path)){
+        cout << "ERROR: socket path too long: " << socketPath << endl;
+        return 1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(),
+            sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((fd < 0) ||
+        connect(fd, (struct sockaddr*) &address, sizeof(address))){
+        cout << "ERROR: nothing listening on " << socketPath
+             << " (start ./ServeRPV first)" << endl;
+        return 1;
+    }
+
+
+    // ASK, THEN READ UNTIL EVERYTHING'S ANSWERED
+    // ------------------------------------------
+    int nWaiting = 0;
+    for (unsigned int i = 0; i < requests.size(); i++){
+        if (!send_all(fd, requests[i] + "\n")) break;
+        nWaiting++;
+    }
+
+    string pending;
+    char buffer[4096];
+    bool failed = false;
+    while (nWaiting > 0){
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        pending.append(buffer, n);
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != string::npos){
+            string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            cout << line << endl;
+            if ((line.compare(0, 5, "done ") == 0) ||
+                (line.compare(0, 7, "status ") == 0))
+                nWaiting--;
+            if (line.compare(0, 6, "error ") == 0){
+                nWaiting--;
+                failed = true;
+            }
+        }
+    }
+    close(fd);
+
+    if (nWaiting > 0){
+        cout << "ERROR: the server went away with " << nWaiting
+             << " requests unanswered" << endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+
+}
@@ -0,0 +1,262 @@
+/********************************************************************************
+*   FlipAdaptiveScan.cpp by Flip Tanedo (pt267@cornell.edu)                     *
+*   Adaptive scan for the RPV stop/gluino plane                                 *
+*   Only the cells that the exclusion contour passes through get refined:      *
+*   start on a coarse grid, split crossed cells in four, stop at fineStep.      *
+********************************************************************************/
+
+#include "FlipAdaptiveScan.h"
+
+
+void fill_scansettings(scansettings& settings){
+    // Default values, same files as PartonRPV.cc
+
+    settings.mstopMin       = 200.0;
+    settings.mstopMax       = 800.0;
+    settings.mgluMin        = 400.0;
+    settings.mgluMax        = 1400.0;
+    settings.coarseStep     = 200.0;
+    settings.fineStep       = 25.0;
+    settings.iSR            = 8;
+    settings.nLimit         = 3.0;      // 95% CL Poisson limit, 0 observed
+    settings.lumi           = 10.5;     // SUS-12-017
+    settings.prefactor      = 1.0;      // W BRs are in the event weights
+                                        //  now (FlipBias.h)
+    settings.cmndtemp       = "CmndTemp.cmnd";
+    settings.cmndrun        = "CommandRun.cmnd";
+    settings.spctemp        = "template.spc";
+    settings.spcint         = "intermediate.spc";
+    settings.spcRun         = "spcRun.spc";
+    settings.pointfile      = "adaptive.dat";
+    settings.contourfile    = "contour.dat";
+} // end fill_scansettings
+
+
+
+scanpoint run_scanpoint(double mstop, double mglu, scansettings& settings){
+    // Generates one point of the mass plane
+
+    scanpoint point;
+    point.mstop = mstop;
+    point.mglu  = mglu;
+
+    // masses go into the spectrum as strings
+    stringstream stopstream;
+    stringstream glustream;
+    stopstream << mstop;
+    glustream << mglu;
+    string mstopString = stopstream.str();
+    string mgluString  = glustream.str();
+
+    FixMassPoint(settings.cmndtemp, settings.cmndrun, settings.spctemp,
+                 settings.spcint, settings.spcRun, mstopString, mgluString);
+
+    vector< pair<string, int> > counts;
+    double sigma_mb = 0;
+    double eff = signal_efficiency_b(settings.cmndrun, counts,
+                                     settings.iSR, &sigma_mb);
+
+    point.efficiency = eff * settings.prefactor;
+    point.sigma      = sigma_mb * 1.0e9;            // mb -> pb
+    point.nSignal    = point.sigma * 1000.0 * settings.lumi * point.efficiency;
+    point.excluded   = (point.nSignal > settings.nLimit);
+
+    return point;
+} // end run_scanpoint
+
+
+
+scanpoint get_scanpoint(scannode node, scansettings& settings,
+                        map<scannode, scanpoint>& sampled){
+    // Only generate a point the first time somebody asks for it
+
+    map<scannode, scanpoint>::iterator found = sampled.find(node);
+    if (found != sampled.end()) return found->second;
+
+    double mstop = settings.mstopMin + node.first  * settings.fineStep;
+    double mglu  = settings.mgluMin  + node.second * settings.fineStep;
+
+    scanpoint point = run_scanpoint(mstop, mglu, settings);
+    sampled[node] = point;
+
+    return point;
+} // end get_scanpoint
+
+
+
+void refine_cell(   scannode corner,                    // lower left node
+                    int size,                           // in fine steps
+                    scansettings& settings,
+                    map<scannode, scanpoint>& sampled,  // points so far
+                    vector<scannode>& cells){           // finest crossed cells
+    // If the corners don't all agree on exclusion, the contour passes
+    //  through this cell: split it into four and try again.
+    // Note: a contour that enters and leaves through the same edge of a
+    //  coarse cell is invisible to this, so don't make coarseStep too big.
+
+    int i = corner.first;
+    int j = corner.second;
+
+    int nExcluded = 0;
+    if (get_scanpoint(scannode(i,      j     ), settings, sampled).excluded)
+        nExcluded++;
+    if (get_scanpoint(scannode(i+size, j     ), settings, sampled).excluded)
+        nExcluded++;
+    if (get_scanpoint(scannode(i,      j+size), settings, sampled).excluded)
+        nExcluded++;
+    if (get_scanpoint(scannode(i+size, j+size), settings, sampled).excluded)
+        nExcluded++;
+
+    if ((nExcluded == 0) || (nExcluded == 4)) return;   // no contour here
+
+    if (size == 1){                                     // as fine as it gets
+        cells.push_back(corner);
+        return;
+    }
+
+    int half = size/2;
+    refine_cell(scannode(i,      j     ), half, settings, sampled, cells);
+    refine_cell(scannode(i+half, j     ), half, settings, sampled, cells);
+    refine_cell(scannode(i,      j+half), half, settings, sampled, cells);
+    refine_cell(scannode(i+half, j+half), half, settings, sampled, cells);
+
+} // end refine_cell
+
+
+
+void contour_segments(  vector<scannode>& cells,
+                        scansettings& settings,
+                        map<scannode, scanpoint>& sampled,
+                        vector< vector<double> >& segments){
+    // Marching squares on the finest cells. The number of signal events
+    //  falls roughly exponentially with the masses, so we interpolate
+    //  log(nSignal/nLimit) along each edge rather than nSignal itself.
+
+    double nFloor = 1.0e-3 * settings.nLimit;   // nSignal can be zero
+
+    for (unsigned int iCell = 0; iCell < cells.size(); iCell++){
+
+        int i = cells[iCell].first;
+        int j = cells[iCell].second;
+
+        // corners, going around the cell counterclockwise
+        scannode nodes[4] = {   scannode(i,   j  ), scannode(i+1, j  ),
+                                scannode(i+1, j+1), scannode(i,   j+1) };
+        double f[4];
+        double x[4];
+        double y[4];
+        for (int k = 0; k < 4; k++){
+            scanpoint point = get_scanpoint(nodes[k], settings, sampled);
+            double n = (point.nSignal > nFloor) ? point.nSignal : nFloor;
+            f[k] = log(n / settings.nLimit);
+            x[k] = point.mstop;
+            y[k] = point.mglu;
+        }
+
+        // points where the contour crosses an edge
+        vector<double> crossings;
+        for (int k = 0; k < 4; k++){
+            int l = (k+1) % 4;
+            if ((f[k] > 0) == (f[l] > 0)) continue;
+            double t = f[k] / (f[k] - f[l]);
+            crossings.push_back(x[k] + t*(x[l] - x[k]));
+            crossings.push_back(y[k] + t*(y[l] - y[k]));
+        }
+
+        // two crossings make one segment; a saddle has four, i.e. two
+        for (unsigned int k = 0; k + 3 < crossings.size(); k += 4){
+            vector<double> segment(crossings.begin() + k,
+                                   crossings.begin() + k + 4);
+            segments.push_back(segment);
+        }
+    } // end loop over cells
+
+} // end contour_segments
+
+
+
+int adaptive_scan(scansettings& settings){
+    // Runs the adaptive scan and writes the output files
+
+    // The coarse step has to be a power of two times the fine step
+    // ------------------------------------------------------------
+    if (settings.fineStep <= 0) settings.fineStep = settings.coarseStep;
+    int levels = 0;
+    while ( (1 << (levels+1)) * settings.fineStep <= settings.coarseStep )
+        levels++;
+    int stride = (1 << levels);
+    settings.coarseStep = stride * settings.fineStep;
+
+    // number of coarse cells in each direction, rounding up
+    int nCoarseStop = int(ceil( (settings.mstopMax - settings.mstopMin)
+                                / settings.coarseStep - 1.0e-9 ));
+    int nCoarseGlu  = int(ceil( (settings.mgluMax - settings.mgluMin)
+                                / settings.coarseStep - 1.0e-9 ));
+    if (nCoarseStop < 1) nCoarseStop = 1;
+    if (nCoarseGlu  < 1) nCoarseGlu  = 1;
+    settings.mstopMax = settings.mstopMin + nCoarseStop * settings.coarseStep;
+    settings.mgluMax  = settings.mgluMin  + nCoarseGlu  * settings.coarseStep;
+
+
+    // Refine every coarse cell
+    // ------------------------
+    map<scannode, scanpoint> sampled;
+    vector<scannode> cells;
+
+    for (int iStop = 0; iStop < nCoarseStop; iStop++)
+        for (int iGlu = 0; iGlu < nCoarseGlu; iGlu++)
+            refine_cell(scannode(iStop*stride, iGlu*stride), stride,
+                        settings, sampled, cells);
+
+    vector< vector<double> > segments;
+    contour_segments(cells, settings, sampled, segments);
+
+
+    // OUTPUT FILE STREAMS
+    // -------------------
+    ofstream pointstream;
+    pointstream.open(settings.pointfile.c_str());
+    pointstream.precision(6);
+    pointstream.setf(ios::fixed);
+    pointstream.setf(ios::showpoint);
+
+    pointstream << "# mstop \t mglu \t SR \t efficiency \t sigma(pb) \t"
+                << " nSignal \t excluded" << endl;
+    for (map<scannode, scanpoint>::iterator it = sampled.begin();
+         it != sampled.end(); it++){
+        scanpoint& point = it->second;
+        pointstream << point.mstop << "\t" << point.mglu << "\t"
+                    << settings.iSR << "\t" << point.efficiency << "\t"
+                    << point.sigma << "\t" << point.nSignal << "\t"
+                    << point.excluded << endl;
+    }
+    pointstream.close();
+
+    // one segment per line, blank lines in between so gnuplot
+    //  draws them as separate pieces
+    ofstream contourstream;
+    contourstream.open(settings.contourfile.c_str());
+    contourstream.precision(2);
+    contourstream.setf(ios::fixed);
+    for (unsigned int iSeg = 0; iSeg < segments.size(); iSeg++){
+        contourstream << segments[iSeg][0] << "\t" << segments[iSeg][1] << endl;
+        contourstream << segments[iSeg][2] << "\t" << segments[iSeg][3] << endl;
+        contourstream << endl;
+    }
+    contourstream.close();
+
+
+    // How much did we save?
+    // ---------------------
+    int nUniform = (nCoarseStop*stride + 1) * (nCoarseGlu*stride + 1);
+
+    cout << endl << endl << "ADAPTIVE SCAN, Signal Region " << settings.iSR
+         << endl;
+    cout << "Points generated: " << sampled.size() << endl;
+    cout << "Uniform grid at " << settings.fineStep << " GeV: "
+         << nUniform << endl;
+    cout << "Contour cells: " << cells.size() << endl;
+
+    return sampled.size();
+
+} // end adaptive_scan
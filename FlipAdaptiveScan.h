@@ -0,0 +1,78 @@
+// FlipAdaptiveScan.h
+// Adaptive scan of the (mstop, mglu) plane around the exclusion contour
+// INCLUDE GUARD
+#ifndef __FLIPADAPTIVESCAN_H_INCLUDED__
+#define __FLIPADAPTIVESCAN_H_INCLUDED__
+
+#include "FlipEfficiency.h"             // signal_efficiency_b
+#include "FlipCommandFileFixer.h"       // FixMassPoint
+#include <map>                          // cache of sampled points
+using namespace std;
+
+struct scanpoint{
+    // one sampled point of the mass plane
+    double mstop;
+    double mglu;
+    double efficiency;      // times the prefactor
+    double sigma;           // generated cross section in pb
+    double nSignal;         // expected signal events in the signal region
+    bool excluded;          // nSignal is above the upper limit
+};
+
+struct scansettings{
+    // everything the adaptive scan needs to know
+    double mstopMin;        // lower edge of the scan in mstop (GeV)
+    double mstopMax;        // upper edge, rounded up to a whole coarse cell
+    double mgluMin;         // same for the gluino
+    double mgluMax;
+    double coarseStep;      // starting grid spacing (GeV)
+    double fineStep;        // target resolution (GeV)
+    int iSR;                // signal region, as in SUS-12-017
+    double nLimit;          // 95% CL upper limit on signal events in iSR
+    double lumi;            // integrated luminosity in fb^-1
+    double prefactor;       // overall factor on the efficiency (1: the W
+                            //  BRs are in the event weights, FlipBias.h)
+    string cmndtemp;        // command file template
+    string cmndrun;         // command file written for each point
+    string spctemp;         // spectrum template
+    string spcint;          // intermediate spectrum
+    string spcRun;          // spectrum written for each point
+    string pointfile;       // every sampled point goes here
+    string contourfile;     // contour segments go here
+};
+
+typedef pair<int, int> scannode;
+    // grid node in units of the fine step: (i, j) sits at
+    // mstop = mstopMin + i*fineStep, mglu = mgluMin + j*fineStep
+
+void fill_scansettings(scansettings&);
+    // Default settings: SR8 at 10.5 fb^-1 with a zero-background limit
+
+scanpoint run_scanpoint(double, double, scansettings&);
+    // Templates the cmnd/spc files for (mstop, mglu), runs
+    // signal_efficiency_b and converts the result into expected events
+
+scanpoint get_scanpoint(scannode, scansettings&, map<scannode, scanpoint>&);
+    // Looks a node up in the cache of sampled points, running it if needed
+
+void refine_cell(scannode, int, scansettings&,
+                    map<scannode, scanpoint>&, vector<scannode>&);
+    // Inputs: lower left node, cell size (in fine steps), settings,
+    //  cache of sampled points, list of finest cells the contour crosses
+    // Recursively splits the cell into four if the corners disagree
+    //  about exclusion, until the cell is one fine step wide
+
+void contour_segments(vector<scannode>&, scansettings&,
+                        map<scannode, scanpoint>&,
+                        vector< vector<double> >&);
+    // Marching squares over the finest cells: each segment is
+    //  (mstop1, mglu1, mstop2, mglu2), interpolated in log(nSignal)
+
+int adaptive_scan(scansettings&);
+    // The whole thing: coarse grid, refinement, output files
+    // Returns the number of points that were generated
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPADAPTIVESCAN_H_INCLUDED__
@@ -0,0 +1,330 @@
+/********************************************************************************
+*   FlipBatch.cpp by Flip Tanedo (pt267@cornell.edu)                            *
+*   The selection of select_event, one cut stage at a time across a batch       *
+*   of events stored column by column. Each stage only touches the events       *
+*   that are still alive, rolls the same per-event dice as select_event, and    *
+*   calls the same helpers on plain numbers, so the result is identical.        *
+********************************************************************************/
+
+#include "FlipBatch.h"
+
+
+void clear_batch(flipbatch& batch){
+    // clear() keeps the capacity, so after the first batch nothing
+    //  gets allocated any more
+
+    batch.nEvents = 0;
+    batch.iEvent.clear();
+    batch.weight.clear();
+    batch.MET.clear();
+    batch.HT.clear();
+    batch.lepBegin.assign(1, 0);
+    batch.jetBegin.assign(1, 0);
+    batch.bBegin.assign(1, 0);
+    batch.lepID.clear();
+    batch.lepPt.clear();
+    batch.lepEta.clear();
+    batch.lepPhi.clear();
+    batch.jetPt.clear();
+    batch.jetEta.clear();
+    batch.jetPhi.clear();
+    batch.bPt.clear();
+} // end clear_batch
+
+
+
+void add_to_batch(flipbatch& batch, flipevent& record){
+    // Appends one event to the columns
+
+    if (batch.lepBegin.empty()) clear_batch(batch);
+
+    batch.iEvent.push_back(record.iEvent);
+    batch.weight.push_back(record.weight);
+    batch.MET.push_back(record.METvec.pt());
+    batch.HT.push_back(record.HT);
+
+    for (unsigned int iLep = 0; iLep < record.preleptons.size(); iLep++){
+        fastjet::PseudoJet& momentum = record.preleptons[iLep].second;
+        batch.lepID.push_back(record.preleptons[iLep].first);
+        batch.lepPt.push_back(momentum.pt());
+        batch.lepEta.push_back(momentum.eta());
+        batch.lepPhi.push_back(momentum.phi());
+    }
+
+    for (unsigned int iJet = 0; iJet < record.prepartons.size(); iJet++){
+        fastjet::PseudoJet& momentum = record.prepartons[iJet].second;
+        batch.jetPt.push_back(momentum.pt());
+        batch.jetEta.push_back(momentum.eta());
+        batch.jetPhi.push_back(momentum.phi());
+    }
+
+    for (unsigned int iJet = 0; iJet < record.bpartons.size(); iJet++)
+        batch.bPt.push_back(record.bpartons[iJet].second.pt());
+
+    batch.lepBegin.push_back(batch.lepID.size());
+    batch.jetBegin.push_back(batch.jetPt.size());
+    batch.bBegin.push_back(batch.bPt.size());
+    batch.nEvents++;
+} // end add_to_batch
+
+
+
+/********************************************************************************
+*   The cut stages. Each one loops over the events still alive.                 *
+********************************************************************************/
+
+static void pass_stage(flipbatch& batch, int k, int stage,
+                       flipcounts& stagecounts){
+    // Event k got past the stage: the cutflow, and how far it got
+    count_stage(stagecounts, stage, batch.weight[k]);
+    batch.passed[k] = stage;
+} // end pass_stage
+
+
+
+static void stage_lepton_kinematics(flipbatch& batch, const effparams& params,
+                                    flipcounts& stagecounts){
+    // >1 lepton passes the kinematic cuts
+
+    for (int k = 0; k < batch.nEvents; k++){
+        int count = 0;
+        for (int i = batch.lepBegin[k]; i < batch.lepBegin[k+1]; i++){
+            bool pass = lepton_kinematic_cut(batch.lepID[i], batch.lepPt[i],
+                                             batch.lepEta[i], params);
+            batch.lepPass[i] = pass;
+            if (pass) batch.lepStage[i] = cutKinematic;
+            count += pass;
+        }
+        batch.nLep[k] = count;
+        if (count > 1) pass_stage(batch, k, cutKinematic, stagecounts);
+        else batch.alive[k] = 0;
+    }
+} // end stage_lepton_kinematics
+
+
+
+static void stage_jet_kinematics(flipbatch& batch, const effparams& params){
+    // no cut here, just which partons count as jets
+
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+        int count = 0;
+        for (int j = batch.jetBegin[k]; j < batch.jetBegin[k+1]; j++){
+            bool pass = jet_kinematic_cut(batch.jetPt[j], batch.jetEta[j],
+                                          params);
+            batch.jetPass[j] = pass;
+            count += pass;
+        }
+        batch.nJet[k] = count;
+    }
+} // end stage_jet_kinematics
+
+
+
+static void stage_lepton_ID(flipbatch& batch, const effparams& params,
+                            unsigned int seed, flipcounts& stagecounts){
+    // >1 lepton passes ID
+
+    flipdice dice;
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+        seed_dice(dice, seed, batch.iEvent[k], cutLepID);
+        int count = 0;
+        for (int i = batch.lepBegin[k]; i < batch.lepBegin[k+1]; i++){
+            double roll = roll_dice(dice);  // every lepton, as cutLepID
+            if (!batch.lepPass[i]) continue;
+            bool pass = lepton_ID_eff(batch.lepID[i], roll, params);
+            batch.lepPass[i] = pass;
+            if (pass) batch.lepStage[i] = cutLepID;
+            count += pass;
+        }
+        batch.nLep[k] = count;
+        if (count > 1) pass_stage(batch, k, cutLepID, stagecounts);
+        else batch.alive[k] = 0;
+    }
+} // end stage_lepton_ID
+
+
+
+static void stage_lepton_iso(flipbatch& batch, const effparams& params,
+                             flipcounts& stagecounts){
+    // >1 lepton is isolated from the jets
+
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+        int count = 0;
+        for (int i = batch.lepBegin[k]; i < batch.lepBegin[k+1]; i++){
+            if (!batch.lepPass[i]) continue;
+            double cone_pT = 0;
+            for (int j = batch.jetBegin[k]; j < batch.jetBegin[k+1]; j++){
+                if (!batch.jetPass[j]) continue;
+                if (get_deltaR(batch.lepEta[i], batch.lepPhi[i],
+                               batch.jetEta[j], batch.jetPhi[j])
+                    < params.lepton_dR)
+                    cone_pT += batch.jetPt[j];
+            }
+            bool pass = lepton_iso_eff(batch.lepPt[i], cone_pT, params);
+            batch.lepPass[i] = pass;
+            if (pass) batch.lepStage[i] = cutLepIso;
+            count += pass;
+        }
+        batch.nLep[k] = count;
+        if (count > 1) pass_stage(batch, k, cutLepIso, stagecounts);
+        else batch.alive[k] = 0;
+    }
+} // end stage_lepton_iso
+
+
+
+static void stage_btag(flipbatch& batch, const effparams& params,
+                       unsigned int seed, flipcounts& stagecounts){
+    // >1 b tagged
+
+    flipdice dice;
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+        seed_dice(dice, seed, batch.iEvent[k], cutbTag);
+        int count = 0;
+        for (int b = batch.bBegin[k]; b < batch.bBegin[k+1]; b++)
+            count += b_selection_efficiency(batch.bPt[b], roll_dice(dice),
+                                            params);
+        batch.nbTag[k] = count;
+        if (count > 1) pass_stage(batch, k, cutbTag, stagecounts);
+        else batch.alive[k] = 0;
+    }
+} // end stage_btag
+
+
+
+static void stage_dilepton(flipbatch& batch, const effparams& params,
+                           unsigned int seed, flipcounts& stagecounts){
+    // exactly two leptons, the trigger, same sign
+
+    flipdice dice;
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+
+        if (batch.nLep[k] != 2){
+            batch.alive[k] = 0;
+            continue;
+        }
+        pass_stage(batch, k, cutDilepton, stagecounts);
+
+        // which two
+        batch.lep0[k] = -1;
+        batch.lep1[k] = -1;
+        for (int i = batch.lepBegin[k]; i < batch.lepBegin[k+1]; i++){
+            if (!batch.lepPass[i]) continue;
+            if (batch.lep0[k] < 0) batch.lep0[k] = i;
+            else batch.lep1[k] = i;
+        }
+        int id0 = batch.lepID[batch.lep0[k]];
+        int id1 = batch.lepID[batch.lep1[k]];
+
+        // passing the trigger fails the event, as in select_event
+        seed_dice(dice, seed, batch.iEvent[k], cutDilepTrig);
+        if (lepton_trig_efficiency(batch.nLep[k], id0, roll_dice(dice),
+                                   params)){
+            batch.alive[k] = 0;
+            continue;
+        }
+        pass_stage(batch, k, cutDilepTrig, stagecounts);
+
+        if (id0/abs(id0) != id1/abs(id1)){
+            batch.alive[k] = 0;
+            continue;
+        }
+        pass_stage(batch, k, cutSS2L, stagecounts);
+    }
+} // end stage_dilepton
+
+
+
+static void stage_signalregion(flipbatch& batch, signalregion& region,
+                               const effparams& params, unsigned int seed,
+                               flipcounts& stagecounts){
+    // the SR tail: jets, b jets, MET, HT, charge
+
+    flipdice dice;
+    for (int k = 0; k < batch.nEvents; k++){
+        if (!batch.alive[k]) continue;
+        batch.alive[k] = 0;
+
+        if (batch.nJet[k] < int(region.minJets)) continue;
+        pass_stage(batch, k, cutJets, stagecounts);
+
+        if (batch.nbTag[k] < int(region.minbJets)) continue;
+        pass_stage(batch, k, cutbJets, stagecounts);
+
+        seed_dice(dice, seed, batch.iEvent[k], cutMET);
+        if (!METefficiency(batch.MET[k], region.minMET, roll_dice(dice),
+                           params)) continue;
+        pass_stage(batch, k, cutMET, stagecounts);
+
+        seed_dice(dice, seed, batch.iEvent[k], cutHT);
+        if (!HTefficiency(batch.HT[k], region.minHT, roll_dice(dice),
+                          params)) continue;
+        pass_stage(batch, k, cutHT, stagecounts);
+
+        int id0 = batch.lepID[batch.lep0[k]];
+        bool minmin = (id0 > 0) && region.minusminus;
+        bool pluplu = (id0 < 0) && region.plusplus;
+        if (!(minmin || pluplu)) continue;
+        pass_stage(batch, k, cutCharge, stagecounts);
+
+        batch.alive[k] = 1;
+    }
+} // end stage_signalregion
+
+
+
+int select_batch(   flipbatch& batch,           // events, column by column
+                    signalregion& region,       // cuts for this SR
+                    const effparams& params,    // detector numbers
+                    unsigned int seed,          // run seed for the dice
+                    flipcounts& stagecounts){   // cutflow
+    // Runs the stages in the order of select_event
+
+    int nLeptons = batch.lepID.size();
+    int nPartons = batch.jetPt.size();
+
+    batch.lepPass.assign(nLeptons, 0);
+    batch.lepStage.assign(nLeptons, cutGenerated);
+    batch.jetPass.assign(nPartons, 0);
+    batch.alive.assign(batch.nEvents, 1);
+    batch.passed.assign(batch.nEvents, cutGenerated);
+    batch.nLep.assign(batch.nEvents, 0);
+    batch.nJet.assign(batch.nEvents, 0);
+    batch.nbTag.assign(batch.nEvents, 0);
+    batch.lep0.assign(batch.nEvents, -1);
+    batch.lep1.assign(batch.nEvents, -1);
+
+    for (int k = 0; k < batch.nEvents; k++)
+        pass_stage(batch, k, cutGenerated, stagecounts);
+
+    stage_lepton_kinematics(batch, params, stagecounts);
+    stage_jet_kinematics(batch, params);
+    stage_lepton_ID(batch, params, seed, stagecounts);
+    stage_lepton_iso(batch, params, stagecounts);
+    stage_btag(batch, params, seed, stagecounts);
+    stage_dilepton(batch, params, seed, stagecounts);
+    stage_signalregion(batch, region, params, seed, stagecounts);
+
+    int nPassed = 0;
+    for (int k = 0; k < batch.nEvents; k++) nPassed += batch.alive[k];
+    return nPassed;
+} // end select_batch
+
+
+
+int check_batch(flipbatch& batch, vector<bool>& decisions){
+    // How many events did the batch and the per-event path disagree on?
+
+    int nMismatch = 0;
+    for (int k = 0; k < batch.nEvents; k++){
+        bool passed = (k < int(decisions.size())) && decisions[k];
+        if (passed != bool(batch.alive[k])) nMismatch++;
+    }
+    decisions.clear();
+    return nMismatch;
+} // end check_batch
@@ -0,0 +1,75 @@
+// FlipBatch.h
+// Columnar batches of events for the selection
+// INCLUDE GUARD
+#ifndef __FLIPBATCH_H_INCLUDED__
+#define __FLIPBATCH_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+struct flipbatch{
+    // K events' visible final states, one array per quantity.
+    // The objects of event k are [lepBegin[k], lepBegin[k+1]) etc.
+    // Each cut stage runs over the whole batch before the next one starts,
+    //  so its code and the columns it reads stay in cache.
+    int nEvents;
+
+    // one entry per event
+    vector<int> iEvent;             // for the dice
+    vector<double> weight;          // for the cutflow
+    vector<double> MET;
+    vector<double> HT;
+    vector<int> lepBegin;           // nEvents+1 offsets
+    vector<int> jetBegin;
+    vector<int> bBegin;
+
+    // one entry per lepton (preleptons)
+    vector<int> lepID;
+    vector<double> lepPt;
+    vector<double> lepEta;
+    vector<double> lepPhi;
+
+    // one entry per parton (prepartons, i.e. jet candidates)
+    vector<double> jetPt;
+    vector<double> jetEta;
+    vector<double> jetPhi;
+
+    // one entry per b-tag candidate (bpartons)
+    vector<double> bPt;
+
+    // what the stages have decided so far
+    vector<unsigned char> lepPass;  // lepton is still in the list
+    vector<int> lepStage;           // last lepton stage it passed
+    vector<unsigned char> jetPass;  // parton passes the jet kinematics
+    vector<unsigned char> alive;    // event hasn't failed anything yet
+    vector<int> passed;             // last cutstage passed (state.passed)
+    vector<int> nLep;               // leptons still in the list
+    vector<int> nJet;               // partons passing the jet kinematics
+    vector<int> nbTag;              // tagged b's
+    vector<int> lep0;               // first two leptons still in the list
+    vector<int> lep1;
+};
+
+void clear_batch(flipbatch&);
+    // Empties the batch but keeps the memory
+
+void add_to_batch(flipbatch&, flipevent&);
+    // Appends one event (from fill_event) to the columns
+
+int select_batch(flipbatch&, signalregion&, const effparams&,
+                 unsigned int, flipcounts&);
+    // Inputs: batch, signal region, parameters, run seed, cutflow
+    // Runs every cut stage across the batch, in the same order as
+    //  select_event and with the same dice. Afterwards alive[k] says
+    //  whether event k passed and passed[k] how far it got (lepStage
+    //  the same for each lepton, for fill_batch_histos in FlipHisto.h).
+    //  Returns the number that passed.
+
+int check_batch(flipbatch&, vector<bool>&);
+    // Compares alive[] with the per-event decisions in the vector and
+    //  empties the vector. Returns the number of events that disagree.
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPBATCH_H_INCLUDED__
@@ -0,0 +1,174 @@
+/********************************************************************************
+*   FlipBias.cpp by Flip Tanedo (pt267@cornell.edu)                             *
+*   Decay-channel biasing: force the decays that can give same-sign leptons     *
+*   and keep track of what that did to each event's probability, instead of     *
+*   multiplying by a hard-coded branching ratio at the end.                     *
+********************************************************************************/
+
+#include "FlipBias.h"
+#include <algorithm>                  // replace
+
+
+bool read_bias(flipbias& bias, string declaration){
+    // id:product,product;id:product...
+
+    bias.ids.clear();
+    bias.products.clear();
+    bias.weightParticle.clear();
+    bias.weightAntiparticle.clear();
+    bias.sumInverseOpen = 0;
+    bias.nOpen = 0;
+
+    if ((declaration == "") || (declaration == "none")) return true;
+
+    // commas to spaces, so the products can be read with a stringstream
+    //  and handed to Pythia as they are
+    replace(declaration.begin(), declaration.end(), ',', ' ');
+
+    stringstream forced(declaration);
+    string particle;
+    while (getline(forced, particle, ';')){
+        size_t colon = particle.find(':');
+        int id = atoi(particle.substr(0, colon).c_str());
+        string products =
+            (colon == string::npos) ? "" : particle.substr(colon+1);
+
+        int product = 0;
+        stringstream check(products);
+        if ((id <= 0) || !(check >> product)){
+            cout << endl << "ERROR: can't read force=" << declaration
+                 << ", not forcing any decays" << endl;
+            bias.ids.clear();
+            bias.products.clear();
+            return false;
+        }
+
+        bias.ids.push_back(id);
+        bias.products.push_back(products);
+    }
+    return true;
+} // end read_bias
+
+
+
+void apply_bias(flipbias& bias, Pythia8::Pythia& pythia){
+    // Only channels with one of the products stay on
+
+    for (unsigned int i = 0; i < bias.ids.size(); i++){
+        stringstream onMode;
+        onMode << bias.ids[i] << ":onMode = off";
+        pythia.readString(onMode.str());
+
+        stringstream onIfAny;
+        onIfAny << bias.ids[i] << ":onIfAny = " << bias.products[i];
+        pythia.readString(onIfAny.str());
+    }
+} // end apply_bias
+
+
+
+void fill_bias_weights(flipbias& bias, Pythia8::Pythia& pythia){
+    // Sum of BRs still on over sum of all BRs, separately for the
+    //  particle (onMode 1 or 2) and the antiparticle (onMode 1 or 3)
+
+    bias.weightParticle.assign(bias.ids.size(), 1.0);
+    bias.weightAntiparticle.assign(bias.ids.size(), 1.0);
+
+    for (unsigned int i = 0; i < bias.ids.size(); i++){
+        Pythia8::ParticleDataEntry* entry =
+            pythia.particleData.particleDataEntryPtr(bias.ids[i]);
+        if (!entry) continue;
+
+        double total = 0;
+        double onParticle = 0;
+        double onAntiparticle = 0;
+        for (int iChannel = 0; iChannel < entry->sizeChannels(); iChannel++){
+            Pythia8::DecayChannel& channel = entry->channel(iChannel);
+            total += channel.bRatio();
+            if ((channel.onMode() == 1) || (channel.onMode() == 2))
+                onParticle += channel.bRatio();
+            if ((channel.onMode() == 1) || (channel.onMode() == 3))
+                onAntiparticle += channel.bRatio();
+        }
+
+        if (total <= 0) continue;
+        bias.weightParticle[i]      = onParticle / total;
+        bias.weightAntiparticle[i]  = onAntiparticle / total;
+
+        if ((bias.weightParticle[i] > 0.999) &&
+            (bias.weightAntiparticle[i] > 0.999))
+            cout << endl << "WARNING: forcing " << bias.ids[i] << " decays"
+                 << " leaves every channel on. If the command file already"
+                 << " forces them (oneChannel), the real branching ratios"
+                 << " are gone and the weights are wrong." << endl;
+    }
+} // end fill_bias_weights
+
+
+
+double event_weight(flipbias& bias, Pythia8::Event& process){
+    // Every forced particle in the hard process that decayed into
+    //  something other than a copy of itself
+
+    double weight = 1.0;
+    if (bias.ids.empty()) return weight;
+
+    for (int iPart = 0; iPart < process.size(); iPart++){
+        int id = process[iPart].id();
+        int daughter = process[iPart].daughter1();
+        if (daughter <= 0) continue;
+        if (process[daughter].id() == id) continue;
+
+        for (unsigned int i = 0; i < bias.ids.size(); i++){
+            if (id == bias.ids[i])  weight *= bias.weightParticle[i];
+            if (id == -bias.ids[i]) weight *= bias.weightAntiparticle[i];
+        }
+    }
+    return weight;
+} // end event_weight
+
+
+
+void count_open_fraction(flipbias& bias, Pythia8::Pythia& pythia){
+    // The outgoing particles of the hard process are the ones with the
+    //  incoming partons (3, 4) as mothers
+
+    bias.nOpen++;
+    if (bias.ids.empty() || pythia.info.isLHA()){
+        bias.sumInverseOpen += 1.0;
+        return;
+    }
+
+    Pythia8::Event& process = pythia.process;
+    double open = 1.0;
+    for (int iPart = 5; iPart < process.size(); iPart++)
+        if (process[iPart].mother1() == 3)
+            open *= pythia.particleData.resOpenFrac(process[iPart].id());
+    bias.sumInverseOpen += (open > 0) ? 1.0 / open : 1.0;
+} // end count_open_fraction
+
+
+
+double unforced_sigma(flipbias& bias, double sigma){
+    // sigmaGen * <1/f>
+
+    if (bias.nOpen == 0) return sigma;
+    return sigma * bias.sumInverseOpen / bias.nOpen;
+} // end unforced_sigma
+
+
+
+void report_bias(flipbias& bias){
+    // e.g. "Forced 24 -> 11 13 15: weight 0.3257 (+), 0.3257 (-)"
+
+    for (unsigned int i = 0; i < bias.ids.size(); i++){
+        cout << "Forced " << bias.ids[i] << " -> " << bias.products[i]
+             << ": weight " << bias.weightParticle[i] << " (particle), "
+             << bias.weightAntiparticle[i] << " (antiparticle) per decay"
+             << endl;
+    }
+    if ((bias.nOpen > 0) && !bias.ids.empty())
+        cout << "Open fraction Pythia took off the cross section: "
+             << bias.nOpen / bias.sumInverseOpen << " on average, put back"
+             << endl;
+} // end report_bias
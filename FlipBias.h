@@ -0,0 +1,70 @@
+// FlipBias.h
+// Forced decays with the right weights: declare which decay products a
+//  particle is allowed to go to, and every event gets the probability of
+//  its forced decays under the real branching ratios as its weight
+// INCLUDE GUARD
+#ifndef __FLIPBIAS_H_INCLUDED__
+#define __FLIPBIAS_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+using namespace std;
+
+struct flipbias{
+    // Declared on the command line as force=id:product,product;id:...
+    //  e.g. force=24:11,13,15 (W -> e nu, mu nu, tau nu only), which is
+    //  what the command files used to do with 24:oneChannel/addChannel.
+    // Pythia then only picks the channels with one of those products in
+    //  them, but keeps the real branching ratios for them. A particle
+    //  that decays this way has weight (sum of the BRs left on) / (sum of
+    //  all BRs), whichever channel it took; the event weight is the
+    //  product over all forced decays in the event.
+    // Events that would have decayed some other way are taken to fail the
+    //  selection, just like the old 0.10608 = 0.3257^2 assumed.
+    // Switching channels off has Pythia take them off the cross section as
+    //  well: each of its own processes multiplies sigmaHat by the open
+    //  fractions of its outgoing resonances, which take in the decays
+    //  further down (gluino -> t -> W). With the BRs in the weights that
+    //  counts them twice, so sigmaGen is divided by it again: sigmaGen is
+    //  sum_i sigma_i f_i and events come in that proportion, so the
+    //  unforced cross section is sigmaGen times the mean of 1/f over the
+    //  events. LHE input (production=, the backgrounds) has the file's
+    //  cross section and nothing to undo; oneChannel never had any.
+    vector<int> ids;                        // forced particles (> 0)
+    vector<string> products;                // for onIfAny, space separated
+    vector<double> weightParticle;          // weight per decay of id ...
+    vector<double> weightAntiparticle;      // ... and of -id
+    double sumInverseOpen;                  // sum of 1/f over the events
+    int nOpen;                              // ... and how many
+};
+
+
+bool read_bias(flipbias&, string);
+    // Parses "24:11,13,15;6:5"; "" or "none" means nothing is forced.
+    // Returns false (and forces nothing) if it doesn't make sense
+
+void apply_bias(flipbias&, Pythia8::Pythia&);
+    // Switches the other channels off. Call before pythia.init()
+
+void fill_bias_weights(flipbias&, Pythia8::Pythia&);
+    // Works out the weight per decay. Call after pythia.init(), once
+    //  the SLHA decay tables are in
+
+double event_weight(flipbias&, Pythia8::Event&);
+    // Product of the weights of the forced decays in pythia.process
+
+void count_open_fraction(flipbias&, Pythia8::Pythia&);
+    // Inputs: bias, pythia (the event just made, vetoed ones too)
+    // Adds 1/f for it: f is the product of resOpenFrac of the outgoing
+    //  particles of the hard process, 1 with nothing forced or LHE input
+
+double unforced_sigma(flipbias&, double);
+    // Inputs: bias, Pythia's sigmaGen (or sigmaErr)
+    // Times the mean of 1/f: the cross section as if nothing was forced
+
+void report_bias(flipbias&);
+    // Prints the weight per decay of every forced particle
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPBIAS_H_INCLUDED__
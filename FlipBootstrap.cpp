@@ -0,0 +1,143 @@
+/********************************************************************************
+*   FlipBootstrap.cpp by Flip Tanedo (pt267@cornell.edu)                        *
+*   Replays the selection on stored events with new dice, R times, to get      *
+*   the spread of the efficiency without generating the events R times.         *
+*   The dice of replica r come from the run seed and r, see FlipBootstrap.h.    *
+********************************************************************************/
+
+#include "FlipBootstrap.h"
+#include <cmath>                        // exp, sqrt
+
+
+static int roll_poisson(flipdice& dice){
+    // Poisson(1) by adding up the probabilities until they pass the dice
+
+    double u = roll_dice(dice);
+    double p = exp(-1.0);
+    double sum = p;
+    int k = 0;
+    while ((u > sum) && (k < 20)){
+        k++;
+        p /= k;
+        sum += p;
+    }
+    return k;
+} // end roll_poisson
+
+
+
+static void mean_and_spread(vector<double>& values, double& mean,
+                            double& spread){
+    // Average and (sample) standard deviation
+
+    mean = 0;
+    spread = 0;
+    if (values.empty()) return;
+
+    for (unsigned int i = 0; i < values.size(); i++) mean += values[i];
+    mean /= values.size();
+
+    if (values.size() < 2) return;
+    for (unsigned int i = 0; i < values.size(); i++)
+        spread += (values[i] - mean) * (values[i] - mean);
+    spread = sqrt(spread / (values.size() - 1));
+} // end mean_and_spread
+
+
+
+void fill_bootstrap(flipbootstrap& bootstrap, int nReplicas, int isoGrid){
+    // Nothing stored or replayed yet
+
+    bootstrap.nReplicas = (nReplicas > 0) ? nReplicas : 0;
+    bootstrap.isoGrid   = isoGrid;
+    bootstrap.copies    = 1;
+    bootstrap.events.clear();
+    bootstrap.diceEfficiency.clear();
+    bootstrap.efficiency.clear();
+} // end fill_bootstrap
+
+
+
+void keep_event(flipbootstrap& bootstrap, flipevent& record){
+    // A copy: the record itself gets refilled by the next event
+
+    if (bootstrap.nReplicas > 0) bootstrap.events.push_back(record);
+} // end keep_event
+
+
+
+void run_bootstrap(flipbootstrap& bootstrap, signalregion& region,
+                   const effparams& params, unsigned int seed, int nEvent){
+    // Replica r: select_event with seed r, each event counted Poisson(1)
+    //  times for the bootstrap
+
+    bootstrap.diceEfficiency.assign(bootstrap.nReplicas, 0.0);
+    bootstrap.efficiency.assign(bootstrap.nReplicas, 0.0);
+    if (nEvent <= 0) return;
+
+    // Events that didn't come out of Pythia (aborts) still count in
+    //  nEvent, as failed, once each
+    int nMissing = nEvent - bootstrap.events.size();
+
+    flipstate state;
+    fill_state(state, bootstrap.isoGrid);
+    flipcounts stagecounts;
+    flipdice dice;
+
+    for (int iReplica = 0; iReplica < bootstrap.nReplicas; iReplica++){
+
+        // The replica's seed, well away from the run seed
+        seed_dice(dice, seed, iReplica + 1, nCutStages);
+        unsigned int replicaSeed = dice.state;
+
+        double weightPassed = 0;        // new dice
+        double weightResampled = 0;     // new dice, Poisson(1) copies
+        double nResampled = nMissing;   // # events in the resample
+
+        clear_counts(stagecounts);
+        for (unsigned int i = 0; i < bootstrap.events.size(); i++){
+            flipevent& record = bootstrap.events[i];
+
+            // one stream past the cut stages is the event's resampling
+            //  (its pair's, with cascade=)
+            seed_dice(dice, replicaSeed, record.iEvent / bootstrap.copies,
+                      nCutStages);
+            int copies = roll_poisson(dice);
+            nResampled += copies;
+
+            if (!select_event(record, region, params, replicaSeed, state,
+                              stagecounts))
+                continue;
+            weightPassed += record.weight;
+            weightResampled += copies * record.weight;
+        }
+
+        bootstrap.diceEfficiency[iReplica] = weightPassed / double(nEvent);
+        if (nResampled > 0)
+            bootstrap.efficiency[iReplica] = weightResampled / nResampled;
+    }
+} // end run_bootstrap
+
+
+
+void report_bootstrap(flipbootstrap& bootstrap, double efficiency){
+    // e.g. "Bootstrap, 100 replicas of 10000 events:"
+
+    if (bootstrap.nReplicas == 0) return;
+
+    double diceMean, diceSpread, mean, spread;
+    mean_and_spread(bootstrap.diceEfficiency, diceMean, diceSpread);
+    mean_and_spread(bootstrap.efficiency, mean, spread);
+
+    // The run's own dice are one more replica
+    double combined = (efficiency + bootstrap.nReplicas * diceMean)
+                    / (bootstrap.nReplicas + 1);
+
+    cout << "Bootstrap, " << bootstrap.nReplicas << " replicas of "
+         << bootstrap.events.size() << " events:" << endl;
+    cout << "  Averaged over the dice: " << combined << " +- "
+         << diceSpread / sqrt(bootstrap.nReplicas + 1.0) << endl;
+    cout << "  Spread from the dice alone: " << diceSpread << endl;
+    cout << "  Spread from dice and events (uncertainty of one run): "
+         << spread << " (replica average " << mean << ")" << endl;
+} // end report_bootstrap
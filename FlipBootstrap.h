@@ -0,0 +1,61 @@
+// FlipBootstrap.h
+// Statistical uncertainty of the efficiency from one generation pass:
+//  keep every event record and replay the selection with fresh dice
+// INCLUDE GUARD
+#ifndef __FLIPBOOTSTRAP_H_INCLUDED__
+#define __FLIPBOOTSTRAP_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+struct flipbootstrap{
+    // The kinematics of an event only depend on Pythia; everything random
+    //  in the selection (lepton ID, b-tag, trigger, MET/HT turn-ons, ...)
+    //  comes out of the event's dice, which only depend on the run seed
+    //  (FlipEvent.h). So running select_event again on the stored records
+    //  with another seed is the same as running PartonRPV again with the
+    //  same events and new dice, without the generation.
+    //
+    // Each replica r gets its own seed, made from the run seed and r, and
+    //  gives two numbers:
+    //  - diceEfficiency[r]: the efficiency with replica r's dice. Their
+    //    spread is what rerunning with new seeds would have shown for a
+    //    fixed set of events, and their average (with the run's own) is a
+    //    better estimate than any one of them.
+    //  - efficiency[r]: the same, but every event also counts a Poisson(1)
+    //    number of times (rolled from its own dice), the usual bootstrap
+    //    for "a different sample of events". Its spread is the statistical
+    //    uncertainty of one run: dice and events together. With cascade=K
+    //    the K events of a stored gluino pair are one draw (the count is
+    //    rolled per pair), since they share its gluinos.
+    int nReplicas;                      // R, 0: no bootstrap
+    int isoGrid;                        // the run's isogrid=, for replays
+    int copies;                         // events per draw, cascade='s K
+    vector<flipevent> events;           // every generated event (vetoed
+                                        //  ones too, with no particles)
+    vector<double> diceEfficiency;      // per replica, new dice
+    vector<double> efficiency;          // per replica, new dice and events
+};
+
+
+void fill_bootstrap(flipbootstrap&, int, int);
+    // Inputs: # replicas, isolation grid (runoptions' isoGrid). Nothing is
+    //  stored if there are no replicas
+
+void keep_event(flipbootstrap&, flipevent&);
+    // Stores a copy of the event record (if there are replicas to run)
+
+void run_bootstrap(flipbootstrap&, signalregion&, const effparams&,
+                   unsigned int, int);
+    // Inputs: bootstrap, signal region, parameters, run seed, nEvent (the
+    //  efficiency is per nEvent, like signal_efficiency_b's)
+    // Replays the stored events nReplicas times
+
+void report_bootstrap(flipbootstrap&, double);
+    // Input: the run's own efficiency
+    // Prints the replica average and the two spreads
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPBOOTSTRAP_H_INCLUDED__
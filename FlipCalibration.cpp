@@ -0,0 +1,397 @@
+/********************************************************************************
+*   FlipCalibration.cpp by Flip Tanedo (pt267@cornell.edu)                      *
+*   Parton-to-jet maps, measured at hadron level and used at parton level:      *
+*   - measure_event: hard partons matched to the anti-kT jets                   *
+*   - write_calibration: efficiency, response and resolution per bin           *
+*   - calibrate_event: the maps applied to a parton-level record                *
+********************************************************************************/
+
+#include "FlipCalibration.h"
+#include <algorithm>                        // sort
+
+
+static const double pTedges[]  = {10, 20, 30, 40, 50, 60, 80, 100, 150, 200,
+                                  300, 500};
+static const double etaEdges[] = {0.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 5.0};
+static const int nPTedges  = sizeof(pTedges) / sizeof(pTedges[0]);
+static const int nEtaEdges = sizeof(etaEdges) / sizeof(etaEdges[0]);
+static const double pTlast = 14000;             // the top bin has no end
+
+
+
+static bool is_parton(int id){
+    // Quarks but the top, and gluons: what the maps are made of
+    return ((abs(id) >= 1) && (abs(id) <= 5)) || (id == 21);
+} // end is_parton
+
+
+
+static void fill_bins(vector<calibbin>& bins){
+    // Empty, below 10 GeV and at or above 500 GeV in a bin of their own
+
+    bins.clear();
+    for (int iPT = -1; iPT < nPTedges; iPT++){
+        for (int iEta = 0; iEta + 1 < nEtaEdges; iEta++){
+            calibbin bin;
+            bin.pTlow        = (iPT < 0) ? 0.0 : pTedges[iPT];
+            bin.pThigh       = (iPT + 1 < nPTedges) ? pTedges[iPT + 1]
+                                                    : pTlast;
+            bin.etaLow       = etaEdges[iEta];
+            bin.etaHigh      = etaEdges[iEta + 1];
+            bin.nPartons     = 0;
+            bin.weight       = 0;
+            bin.matched      = 0;
+            bin.sumResponse  = 0;
+            bin.sumResponse2 = 0;
+            bin.efficiency   = 1;
+            bin.response     = 1;
+            bin.resolution   = 0;
+            bins.push_back(bin);
+        }
+    }
+} // end fill_bins
+
+
+
+static calibbin* find_bin(vector<calibbin>& bins, double pT, double eta){
+    // The bin with this pT and |eta|, 0 if none (|eta| >= 5)
+
+    double absEta = fabs(eta);
+    for (unsigned int i = 0; i < bins.size(); i++)
+        if ((pT >= bins[i].pTlow) && (pT < bins[i].pThigh) &&
+            (absEta >= bins[i].etaLow) && (absEta < bins[i].etaHigh))
+            return &bins[i];
+    return 0;
+} // end find_bin
+
+
+
+static bool read_maps(flipcalibration& calibration){
+    // flavour pTlow pThigh etaLow etaHigh nPartons efficiency response
+    //  resolution, one bin a line, # for comments
+
+    ifstream in(calibration.filename.c_str());
+    if (!in.is_open()) return false;
+
+    string line;
+    while (getline(in, line)){
+        if ((line.size() == 0) || (line[0] == '#')) continue;
+        stringstream words(line);
+        string flavour;
+        calibbin bin;
+        words >> flavour >> bin.pTlow >> bin.pThigh >> bin.etaLow
+              >> bin.etaHigh >> bin.nPartons >> bin.efficiency
+              >> bin.response >> bin.resolution;
+        if (!words) return false;
+        bin.weight       = 0;
+        bin.matched      = 0;
+        bin.sumResponse  = 0;
+        bin.sumResponse2 = 0;
+        if      (flavour == "light") calibration.light.push_back(bin);
+        else if (flavour == "b")     calibration.b.push_back(bin);
+        else return false;
+    }
+    return !calibration.light.empty() || !calibration.b.empty();
+} // end read_maps
+
+
+
+bool start_calibration(flipcalibration& calibration,
+                       const runoptions& options){
+    // One or the other, each only at its own level
+
+    calibration.measure       = false;
+    calibration.apply         = false;
+    calibration.filename      = "";
+    calibration.dRmatch       = 0.3;
+    calibration.light.clear();
+    calibration.b.clear();
+    calibration.nEvents       = 0;
+    calibration.unmatchedJets = 0;
+    calibration.eventWeight   = 0;
+    calibration.nApplied      = 0;
+    calibration.nDropped      = 0;
+    calibration.sumScale      = 0;
+
+    if (options.calibrate != ""){
+        if (!options.hadron){
+            cout << endl << "ERROR: calibrate= needs the jets of hadron=1, "
+                 << "no maps made" << endl;
+            return false;
+        }
+        calibration.filename = options.calibrate;
+        fill_bins(calibration.light);
+        fill_bins(calibration.b);
+        calibration.measure = true;
+        return true;
+    }
+
+    if (options.maps != ""){
+        if (options.hadron){
+            cout << endl << "ERROR: maps= is for parton level, hadron=1 has "
+                 << "jets of its own" << endl;
+            return false;
+        }
+        calibration.filename = options.maps;
+        if (!read_maps(calibration)){
+            cout << endl << "ERROR: couldn't read the maps in "
+                 << calibration.filename << ", partons used as they are"
+                 << endl;
+            calibration.light.clear();
+            calibration.b.clear();
+            return false;
+        }
+        calibration.apply = true;
+        return true;
+    }
+
+    return false;
+} // end start_calibration
+
+
+
+void measure_event(flipcalibration& calibration, Pythia8::Event& process,
+                   flipevent& record){
+    // Hardest parton first, each to the nearest jet no harder parton has
+    //  taken: a parton that went into another one's jet didn't make one
+
+    if (!calibration.measure) return;
+
+    calibration.nEvents++;
+    calibration.eventWeight += record.weight;
+
+    calibration.partons.clear();
+    for (int iPart = 0; iPart < process.size(); iPart++){
+        if (!process[iPart].isFinal()) continue;
+        if (!is_parton(process[iPart].id())) continue;
+        if (abs(process[iPart].eta()) >= 5.0) continue;
+        calibration.partons.push_back(pair<double, int>(process[iPart].pT(),
+                                                        iPart));
+    }
+    sort(calibration.partons.rbegin(), calibration.partons.rend());
+
+    vector<bool> used(record.prepartons.size(), false);
+    for (unsigned int i = 0; i < calibration.partons.size(); i++){
+        int iPart = calibration.partons[i].second;
+        fastjet::PseudoJet parton(process[iPart].px(), process[iPart].py(),
+                                  process[iPart].pz(), process[iPart].e());
+        calibbin* bin = find_bin((abs(process[iPart].id()) == 5)
+                                 ? calibration.b : calibration.light,
+                                 parton.pt(), parton.eta());
+        if (!bin) continue;
+
+        int nearest = -1;
+        double dRnearest = calibration.dRmatch;
+        for (unsigned int iJet = 0; iJet < record.prepartons.size(); iJet++){
+            if (used[iJet]) continue;
+            double dR = get_deltaR(parton, record.prepartons[iJet].second);
+            if (dR < dRnearest){
+                dRnearest = dR;
+                nearest = iJet;
+            }
+        }
+
+        bin->nPartons++;
+        bin->weight += record.weight;
+        if (nearest < 0) continue;
+
+        double response = record.prepartons[nearest].second.pt()
+                        / parton.pt();
+        used[nearest] = true;
+        bin->matched      += record.weight;
+        bin->sumResponse  += record.weight * response;
+        bin->sumResponse2 += record.weight * response * response;
+
+    } // end loop over the hard partons
+
+    for (unsigned int iJet = 0; iJet < used.size(); iJet++)
+        if (!used[iJet]) calibration.unmatchedJets += record.weight;
+} // end measure_event
+
+
+
+static double calibrate_parton(vector<calibbin>& bins,
+                               const fastjet::PseudoJet& p, flipdice& dice,
+                               flipcalibration& calibration){
+    // The scale of its momentum, 0 if the parton doesn't make a jet, 1 if
+    //  no parton fell in its bin
+
+    calibbin* bin = find_bin(bins, p.pt(), p.eta());
+    if (!bin) return 1.0;
+
+    calibration.nApplied++;
+    if (roll_dice(dice) >= bin->efficiency){
+        calibration.nDropped++;
+        return 0.0;
+    }
+
+    // Box-Muller, with 1 - roll so the log never sees 0
+    double radius = sqrt(-2.0 * log(1.0 - roll_dice(dice)));
+    double gauss  = radius * cos(2 * M_PI * roll_dice(dice));
+    double scale  = bin->response + bin->resolution * gauss;
+    if (scale <= 0){
+        calibration.nDropped++;
+        return 0.0;
+    }
+
+    calibration.sumScale += scale;
+    return scale;
+} // end calibrate_parton
+
+
+
+static void scale_momentum(fastjet::PseudoJet& p, double scale){
+    // All four components, so the mass scales with it
+    p.reset_momentum(scale * p.px(), scale * p.py(), scale * p.pz(),
+                     scale * p.e());
+} // end scale_momentum
+
+
+
+void calibrate_event(flipcalibration& calibration, flipevent& record,
+                     unsigned int seed){
+    // Partons first, then the b's, always in the record's order. A b is in
+    //  both lists (the event's and the hard process's), so it's rolled for
+    //  once, in prepartons; its copy in bpartons, the nearest b of the
+    //  same id within dRmatch, gets the same scale, or is dropped with it
+
+    if (!calibration.apply) return;
+
+    flipdice dice;
+    seed_dice(dice, seed, record.iEvent, calibrationStream);
+
+    calibration.bs.clear();
+    calibration.bScales.clear();
+
+    unsigned int nKept = 0;
+    record.HT = 0.0;
+    for (unsigned int i = 0; i < record.prepartons.size(); i++){
+        pair<int, fastjet::PseudoJet> parton = record.prepartons[i];
+        double scale = 1.0;
+        if (is_parton(parton.first))
+            scale = calibrate_parton((abs(parton.first) == 5)
+                                     ? calibration.b : calibration.light,
+                                     parton.second, dice, calibration);
+        if (abs(parton.first) == 5){
+            calibration.bs.push_back(parton);
+            calibration.bScales.push_back(scale);
+        }
+        if (scale <= 0) continue;
+        scale_momentum(parton.second, scale);
+        record.prepartons[nKept++] = parton;
+        record.HT += parton.second.pt();
+    }
+    record.prepartons.resize(nKept);
+
+    nKept = 0;
+    vector<bool> used(calibration.bs.size(), false);
+    for (unsigned int i = 0; i < record.bpartons.size(); i++){
+        pair<int, fastjet::PseudoJet> parton = record.bpartons[i];
+        if (abs(parton.first) == 5){
+            int nearest = -1;
+            double dRnearest = calibration.dRmatch;
+            for (unsigned int iB = 0; iB < calibration.bs.size(); iB++){
+                if (used[iB] || (calibration.bs[iB].first != parton.first))
+                    continue;
+                double dR = get_deltaR(parton.second,
+                                       calibration.bs[iB].second);
+                if (dR < dRnearest){
+                    dRnearest = dR;
+                    nearest = iB;
+                }
+            }
+
+            // one the event doesn't have (showers on) rolls its own dice
+            double scale;
+            if (nearest >= 0){
+                used[nearest] = true;
+                scale = calibration.bScales[nearest];
+            }
+            else scale = calibrate_parton(calibration.b, parton.second,
+                                          dice, calibration);
+            if (scale <= 0) continue;
+            scale_momentum(parton.second, scale);
+        }
+        record.bpartons[nKept++] = parton;
+    }
+    record.bpartons.resize(nKept);
+} // end calibrate_event
+
+
+
+static void write_bins(ofstream& out, string flavour,
+                       vector<calibbin>& bins){
+    // The sums into efficiency, response and resolution, then a line each
+
+    for (unsigned int i = 0; i < bins.size(); i++){
+        calibbin& bin = bins[i];
+        if (bin.weight > 0) bin.efficiency = bin.matched / bin.weight;
+        if (bin.matched > 0){
+            bin.response = bin.sumResponse / bin.matched;
+            double variance = bin.sumResponse2 / bin.matched
+                            - bin.response * bin.response;
+            bin.resolution = (variance > 0) ? sqrt(variance) : 0.0;
+        }
+        out << left << setw(6) << flavour << right
+            << setw(8) << bin.pTlow << setw(8) << bin.pThigh
+            << setw(6) << bin.etaLow << setw(6) << bin.etaHigh
+            << setw(10) << bin.nPartons
+            << setw(14) << bin.efficiency << setw(14) << bin.response
+            << setw(14) << bin.resolution << endl;
+    }
+} // end write_bins
+
+
+
+void write_calibration(flipcalibration& calibration){
+    // A text file maps= reads back, and a person can
+
+    if (!calibration.measure) return;
+
+    ofstream out(calibration.filename.c_str());
+    out << "# Parton-to-jet maps (FlipCalibration.h): hard partons matched to"
+        << " anti-kT jets," << endl
+        << "#  dR < " << calibration.dRmatch << ", " << calibration.nEvents
+        << " events; a bin with no partons leaves them alone" << endl
+        << "# flavour pTlow pThigh etaLow etaHigh nPartons efficiency "
+        << "response resolution" << endl;
+    out << setprecision(6);
+    write_bins(out, "light", calibration.light);
+    write_bins(out, "b", calibration.b);
+} // end write_calibration
+
+
+
+void report_calibration(flipcalibration& calibration){
+    // e.g. "Calibration: 93.1% of 81234 partons made a jet, 4.2 jets per
+    //  event with none, maps in maps.dat"
+
+    if (calibration.measure){
+        int nPartons = 0;
+        double weight = 0;
+        double matched = 0;
+        for (int flavour = 0; flavour < 2; flavour++){
+            vector<calibbin>& bins = (flavour == 0) ? calibration.light
+                                                    : calibration.b;
+            for (unsigned int i = 0; i < bins.size(); i++){
+                nPartons += bins[i].nPartons;
+                weight   += bins[i].weight;
+                matched  += bins[i].matched;
+            }
+        }
+        cout << "Calibration: "
+             << ((weight > 0) ? 100.0 * matched / weight : 0.0)
+             << "% of " << nPartons << " partons made a jet, "
+             << ((calibration.eventWeight > 0)
+                 ? calibration.unmatchedJets / calibration.eventWeight : 0.0)
+             << " jets per event with none, maps in " << calibration.filename
+             << endl;
+    }
+    if (calibration.apply){
+        int nKept = calibration.nApplied - calibration.nDropped;
+        cout << "Calibrated with " << calibration.filename << ": "
+             << calibration.nApplied << " partons, " << calibration.nDropped
+             << " dropped, mean scale "
+             << ((nKept > 0) ? calibration.sumScale / nKept : 1.0) << endl;
+    }
+} // end report_calibration
@@ -0,0 +1,105 @@
+// FlipCalibration.h
+// Parton-level objects calibrated on hadron level: a hadron=1 run matches
+//  the hard partons to anti-kT jets and writes out how often a parton
+//  makes a jet and how much of its pT the jet gets; a parton-level run
+//  reads those maps back and does the same to its partons
+// INCLUDE GUARD
+#ifndef __FLIPCALIBRATION_H_INCLUDED__
+#define __FLIPCALIBRATION_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+// The parton-level selection takes the partons as jets, and tags b's on
+//  the parton pT with b_selection_efficiency, whose parametrisation is in
+//  jet pT. Both are only as good as a parton is like its jet.
+//
+// Measuring (calibrate=maps.dat, with hadron=1): every final quark or
+//  gluon of the hard process (pythia.process, what the parton-level run
+//  would have as prepartons), hardest first, is matched to the nearest
+//  jet within dR < 0.3 that a harder parton hasn't taken; one that has
+//  none went into another's jet, or below 10 GeV. In bins of the
+//  parton's pT and |eta|, separately for b's and the rest:
+//      efficiency  the fraction of partons with a jet
+//      response    the mean jet pT / parton pT of those that have one
+//      resolution  its spread (RMS)
+//  all weighted with the event weights (FlipBias.h). Jets no parton made
+//  (ISR, MPI) can't be put on a parton; how many there are per event is
+//  printed, so it's known what the maps leave out.
+//
+// Applying (maps=maps.dat, parton level, cascade= too): every quark or
+//  gluon in prepartons is kept with the efficiency of its bin and its
+//  four-momentum scaled by response + resolution * (a Gaussian). A b is
+//  in bpartons too, and gets what its prepartons copy got (the nearest b
+//  of the same id within dRmatch), so the b-tag sees the same jet-like
+//  pT the jet cuts did and a b that made no jet can't be tagged; one
+//  with no copy (showers on) is rolled for with the b maps on its own.
+//  HT is added up again; MET and the leptons are left as they were.
+//  A bin no parton fell in leaves the parton alone. Every event rolls its
+//  own dice (stream calibrationStream), so pipeline and batch don't
+//  change the answer.
+
+static const unsigned int calibrationStream = 1001;    // dice of the maps
+
+struct calibbin{
+    double pTlow, pThigh;           // parton pT, GeV
+    double etaLow, etaHigh;         // parton |eta|
+    int nPartons;                   // unweighted, for the statistics
+    double weight;                  // of the partons ...
+    double matched;                 // ... and of those with a jet
+    double sumResponse;             // weighted sum of jet pT / parton pT
+    double sumResponse2;            // ... and of its square
+
+    // what a parton-level run uses, from the above or read back
+    double efficiency;
+    double response;
+    double resolution;
+};
+
+struct flipcalibration{
+    bool measure;                   // calibrate=, hadron level
+    bool apply;                     // maps=, parton level
+    string filename;
+    double dRmatch;                 // parton to jet
+    vector<calibbin> light;         // quarks but b, and gluons
+    vector<calibbin> b;
+
+    // counts
+    int nEvents;
+    double unmatchedJets;           // weighted, jets with no parton
+    double eventWeight;             // of the events measured
+    int nApplied;                   // partons calibrated
+    int nDropped;                   // ... of which didn't make a jet
+    double sumScale;                // of the ones kept
+
+    // scratch
+    vector< pair<double, int> > partons;    // (pT, index in process)
+    vector< pair<int, fastjet::PseudoJet> > bs;  // prepartons' b's, as were
+    vector<double> bScales;                 // ... and theirs, 0: dropped
+};
+
+
+bool start_calibration(flipcalibration&, const runoptions&);
+    // Measures (empty maps in 10-500 GeV pT and |eta| < 5 bins) with
+    //  calibrate= and hadron=1, applies with maps= at parton level. False
+    //  (and neither) if it's asked for at the wrong level, or the maps
+    //  can't be read
+
+void measure_event(flipcalibration&, Pythia8::Event&, flipevent&);
+    // Inputs: calibration, pythia.process, record with the jets
+    // Matches the hard partons to the jets and adds them to the maps
+
+void calibrate_event(flipcalibration&, flipevent&, unsigned int);
+    // Inputs: calibration, record (iEvent set), run seed
+    // Applies the maps to the record's partons and bpartons
+
+void write_calibration(flipcalibration&);
+    // Efficiency, response and resolution per bin, to filename
+
+void report_calibration(flipcalibration&);
+    // How many partons made a jet, or were dropped, and the mean scale
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPCALIBRATION_H_INCLUDED__
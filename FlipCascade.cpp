@@ -0,0 +1,590 @@
+/********************************************************************************
+*   FlipCascade.cpp by Flip Tanedo (pt267@cornell.edu)                          *
+*   Decays of our own for the parton-level runs:                                *
+*   - start_cascade: the stored gluino pairs, Pythia's decay tables             *
+*   - cascade_event: one event, decayed straight into the record                *
+*   - validate_cascade: the same gluino pairs through Pythia, side by side      *
+********************************************************************************/
+
+#include "FlipCascade.h"
+#include <algorithm>                        // sort
+#include <functional>                       // greater
+
+
+static const double sinhEtaMax = sinh(5.0);     // |eta| < 5: |pz| < this pT
+static const int massTries = 100;               // for products that fit
+static const int phaseSpaceTries = 10000;       // accept-reject, per decay
+
+
+
+static bool read_gluinos(flipcascade& cascade){
+    // The final gluinos of every event in the stored production, written
+    //  by write_lhe_event: id status mother mother col acol px py pz e ...
+
+    ifstream in(cascade.filename.c_str());
+    if (!in.is_open()) return false;
+
+    vector<cascade4> pair;
+    bool inEvent = false;
+    int nLeft = -1;                         // particle lines still to come
+    string line;
+    while (getline(in, line)){
+        if (line.find("<event") != string::npos){
+            inEvent = true;
+            nLeft = -1;
+            pair.clear();
+            continue;
+        }
+        if (!inEvent) continue;
+        if (line.find("</event") != string::npos){
+            if (pair.size() == 2){
+                cascade.gluinos.push_back(pair[0]);
+                cascade.gluinos.push_back(pair[1]);
+            }
+            inEvent = false;
+            continue;
+        }
+
+        stringstream words(line);
+        if (nLeft < 0){                     // NUP IDPRUP XWGTUP ...
+            words >> nLeft;
+            continue;
+        }
+        if (nLeft == 0) continue;
+        nLeft--;
+
+        int id, status, mother1, mother2, col, acol;
+        cascade4 p;
+        words >> id >> status >> mother1 >> mother2 >> col >> acol
+              >> p.px >> p.py >> p.pz >> p.e;
+        if (words && (abs(id) == 1000021) && (status == 1))
+            pair.push_back(p);
+    }
+    return !cascade.gluinos.empty();
+} // end read_gluinos
+
+
+
+static int index_of(flipcascade& cascade, int id, Pythia8::Pythia& pythia,
+                    flipbias& bias, bool hadronDecays){
+    // The table entry of id, and of everything it can decay to
+
+    map<int, int>::iterator found = cascade.index.find(id);
+    if (found != cascade.index.end()) return found->second;
+
+    Pythia8::ParticleData& data = pythia.particleData;
+    int iNew = cascade.table.size();
+    cascade.index[id] = iNew;               // before the products: loops
+
+    cascadeparticle particle;
+    particle.id        = id;
+    particle.m0        = data.m0(id);
+    particle.width     = data.mWidth(id);
+    particle.mMin      = data.mMin(id);
+    particle.mMax      = data.mMax(id);
+    particle.visible   = data.isVisible(id);
+    particle.resonance = data.isResonance(id);
+    particle.decays    = false;
+    particle.weight    = 1.0;
+    for (unsigned int i = 0; i < bias.ids.size(); i++){
+        if (id == bias.ids[i])  particle.weight = bias.weightParticle[i];
+        if (id == -bias.ids[i]) particle.weight = bias.weightAntiparticle[i];
+    }
+    cascade.table.push_back(particle);
+
+    // Resonances decay in the process record, the rest with the hadrons
+    if (!data.mayDecay(id)) return iNew;
+    if (!particle.resonance && !hadronDecays) return iNew;
+    Pythia8::ParticleDataEntry* entry = data.particleDataEntryPtr(abs(id));
+    if (!entry) return iNew;
+
+    // The channels the way ResonanceDecays and ParticleDecays see them:
+    //  onMode 2 is on for the particle only, 3 for the antiparticle only
+    vector<cascadechannel> channels;
+    double sum = 0;
+    for (int iChannel = 0; iChannel < entry->sizeChannels(); iChannel++){
+        Pythia8::DecayChannel& decay = entry->channel(iChannel);
+        int onMode = decay.onMode();
+        bool on = (onMode == 1) || ((onMode == 2) && (id > 0))
+                                || ((onMode == 3) && (id < 0));
+        if (!on || (decay.bRatio() <= 0)) continue;
+
+        cascadechannel channel;
+        sum += decay.bRatio();
+        channel.branching = sum;
+        int nLeptons = 0;
+        for (int iProduct = 0; iProduct < decay.multiplicity(); iProduct++){
+            int product = decay.product(iProduct);
+            if ((id < 0) && data.hasAnti(product)) product = -product;
+            if ((abs(product) == 11) || (abs(product) == 13)) nLeptons++;
+            channel.products.push_back(
+                index_of(cascade, product, pythia, bias, hadronDecays));
+        }
+        channel.vminusa = (abs(id) == 15) && (channel.products.size() == 3)
+                       && (nLeptons == 1);
+        if (!channel.products.empty()) channels.push_back(channel);
+    }
+    if (channels.empty()) return iNew;
+
+    for (unsigned int i = 0; i < channels.size(); i++)
+        channels[i].branching /= channels.back().branching;
+    channels.back().branching = 1.0;
+
+    cascade.table[iNew].channels = channels;
+    cascade.table[iNew].decays = true;
+    return iNew;
+} // end index_of
+
+
+
+bool start_cascade(flipcascade& cascade, int copies, string filename,
+                   Pythia8::Pythia& pythia, flipbias& bias){
+    // Gluinos from the file, decay tables from pythia
+
+    cascade.on       = false;
+    cascade.copies   = copies;
+    cascade.filename = filename;
+    cascade.gluinos.clear();
+    cascade.table.clear();
+    cascade.index.clear();
+    cascade.nEvent   = 0;
+    cascade.nDecays  = 0;
+    cascade.nFailed  = 0;
+    if (copies <= 0) return false;
+
+    if (!read_gluinos(cascade)){
+        cout << endl << "ERROR: no gluino pairs in " << filename
+             << ", Pythia decays them" << endl;
+        return false;
+    }
+
+    bool hadronDecays = pythia.flag("HadronLevel:all")
+                     && pythia.flag("HadronLevel:Decay");
+    cascade.gluinoIndex = index_of(cascade, 1000021, pythia, bias,
+                                   hadronDecays);
+    cascade.antigluinoIndex = index_of(cascade,
+        pythia.particleData.hasAnti(1000021) ? -1000021 : 1000021,
+        pythia, bias, hadronDecays);
+
+    cascade.nEvent = copies * (cascade.gluinos.size() / 2);
+    cascade.on = true;
+    return true;
+} // end start_cascade
+
+
+
+static double mass(const cascade4& p){
+    double m2 = p.e * p.e - p.px * p.px - p.py * p.py - p.pz * p.pz;
+    return (m2 > 0) ? sqrt(m2) : 0.0;
+}
+
+
+
+static double dot(const cascade4& a, const cascade4& b){
+    return a.e * b.e - a.px * b.px - a.py * b.py - a.pz * b.pz;
+}
+
+
+
+static double pstar(double M, double m1, double m2){
+    // Momentum of either product of M -> m1 m2, in the rest frame of M
+    double a = (M * M - (m1 + m2) * (m1 + m2))
+             * (M * M - (m1 - m2) * (m1 - m2));
+    return (a > 0) ? sqrt(a) / (2 * M) : 0.0;
+}
+
+
+
+static void boost(cascade4& p, const cascade4& frame, double M){
+    // From the rest frame of frame (mass M) to the frame frame is in
+
+    double pdot = p.px * frame.px + p.py * frame.py + p.pz * frame.pz;
+    double e = (p.e * frame.e + pdot) / M;
+    double f = (p.e + e) / (frame.e + M);
+    p.px += f * frame.px;
+    p.py += f * frame.py;
+    p.pz += f * frame.pz;
+    p.e   = e;
+} // end boost
+
+
+
+static void split(cascade4& a, cascade4& b, double q, double ma, double mb,
+                  flipdice& dice){
+    // Back to back with momentum q, isotropic
+
+    double cosTheta = 2 * roll_dice(dice) - 1;
+    double sinTheta = sqrt(max(0.0, 1 - cosTheta * cosTheta));
+    double phi = 2 * M_PI * roll_dice(dice);
+    a.px = q * sinTheta * cos(phi);
+    a.py = q * sinTheta * sin(phi);
+    a.pz = q * cosTheta;
+    a.e  = sqrt(q * q + ma * ma);
+    b.px = -a.px;
+    b.py = -a.py;
+    b.pz = -a.pz;
+    b.e  = sqrt(q * q + mb * mb);
+} // end split
+
+
+
+static double product_mass(cascadeparticle& particle, flipdice& dice){
+    // Breit-Wigner between mMin and mMax (no upper limit if mMax < mMin)
+
+    if (particle.width <= 0) return particle.m0;
+    double halfWidth = 0.5 * particle.width;
+    double low  = atan((particle.mMin - particle.m0) / halfWidth);
+    double high = (particle.mMax > particle.mMin)
+                ? atan((particle.mMax - particle.m0) / halfWidth)
+                : 0.5 * M_PI * (1 - 1e-9);
+    return particle.m0 + halfWidth * tan(low + (high - low) * roll_dice(dice));
+} // end product_mass
+
+
+
+static bool phase_space(flipcascade& cascade, cascadechannel& channel,
+                        double M, flipdice& dice){
+    // Flat n-body phase space in the rest frame of M (n > 2): M splits
+    //  into the first product and the rest, the rest into the second
+    //  and what's left, ... with the masses of the rests uniform in the
+    //  room there is, kept with probability (product of the momenta) /
+    //  (its largest value)
+
+    vector<double>& masses = cascade.masses;
+    vector<double>& systems = cascade.systems;
+    vector<cascade4>& daughters = cascade.daughters;
+    int n = masses.size();
+
+    double sum = 0;
+    for (int i = 0; i < n; i++) sum += masses[i];
+    double room = M - sum;
+
+    double largest = 1.0;
+    double before = 0;                      // masses of the products so far
+    for (int i = 0; i < n - 1; i++){
+        double after = sum - before - masses[i];
+        largest *= pstar(M - before, masses[i], after);
+        before += masses[i];
+    }
+
+    systems.resize(n);
+    for (int iTry = 0; iTry < phaseSpaceTries; iTry++){
+
+        // masses of the rests, decreasing
+        for (int i = 1; i < n - 1; i++) systems[i] = roll_dice(dice);
+        sort(systems.begin() + 1, systems.begin() + n - 1,
+             greater<double>());
+        double left = sum;
+        systems[0] = M;
+        for (int i = 1; i < n; i++){
+            left -= masses[i - 1];
+            systems[i] = (i < n - 1) ? left + systems[i] * room : left;
+        }
+
+        double weight = 1.0;
+        for (int i = 0; i < n - 1; i++)
+            weight *= pstar(systems[i], masses[i], systems[i + 1]);
+        if (weight < largest * roll_dice(dice)) continue;
+
+        // the momenta, each rest boosted to the frame of the one before
+        cascade4 rest = {0.0, 0.0, 0.0, M};
+        for (int i = 0; i < n - 1; i++){
+            cascade4 next;
+            double q = pstar(systems[i], masses[i], systems[i + 1]);
+            split(daughters[i], next, q, masses[i], systems[i + 1], dice);
+            if (i > 0){
+                boost(daughters[i], rest, systems[i]);
+                boost(next, rest, systems[i]);
+            }
+            rest = next;
+        }
+        daughters[n - 1] = rest;
+
+        // tau -> l nu nu: |M|^2 ~ (p_tau.p_nubar_l)(p_l.p_nu_tau), which
+        //  is at most M^4 / 4
+        if (channel.vminusa){
+            int iLepton = -1, iNeutrino = -1, iTauNeutrino = -1;
+            for (int i = 0; i < n; i++){
+                int id = abs(cascade.table[channel.products[i]].id);
+                if ((id == 11) || (id == 13)) iLepton = i;
+                else if ((id == 12) || (id == 14)) iNeutrino = i;
+                else if (id == 16) iTauNeutrino = i;
+            }
+            if ((iLepton >= 0) && (iNeutrino >= 0) && (iTauNeutrino >= 0)){
+                double matrix = M * daughters[iNeutrino].e
+                    * dot(daughters[iLepton], daughters[iTauNeutrino]);
+                if (matrix < 0.25 * M * M * M * M * roll_dice(dice)) continue;
+            }
+        }
+        return true;
+    }
+    return false;
+} // end phase_space
+
+
+
+static bool decay_particle(flipcascade& cascade, cascadeitem& item,
+                           flipdice& dice){
+    // Products of item, boosted to the lab, on the stack. False (and
+    //  nothing on the stack) if they don't fit
+
+    cascadeparticle& particle = cascade.table[item.index];
+    double M = mass(item.p);
+
+    double u = roll_dice(dice);
+    unsigned int iChannel = 0;
+    while ((iChannel + 1 < particle.channels.size())
+           && (u >= particle.channels[iChannel].branching)) iChannel++;
+    cascadechannel& channel = particle.channels[iChannel];
+    int n = channel.products.size();
+
+    vector<double>& masses = cascade.masses;
+    vector<cascade4>& daughters = cascade.daughters;
+    masses.resize(n);
+    daughters.resize(n);
+
+    bool fits = false;
+    for (int iTry = 0; (iTry < massTries) && !fits; iTry++){
+        double sum = 0;
+        for (int i = 0; i < n; i++){
+            masses[i] = product_mass(cascade.table[channel.products[i]], dice);
+            sum += masses[i];
+        }
+        fits = (sum < M) || (n == 1);
+    }
+    if (!fits) return false;
+
+    if (n == 1){
+        daughters[0] = item.p;
+    }
+    else if (n == 2){
+        split(daughters[0], daughters[1], pstar(M, masses[0], masses[1]),
+              masses[0], masses[1], dice);
+        boost(daughters[0], item.p, M);
+        boost(daughters[1], item.p, M);
+    }
+    else{
+        if (!phase_space(cascade, channel, M, dice)) return false;
+        for (int i = 0; i < n; i++) boost(daughters[i], item.p, M);
+    }
+
+    cascadeitem product;
+    product.process = item.process && particle.resonance;
+    for (int i = 0; i < n; i++){
+        product.index = channel.products[i];
+        product.p = daughters[i];
+        cascade.stack.push_back(product);
+    }
+    return true;
+} // end decay_particle
+
+
+
+static void fill_particle(vector< pair<int, fastjet::PseudoJet> >& list,
+                          int id, const cascade4& p){
+    list.push_back(pair<int, fastjet::PseudoJet>(id,
+                   fastjet::PseudoJet(p.px, p.py, p.pz, p.e)));
+}
+
+
+
+void cascade_event(flipcascade& cascade, flipevent& record, int iEvent,
+                   unsigned int seed){
+    // Decays until there's nothing left to decay; what's left is the
+    //  final state, sorted into the record as fill_event does
+
+    record.preleptons.clear();
+    record.prepartons.clear();
+    record.bpartons.clear();
+    record.METvec = fastjet::PseudoJet(0.0, 0.0, 0.0, 0.0);
+    record.HT = 0.0;
+    record.weight = 1.0;
+    record.iEvent = iEvent;
+
+    flipdice dice;
+    seed_dice(dice, seed, iEvent, cascadeStream);
+
+    // The stored pair, turned about the beam
+    int iPair = (iEvent / cascade.copies) % (cascade.gluinos.size() / 2);
+    double phi = 2 * M_PI * roll_dice(dice);
+    double cosPhi = cos(phi);
+    double sinPhi = sin(phi);
+
+    cascade.stack.clear();
+    for (int i = 0; i < 2; i++){
+        cascadeitem gluino;
+        gluino.index = (i == 0) ? cascade.gluinoIndex
+                                : cascade.antigluinoIndex;
+        gluino.process = true;
+        gluino.p = cascade.gluinos[2 * iPair + i];
+        gluino.p.px = cosPhi * cascade.gluinos[2 * iPair + i].px
+                    - sinPhi * cascade.gluinos[2 * iPair + i].py;
+        gluino.p.py = sinPhi * cascade.gluinos[2 * iPair + i].px
+                    + cosPhi * cascade.gluinos[2 * iPair + i].py;
+        cascade.stack.push_back(gluino);
+    }
+
+    while (!cascade.stack.empty()){
+        cascadeitem item = cascade.stack.back();
+        cascade.stack.pop_back();
+        cascadeparticle& particle = cascade.table[item.index];
+
+        bool decayed = false;
+        if (particle.decays){
+            decayed = decay_particle(cascade, item, dice);
+            if (decayed) cascade.nDecays++;
+            else cascade.nFailed++;
+        }
+
+        // pythia.process ends where the resonance decays do
+        bool visible = particle.visible
+            && (abs(item.p.pz) < sinhEtaMax * sqrt(item.p.px * item.p.px
+                                                 + item.p.py * item.p.py));
+        if (item.process && !(decayed && particle.resonance) && visible)
+            fill_particle(record.bpartons, particle.id, item.p);
+        if (decayed){
+            if (item.process && particle.resonance)
+                record.weight *= particle.weight;
+            continue;
+        }
+
+        // ... and pythia.event with the hadron decays
+        if (!visible) continue;
+        record.METvec -= fastjet::PseudoJet(item.p.px, item.p.py, item.p.pz,
+                                            item.p.e);
+        if ((abs(particle.id) == 11) || (abs(particle.id) == 13)){
+            fill_particle(record.preleptons, particle.id, item.p);
+            continue;
+        }
+        fill_particle(record.prepartons, particle.id, item.p);
+        record.HT += sqrt(item.p.px * item.p.px + item.p.py * item.p.py);
+    }
+} // end cascade_event
+
+
+
+void report_cascade(flipcascade& cascade){
+    // e.g. "Cascade: 10000 gluino pairs x 10, 2e+05 decays, 0 left undone"
+
+    if (!cascade.on) return;
+    cout << "Cascade: " << cascade.gluinos.size() / 2 << " gluino pairs x "
+         << cascade.copies << ", " << cascade.table.size()
+         << " particles in the table, " << cascade.nDecays << " decays, "
+         << cascade.nFailed << " left undone" << endl;
+    if (cascade.copies > 1)
+        cout << "  " << cascade.nEvent << " events, but the statistics are "
+             << "those of " << cascade.gluinos.size() / 2 << " independent "
+             << "pairs" << endl;
+} // end report_cascade
+
+
+
+static double print_sigma_eff(string name, double sigma, double sigmaErr,
+                              flipcounts& counts, int nEvent, int copies,
+                              double reference, double referenceErr){
+    // One line: sigma * efficiency in fb, its error (K copies of a pair
+    //  count once), and how many sigma it is from the reference (if there
+    //  is one, reference >= 0). Returns that, 0 if there's no reference
+
+    double sigmaEff = 1e12 * sigma * counts.weights[cutCharge] / nEvent;
+    double relative = 0;
+    if (counts.events[cutCharge] > 0) 
+        relative += double(copies) / counts.events[cutCharge];
+    if (sigma > 0) relative += (sigmaErr / sigma) * (sigmaErr / sigma);
+    double error = sigmaEff * sqrt(relative);
+    cout << name << " \t " << sigmaEff << " +- " << error << " fb";
+    double variance = error * error + referenceErr * referenceErr;
+    double pull = 0;
+    if ((reference >= 0) && (variance > 0)){
+        pull = (sigmaEff - reference) / sqrt(variance);
+        cout << " \t " << pull << " sigma";
+    }
+    cout << endl;
+    return pull;
+} // end print_sigma_eff
+
+
+
+bool validate_cascade(string command_file, int iSR, runoptions options,
+                      flipcounts& cascadeCounts, int nEvent, double seconds,
+                      double sigma, double sigmaErr){
+    // Pythia decays the same stored gluinos once each; the cutflows are
+    //  compared per generated event, the errors binomial-ish from the
+    //  number of events at each stage (the cascade's / copies). Then
+    //  sigma * efficiency three ways: Pythia from scratch (its own
+    //  sigmaGen, forced decays taken back out), Pythia on the stored
+    //  gluinos and the cascade (the stored production's cross section)
+    //  have to agree
+
+    int copies = (options.cascade > 0) ? options.cascade : 1;
+    int nFailed = 0;                    // further apart than maxPull
+    options.cascade  = 0;
+    options.validate = false;
+    options.quiet    = true;
+    if (options.production == "") options.production = "gluinos";
+
+    vector< pair<string, int> > counts;
+    flipresult pythiaRun;
+    signal_efficiency_b(command_file, counts, iSR, 0, &options, &pythiaRun);
+
+    flipcounts& pythiaCounts = pythiaRun.stagecounts;
+    cout << "Cascade validation (fraction of generated events):" << endl;
+    cout << "stage \t\t Pythia \t cascade \t sigma" << endl;
+    for (int iStage = 0; iStage < nCutStages; iStage++){
+        double fPythia = pythiaCounts.weights[iStage] / pythiaRun.nEvent;
+        double fCascade = cascadeCounts.weights[iStage] / nEvent;
+        double variance = 0;
+        if (pythiaCounts.events[iStage] > 0)
+            variance += fPythia * fPythia / pythiaCounts.events[iStage];
+        if (cascadeCounts.events[iStage] > 0)
+            variance += fCascade * fCascade * copies
+                      / cascadeCounts.events[iStage];
+        cout << cutstage_name(iStage) << " \t\t " << fPythia << " \t "
+             << fCascade << " \t ";
+        if (variance > 0){
+            double pull = (fCascade - fPythia) / sqrt(variance);
+            cout << pull;
+            if (fabs(pull) > maxPull) nFailed++;
+        }
+        else cout << "-";
+        cout << endl;
+    }
+    if ((pythiaRun.seconds > 0) && (seconds > 0))
+        cout << "Events per second: Pythia " << pythiaRun.nEvent
+             / pythiaRun.seconds << ", cascade " << nEvent / seconds
+             << endl;
+
+    // ... and Pythia making the gluinos itself
+    options.production = "";
+    flipresult scratchRun;
+    signal_efficiency_b(command_file, counts, iSR, 0, &options, &scratchRun);
+
+    double reference = 1e12 * scratchRun.sigmaGen 
+                     * scratchRun.stagecounts.weights[cutCharge]
+                     / scratchRun.nEvent;
+    double relative = 0;
+    if (scratchRun.stagecounts.events[cutCharge] > 0)
+        relative += 1.0 / scratchRun.stagecounts.events[cutCharge];
+    if (scratchRun.sigmaGen > 0)
+        relative += (scratchRun.sigmaErr / scratchRun.sigmaGen)
+                  * (scratchRun.sigmaErr / scratchRun.sigmaGen);
+    double referenceErr = reference * sqrt(relative);
+
+    cout << "Cross section x efficiency (against Pythia from scratch):"
+         << endl;
+    print_sigma_eff("from scratch", scratchRun.sigmaGen, scratchRun.sigmaErr,
+                    scratchRun.stagecounts, scratchRun.nEvent, 1, -1, 0);
+    double pulls[2];
+    pulls[0] = print_sigma_eff("production=", pythiaRun.sigmaGen, 
+                               pythiaRun.sigmaErr, pythiaCounts,
+                               pythiaRun.nEvent, 1, reference, referenceErr);
+    pulls[1] = print_sigma_eff("cascade=", sigma, sigmaErr, cascadeCounts,
+                               nEvent, copies, reference, referenceErr);
+    for (int i = 0; i < 2; i++)
+        if (fabs(pulls[i]) > maxPull) nFailed++;
+
+    cout << "Cascade validation: " << (nFailed ? "FAILED" : "passed") << ", "
+         << nFailed << " numbers more than " << maxPull << " sigma apart"
+         << endl;
+    return (nFailed == 0);
+} // end validate_cascade
@@ -0,0 +1,135 @@
+// FlipCascade.h
+// A generator of our own for the parton-level runs: the gluino pairs come
+//  from the stored production (FlipProduction.h), and the decays down to
+//  quarks, leptons and hadrons are done here, straight into the event
+//  record the selection reads
+// INCLUDE GUARD
+#ifndef __FLIPCASCADE_H_INCLUDED__
+#define __FLIPCASCADE_H_INCLUDED__
+
+#include "FlipEvent.h"
+#include "FlipBias.h"
+#include <map>
+using namespace std;
+
+// With MPI, ISR, FSR and hadronization off, all Pythia does after the
+//  hard process is decay things: gluino -> t stop*, stop -> b s (UDD),
+//  t -> b W, W -> l nu, and the taus and the hadrons they go to. The
+//  decay tables, masses and widths are Pythia's after init() (so the
+//  SLHA spectrum's, and the forced W decays of FlipBias.h), copied into
+//  a table once. Per event:
+//   - a stored gluino pair, turned by a random angle about the beam
+//   - a channel by branching ratio for everything that decays, the way
+//     Pythia has them switched on; resonances (gluino, stop, top, W)
+//     decay "at process level", the rest (tau, pi0, ...) after
+//   - masses from a Breit-Wigner (cut at mMin, mMax) for anything with a
+//     width; two-body decays isotropic in the rest frame, n-body by flat
+//     phase space (accept-reject), leptonic tau decays with the V-A
+//     matrix element
+//   - the weights of the forced decays, as event_weight would give
+//  and the final state goes into a flipevent as fill_event would have
+//  put it there: visible particles with |eta| < 5, leptons apart, the
+//  first generation after the resonance decays as bpartons.
+// What it doesn't do: spin correlations in the decays (Pythia doesn't
+//  either for these), tau polarization and the hadronic tau currents
+//  (Pythia's are better; the hadrons here share the tau's momentum by
+//  phase space), and anything with showers or hadronization.
+// Every event rolls its own dice (stream cascadeStream), so the events
+//  are the same whatever the pipeline or batching.
+// The K copies of a pair share its gluinos, so they aren't K independent
+//  events: the efficiency is still the mean over all of them, but its
+//  statistics are those of the # of pairs, not of nEvent. The errors
+//  below count each stage's events / K (as if the copies were one event,
+//  which is the safe side), and the bootstrap resamples whole pairs.
+
+static const unsigned int cascadeStream = 1000;    // dice of the decays
+static const double maxPull = 3.0;      // validate_cascade: further apart
+                                        //  than this fails. With ~15
+                                        //  numbers compared, a correct
+                                        //  cascade fails ~4% of the time
+
+struct cascadechannel{
+    double branching;               // cumulative, over the channels on
+    vector<int> products;           // indices into the table
+    bool vminusa;                   // tau -> l nu nu: V-A weighted
+};
+
+struct cascadeparticle{
+    int id;
+    double m0, width, mMin, mMax;
+    bool visible;
+    bool resonance;                 // decays at process level
+    bool decays;
+    double weight;                  // forced decays (FlipBias.h), else 1
+    vector<cascadechannel> channels;
+};
+
+struct cascade4{
+    // four-momentum, without the overhead of a PseudoJet
+    double px, py, pz, e;
+};
+
+struct cascadeitem{
+    // something still to decay, or not
+    int index;                      // into the table
+    bool process;                   // in pythia.process (its mother
+                                    //  decayed at process level)
+    cascade4 p;
+};
+
+struct flipcascade{
+    bool on;
+    int copies;                     // decays of each stored gluino pair
+    string filename;                // the stored production
+    vector<cascade4> gluinos;       // two per stored event
+    int gluinoIndex;                // of 1000021 in the table ...
+    int antigluinoIndex;            // ... and of -1000021 (the same if the
+                                    //  gluino is its own antiparticle)
+    vector<cascadeparticle> table;
+    map<int, int> index;            // id -> table
+    int nEvent;                     // copies * # of stored pairs, but
+                                    //  only the pairs are independent
+
+    // scratch
+    vector<cascadeitem> stack;
+    vector<cascade4> daughters;
+    vector<double> masses;
+    vector<double> systems;         // n-body: masses of what's left to split
+
+    // counts
+    int nDecays;
+    int nFailed;                    // decays that couldn't be done (no room
+                                    //  for the products): left undecayed
+};
+
+
+bool start_cascade(flipcascade&, int, string, Pythia8::Pythia&, flipbias&);
+    // Inputs: cascade, copies (cascade=, 0: off), stored production file,
+    //  pythia (after init), forced decays (after fill_bias_weights)
+    // Reads the gluino pairs and builds the decay table. False (and off)
+    //  if there are no gluinos in the file
+
+void cascade_event(flipcascade&, flipevent&, int, unsigned int);
+    // Inputs: cascade, record to fill, event number, run seed
+    // One event: the stored pair iEvent / copies, decayed. Fills
+    //  everything fill_event would, the weight included
+
+void report_cascade(flipcascade&);
+    // How many pairs (the effective statistics), decays, and decays left
+    //  undone
+
+bool validate_cascade(string, int, runoptions, flipcounts&, int, double,
+                      double, double);
+    // Inputs: command file, signal region, options (cascade= the copies),
+    //  the cascade's cutflow, its nEvent, event loop time, cross section
+    //  and its error (mb)
+    // Runs Pythia on the same stored gluino pairs and prints the two
+    //  cutflows side by side, with how many sigma apart they are; then
+    //  sigma * efficiency of the cascade, of Pythia on the stored gluinos
+    //  and of Pythia from scratch, which all have to agree. Passes (true)
+    //  if every one of those is within maxPull sigma
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPCASCADE_H_INCLUDED__
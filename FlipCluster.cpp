@@ -0,0 +1,147 @@
+/********************************************************************************
+*   FlipCluster.cpp by Flip Tanedo (pt267@cornell.edu)                          *
+*   Anti-kT jets for hadron-level runs (ISR/FSR/MPI/hadronization on),          *
+*   where the visible final state is hundreds of particles instead of a         *
+*   handful of partons. Times each FastJet strategy on the first events of      *
+*   every multiplicity and keeps the fastest, and keeps track of the cost.      *
+********************************************************************************/
+
+#include "FlipCluster.h"
+
+
+static int multiplicity_bin(int nInput){
+    // 0: up to 3, 1: 4-7, 2: 8-15, ..., i.e. floor(log2(N)) - 1
+
+    int bin = 0;
+    while (nInput > 3){
+        nInput /= 2;
+        bin++;
+    }
+    return bin;
+} // end multiplicity_bin
+
+
+
+static string strategy_name(fastjet::Strategy strategy){
+    // For the report
+
+    if (strategy == fastjet::N2Plain)        return "N2Plain";
+    if (strategy == fastjet::N2Tiled)        return "N2Tiled";
+    if (strategy == fastjet::N2MinHeapTiled) return "N2MinHeapTiled";
+    if (strategy == fastjet::NlnN)           return "NlnN";
+    if (strategy == fastjet::Best)           return "Best";
+    return "other";
+} // end strategy_name
+
+
+
+void fill_clusterer(flipclusterer& clusterer, string strategy){
+    // Definitions are built here once, not once per event
+
+    clusterer.R         = 0.5;
+    clusterer.ptmin     = 10.0;
+    clusterer.nWarmup   = 5;
+    clusterer.forced    = -1;
+
+    // NlnN needs CGAL, so it's only used if asked for by name
+    clusterer.strategies.clear();
+    clusterer.strategies.push_back(fastjet::N2Plain);
+    clusterer.strategies.push_back(fastjet::N2Tiled);
+    clusterer.strategies.push_back(fastjet::N2MinHeapTiled);
+
+    if (strategy != "auto"){
+        fastjet::Strategy named = fastjet::Best;
+        if      (strategy == "N2Plain")         named = fastjet::N2Plain;
+        else if (strategy == "N2Tiled")         named = fastjet::N2Tiled;
+        else if (strategy == "N2MinHeapTiled")  named = fastjet::N2MinHeapTiled;
+        else if (strategy == "NlnN")            named = fastjet::NlnN;
+        else if (strategy != "Best")
+            cout << endl << "ERROR: unknown FastJet strategy " << strategy
+                 << ", using Best" << endl;
+        clusterer.strategies.assign(1, named);
+        clusterer.forced = 0;
+    }
+
+    clusterer.definitions.clear();
+    for (unsigned int i = 0; i < clusterer.strategies.size(); i++)
+        clusterer.definitions.push_back(
+            fastjet::JetDefinition(fastjet::antikt_algorithm, clusterer.R,
+                                   fastjet::E_scheme,
+                                   clusterer.strategies[i]));
+
+    clusterer.input.clear();
+    clusterer.jets.clear();
+    clusterer.seconds.clear();
+    clusterer.calls.clear();
+    clusterer.chosen.clear();
+    clusterer.totalSeconds  = 0;
+    clusterer.nClustered    = 0;
+    clusterer.nParticles    = 0;
+} // end fill_clusterer
+
+
+
+void cluster_jets(flipclusterer& clusterer){
+    // Pick a strategy, cluster, time it
+
+    int nCandidates = clusterer.strategies.size();
+    int bin = multiplicity_bin(clusterer.input.size());
+    if (bin >= int(clusterer.chosen.size())){
+        clusterer.seconds.resize(bin+1, vector<double>(nCandidates, 0.0));
+        clusterer.calls.resize(bin+1, vector<int>(nCandidates, 0));
+        clusterer.chosen.resize(bin+1, clusterer.forced);
+    }
+
+    // Still warming up? Take the candidate with the fewest timings.
+    int use = clusterer.chosen[bin];
+    if (use < 0){
+        use = 0;
+        for (int i = 1; i < nCandidates; i++)
+            if (clusterer.calls[bin][i] < clusterer.calls[bin][use]) use = i;
+    }
+
+    double start = wall_seconds();
+    fastjet::ClusterSequence sequence(clusterer.input,
+                                      clusterer.definitions[use]);
+    clusterer.jets = sorted_by_pt(sequence.inclusive_jets(clusterer.ptmin));
+    double elapsed = wall_seconds() - start;
+
+    clusterer.totalSeconds += elapsed;
+    clusterer.nClustered++;
+    clusterer.nParticles += clusterer.input.size();
+
+    if (clusterer.chosen[bin] >= 0) return;
+
+    // Everyone timed often enough? Keep the fastest on average.
+    clusterer.seconds[bin][use] += elapsed;
+    clusterer.calls[bin][use]++;
+    int fastest = 0;
+    for (int i = 0; i < nCandidates; i++){
+        if (clusterer.calls[bin][i] < clusterer.nWarmup) return;
+        if (clusterer.seconds[bin][i] / clusterer.calls[bin][i] <
+            clusterer.seconds[bin][fastest] / clusterer.calls[bin][fastest])
+            fastest = i;
+    }
+    clusterer.chosen[bin] = fastest;
+} // end cluster_jets
+
+
+
+void report_clusterer(flipclusterer& clusterer){
+    // Benchmark output
+
+    if (clusterer.nClustered == 0) return;
+
+    cout << "Clustering: " << 1.0e3 * clusterer.totalSeconds /
+            clusterer.nClustered << " ms per event, "
+         << clusterer.nParticles / clusterer.nClustered
+         << " particles per event" << endl;
+
+    for (unsigned int bin = 0; bin < clusterer.chosen.size(); bin++){
+        if (clusterer.chosen[bin] < 0) continue;
+        cout << "   " << (bin ? (2 << bin) : 0) << "-" << (4 << bin) - 1
+             << " particles: "
+             << strategy_name(clusterer.strategies[clusterer.chosen[bin]])
+             << endl;
+    }
+} // end report_clusterer
@@ -0,0 +1,56 @@
+// FlipCluster.h
+// Hadron-level jets: anti-kT clustering of the visible final state, with
+//  the FastJet strategy picked by timing it on the events as they come
+// INCLUDE GUARD
+#ifndef __FLIPCLUSTER_H_INCLUDED__
+#define __FLIPCLUSTER_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+using namespace std;
+
+struct flipclusterer{
+    // Built once per run and reused for every event: the jet definitions,
+    //  the input and output vectors, and the timing tables.
+    // FastJet's strategies all give the same jets, they only differ in
+    //  how the time scales with the number of particles N. So for every
+    //  multiplicity bin (N between 2^k and 2^(k+1)) each candidate is
+    //  timed on the first nWarmup events, and the fastest one is used
+    //  from then on.
+    double R;                                   // anti-kT radius
+    double ptmin;                               // smallest jet kept
+    vector<fastjet::Strategy> strategies;       // candidates
+    vector<fastjet::JetDefinition> definitions; // one per candidate
+    int forced;                                 // candidate to always use,
+                                                //  or -1: pick by timing
+    int nWarmup;                                // timings per candidate
+
+    vector<fastjet::PseudoJet> input;           // reused every event
+    vector<fastjet::PseudoJet> jets;
+
+    // per multiplicity bin
+    vector< vector<double> > seconds;           // time per candidate
+    vector< vector<int> > calls;                // # timings per candidate
+    vector<int> chosen;                         // -1 until warmed up
+
+    // benchmark
+    double totalSeconds;                        // spent in FastJet
+    int nClustered;                             // # events clustered
+    double nParticles;                          // # particles clustered
+};
+
+
+void fill_clusterer(flipclusterer&, string);
+    // Anti-kT with R = 0.5 and 10 GeV minimum jet pT. Input: strategy name,
+    //  "auto" to pick by timing, or N2Plain, N2Tiled, N2MinHeapTiled,
+    //  NlnN (needs FastJet with CGAL), Best
+
+void cluster_jets(flipclusterer&);
+    // Clusters clusterer.input into clusterer.jets (sorted by pT)
+
+void report_clusterer(flipclusterer&);
+    // Prints the clustering cost per event and the strategies chosen
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPCLUSTER_H_INCLUDED__
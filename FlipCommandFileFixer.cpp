@@ -119,3 +119,47 @@ bool  FixCommand(                     // TRUE if successful
             
 }
 
+
+
+bool  FixMassPoint(                   // TRUE if all three files were written
+        std::string &cmndtemp,        // template command file
+        std::string &cmndrun,         // output command file for the run
+        std::string &spctemp,         // template spectrum file
+        std::string &spcint,          // intermediate spectrum file
+        std::string &spcrun,          // output spectrum file for the run
+        std::string &mstop,           // stop mass, as it goes into the spc
+        std::string &mgluino){        // gluino mass, as it goes into the spc
+    
+    // This is the templating that used to live in PartonRPV.cc's main
+    
+    string cmndspc      = "SLHA:file = ";       // line to change in cmnd file
+    string cmndspcnew   = cmndspc + spcrun;     // ... replace with this
+    string blockmass    = "BLOCK MASS";         
+    string blockdiv     = "BLOCK";
+    string gluinoID     = "1000021";
+    string stopID       = "1000006";
+    string gluinoNew    = "   1000021   " + mgluino;    // line replacement
+    string stopNew      = "   1000006   " + mstop;      // line replacement
+    
+    bool success = true;
+    
+    // Make sure command file is using the same spc file that we're creating
+    if(!FixCommand(cmndtemp, cmndrun, cmndspc, cmndspcnew)){
+        cout << endl << " ERROR in FixCommand, setting " << cmndspcnew << endl;
+        success = false;
+    }
+    
+    // Using template spectrum, set gluino mass. Save to intermediate spectrum
+    if(!FixSpectrum(spctemp, spcint, blockmass, blockdiv, gluinoID, gluinoNew)){
+        cout << endl << "ERROR: FixSpectrum, setting mass " << gluinoNew << endl;
+        success = false;
+    }
+    
+    // Using intermediate spectrum, set stop mass. Save to final spectrum
+    if(!FixSpectrum(spcint, spcrun, blockmass, blockdiv, stopID, stopNew)){
+        cout << endl << "ERROR: FixSpectrum, setting mass " << stopNew << endl;
+        success = false;
+    }
+    
+    return success;
+}
@@ -1,8 +1,8 @@
 // FlipCommandFileFixer.h
 // For modifying Pythia Command Files
 // INCLUDE GUARD
-// #ifndef __FLIPCOMMANDFILEFIXER_H_INCLUDED__
-// #define __FLIPCOMMANDFILEFIXER_H_INCLUDED__
+#ifndef __FLIPCOMMANDFILEFIXER_H_INCLUDED__
+#define __FLIPCOMMANDFILEFIXER_H_INCLUDED__
 
 #include <string>              
 #include <sstream>              // for string stream
@@ -58,7 +58,23 @@ bool  FixCommand(                     // TRUE if successful
 //  entire line with something else (e.g. "SLHA:file = different.spc").
 
 
+bool  FixMassPoint(                   // TRUE if all three files were written
+        std::string &cmndtemp,        // template command file
+        std::string &cmndrun,         // output command file for the run
+        std::string &spctemp,         // template spectrum file
+        std::string &spcint,          // intermediate spectrum file
+        std::string &spcrun,          // output spectrum file for the run
+        std::string &mstop,           // stop mass, e.g. '300'
+        std::string &mgluino);        // gluino mass, e.g. '800'
+//
+// Usage: does the whole templating for one (mstop, mglu) point. Points the
+//  command file at spcrun with FixCommand, then writes the gluino mass into
+//  spcint and the stop mass into spcrun with FixSpectrum. This is what
+//  PartonRPV does before every run, and what the adaptive scan does before
+//  every point it samples.
+
+
 
 // END INCLUDE GUARD
-// #endif // __FLIPCOMMANDFILEFIXER_H_INCLUDED__
+#endif // __FLIPCOMMANDFILEFIXER_H_INCLUDED__
 
@@ -0,0 +1,541 @@
+/********************************************************************************
+*   FlipDataset.cpp by Flip Tanedo (pt267@cornell.edu)                          *
+*   Background datasets: many LHE files, one combined yield per signal region.  *
+*   - the manifest, the per-sample keys and seeds                               *
+*   - the cache: one small file per sample, named after its key                 *
+*   - the work queue: worker threads take the biggest file left                 *
+********************************************************************************/
+
+#include "FlipDataset.h"
+#include "FlipLHE.h"                        // getnevents
+#include <sys/stat.h>                       // stat, mkdir
+#include <unistd.h>                         // getpid
+#include <cstdio>                           // remove
+#include <algorithm>                        // sort
+#include <cctype>                           // isalnum
+
+
+static string read_file(string filename){
+    // The whole file, "" if it isn't there
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+} // end read_file
+
+
+
+static int count_events(string filename){
+    // MadGraph puts "nevents" in the header; anything else gets counted
+    int nEvents = getnevents(filename);
+    if (nEvents > 0) return nEvents;
+
+    ifstream in(filename.c_str());
+    string line;
+    while (getline(in, line))
+        if (line.find("<event") != string::npos) nEvents++;
+    return nEvents;
+} // end count_events
+
+
+
+void fill_dataset(flipdataset& dataset){
+    // Same as PartonBGRPV's defaults, one thread
+
+    dataset.manifest    = "";
+    dataset.samples.clear();
+    dataset.commandFile = "background.cmnd";
+    dataset.signalRegions.clear();
+    dataset.signalRegions.push_back(8);
+    dataset.cacheDir    = "bgcache";
+    dataset.scratchDir  = "/tmp";
+    dataset.nWorkers    = 1;
+    dataset.lumi        = 10.5;             // SUS-12-017
+    fill_runoptions(dataset.options);
+    dataset.queue.clear();
+    dataset.next        = 0;
+} // end fill_dataset
+
+
+
+bool read_datasetoption(flipdataset& dataset, string argument){
+    // key=value, like read_runoption
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    if      (key == "workers")  dataset.nWorkers = atoi(value.c_str());
+    else if (key == "cache")    dataset.cacheDir = (value == "none") ? ""
+                                                                     : value;
+    else if (key == "lumi")     dataset.lumi     = atof(value.c_str());
+    else return false;
+
+    if (dataset.nWorkers < 1) dataset.nWorkers = 1;
+    return true;
+} // end read_datasetoption
+
+
+
+bool read_manifest(flipdataset& dataset, string filename){
+    // file sigma [label], see FlipDataset.h
+
+    dataset.manifest = filename;
+    dataset.samples.clear();
+
+    ifstream in(filename.c_str());
+    if (!in.is_open()){
+        cout << endl << "ERROR: can't read the manifest " << filename << endl;
+        return false;
+    }
+
+    bool ok = true;
+    string line;
+    while (getline(in, line)){
+        size_t hash = line.find('#');
+        if (hash != string::npos) line = line.substr(0, hash);
+
+        stringstream words(line);
+        string file, sigma, label;
+        if (!(words >> file)) continue;         // blank line
+        words >> sigma >> label;
+
+        flipsample sample;
+        sample.file     = file;
+        sample.label    = (label == "") ? file : label;
+        sample.sigma    = (sigma == "-") ? 0.0 : atof(sigma.c_str());
+        sample.nEvents  = count_events(file);
+        sample.seed     = 0;
+        sample.ok       = false;
+        sample.cached   = false;
+        sample.runTime  = 0;
+        sample.sigmaGen = 0;
+        sample.nEvent   = 0;
+
+        if ((sigma == "") || (sample.sigma < 0) || (sample.nEvents <= 0)){
+            cout << endl << "ERROR: manifest line \"" << line << "\": "
+                 << ((sample.nEvents <= 0) ? "no events in the file"
+                                           : "no cross section") << endl;
+            ok = false;
+            continue;
+        }
+        dataset.samples.push_back(sample);
+    }
+
+    if (dataset.samples.empty()){
+        cout << endl << "ERROR: nothing to run in " << filename << endl;
+        return false;
+    }
+    return ok;
+} // end read_manifest
+
+
+
+/********************************************************************************
+*   Keys and the cache                                                          *
+********************************************************************************/
+
+static void fill_key(flipdataset& dataset, flipsample& sample,
+                     string& commandText){
+    // Everything the sample's numbers depend on, as one line
+
+    struct stat info;
+    long size = 0, modified = 0;
+    if (stat(sample.file.c_str(), &info) == 0){
+        size = (long) info.st_size;
+        modified = (long) info.st_mtime;
+    }
+
+    sample.seed = hash_string(sample.file, 2166136261u ^ dataset.options.seed);
+    if (sample.seed == 0) sample.seed = 1;  // 0 would mean rand()
+
+    stringstream key;
+    key << "file=" << sample.file << " size=" << size
+        << " modified=" << modified
+        << " cmnd=" << hex << hash_string(commandText) << dec
+        << " regions=";
+    for (unsigned int i = 0; i < dataset.signalRegions.size(); i++)
+        key << (i > 0 ? "," : "") << dataset.signalRegions[i];
+    key << " seed=" << sample.seed
+        << " force=" << dataset.options.forced
+        << " hadron=" << dataset.options.hadron
+        << " strategy=" << dataset.options.strategy
+        << " veto=" << dataset.options.veto
+        << " isogrid=" << dataset.options.isoGrid
+        << " vary=" << dataset.options.variations
+        << " maps=" << dataset.options.maps;
+    if (dataset.options.maps != "")         // the maps, not just the name
+        key << ":" << hex << hash_string(read_file(dataset.options.maps))
+            << dec;
+    sample.key = key.str();
+} // end fill_key
+
+
+
+static string cache_file(flipdataset& dataset, flipsample& sample){
+    // cacheDir/sample_<hash of the key>.dat
+    stringstream name;
+    name << dataset.cacheDir << "/sample_" << hex << setw(8) << setfill('0')
+         << hash_string(sample.key) << ".dat";
+    return name.str();
+} // end cache_file
+
+
+
+static bool read_cache(flipdataset& dataset, flipsample& sample){
+    // Only if the key in the file is this sample's key, word for word
+
+    if (dataset.cacheDir == "") return false;
+    ifstream in(cache_file(dataset, sample).c_str());
+    if (!in.is_open()) return false;
+
+    string line;
+    if (!getline(in, line) || (line != "key " + sample.key)) return false;
+
+    string word;
+    int nRegions = 0;
+    in >> word >> sample.sigmaGen >> word >> sample.nEvent
+       >> word >> nRegions;
+    if (!in || (nRegions != (int) dataset.signalRegions.size())) return false;
+
+    sample.efficiencies.assign(nRegions, 0.0);
+    sample.cutflows.resize(nRegions);
+    for (int iSR = 0; iSR < nRegions; iSR++){
+        int region = -1;
+        in >> word >> region >> sample.efficiencies[iSR];
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            in >> sample.cutflows[iSR].events[iStage];
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            in >> sample.cutflows[iSR].weights[iStage];
+        if (!in || (region != dataset.signalRegions[iSR])) return false;
+    }
+
+    sample.ok = true;
+    sample.cached = true;
+    return true;
+} // end read_cache
+
+
+
+static void write_cache(flipdataset& dataset, flipsample& sample){
+    // key, then the numbers. Written to a temporary name and renamed, so
+    //  an interrupted run never leaves half a file behind
+
+    if (dataset.cacheDir == "") return;
+    string filename = cache_file(dataset, sample);
+    string temporary = filename + ".tmp";
+
+    ofstream out(temporary.c_str());
+    out << setprecision(17);
+    out << "key " << sample.key << endl;
+    out << "sigmaGen_mb " << sample.sigmaGen << endl;
+    out << "nEvent " << sample.nEvent << endl;
+    out << "regions " << dataset.signalRegions.size() << endl;
+    for (unsigned int iSR = 0; iSR < dataset.signalRegions.size(); iSR++){
+        out << "SR " << dataset.signalRegions[iSR] << " "
+            << sample.efficiencies[iSR];
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            out << " " << sample.cutflows[iSR].events[iStage];
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            out << " " << sample.cutflows[iSR].weights[iStage];
+        out << endl;
+    }
+    out.close();
+    rename(temporary.c_str(), filename.c_str());
+} // end write_cache
+
+
+
+/********************************************************************************
+*   One sample, and the threads that run them                                   *
+********************************************************************************/
+
+static string safe_label(flipsample& sample){
+    // The label as part of a file name: one that's the file's name loses
+    //  its directories and .lhe, anything but letters, digits and +-_.
+    //  becomes _
+    string label = sample.label;
+    if (label == sample.file){
+        size_t slash = label.rfind('/');
+        if (slash != string::npos) label = label.substr(slash + 1);
+        size_t dot = label.rfind('.');
+        if ((dot != string::npos) && (dot > 0)) label = label.substr(0, dot);
+    }
+    for (unsigned int i = 0; i < label.size(); i++)
+        if (!isalnum(label[i]) && (string("+-_.").find(label[i]) ==
+                                   string::npos))
+            label[i] = '_';
+    if ((label == "") || (label == ".") || (label == "..")) label = "_";
+    return label;
+} // end safe_label
+
+
+
+static string skim_label(flipdataset& dataset, int iSample){
+    // safe_label, and the sample's number after it if another sample's
+    //  comes out the same, so no two samples write one skim
+
+    string label = safe_label(dataset.samples[iSample]);
+    for (unsigned int i = 0; i < dataset.samples.size(); i++){
+        if ((int(i) == iSample) ||
+            (safe_label(dataset.samples[i]) != label)) continue;
+        stringstream numbered;
+        numbered << label << "_" << iSample;
+        return numbered.str();
+    }
+    return label;
+} // end skim_label
+
+
+
+static void run_sample(flipdataset& dataset, int iSample){
+    // The command file plus the LHE input, signal_efficiency_b on it
+
+    flipsample& sample = dataset.samples[iSample];
+
+    stringstream name;
+    name << dataset.scratchDir << "/flipbg_" << getpid() << "_" << iSample
+         << ".cmnd";
+    string cmndrun = name.str();
+
+    // later lines win, so the LHE settings go at the end
+    ofstream cmnd(cmndrun.c_str());
+    cmnd << read_file(dataset.commandFile) << endl
+         << "! dataset " << dataset.manifest << ", " << sample.label << endl
+         << "Beams:frameType = 4" << endl
+         << "Beams:LHEF = " << sample.file << endl
+         << "Main:numberOfEvents = " << sample.nEvents << endl
+         << "Random:setSeed = on" << endl
+         << "Random:seed = " << 1 + sample.seed % 900000000u << endl;
+    cmnd.close();
+
+    runoptions options = dataset.options;
+    options.seed  = sample.seed;
+    options.quiet = true;
+
+    // skim=: a file per sample, the label before the extension (after
+    //  the last '/', so a skimfile=dir/bg without one stays in dir)
+    if (options.skim != ""){
+        size_t dot = options.skimFile.rfind('.');
+        size_t slash = options.skimFile.rfind('/');
+        if ((dot == string::npos) || ((slash != string::npos) &&
+                                      (dot < slash)))
+            dot = options.skimFile.size();
+        options.skimFile = options.skimFile.substr(0, dot) + "_"
+                         + skim_label(dataset, iSample)
+                         + options.skimFile.substr(dot);
+    }
+    stringstream regions;
+    for (unsigned int i = 1; i < dataset.signalRegions.size(); i++)
+        regions << (i > 1 ? "," : "") << dataset.signalRegions[i];
+    options.regions = regions.str();
+
+    double startTime = wall_seconds();
+    vector< pair<string, int> > counts;
+    flipresult run;
+    double efficiency = signal_efficiency_b(cmndrun, counts,
+                                            dataset.signalRegions[0], 0,
+                                            &options, &run);
+    remove(cmndrun.c_str());
+
+    // the other signal regions are the last variations
+    sample.efficiencies.clear();
+    sample.cutflows.clear();
+    sample.efficiencies.push_back(efficiency);
+    sample.cutflows.push_back(run.stagecounts);
+    int first = run.varied.size() - (dataset.signalRegions.size() - 1);
+    for (unsigned int i = first; i < run.varied.size(); i++){
+        sample.efficiencies.push_back(run.varied[i].weights[cutCharge]
+                                      / double(run.nEvent));
+        sample.cutflows.push_back(run.varied[i]);
+    }
+    sample.sigmaGen = run.sigmaGen;
+    sample.nEvent   = run.nEvent;
+    sample.runTime  = wall_seconds() - startTime;
+    sample.ok       = true;
+
+    write_cache(dataset, sample);
+} // end run_sample
+
+
+
+static void* dataset_thread(void* argument){
+    // Takes the next sample off the queue until there are none left
+
+    flipdataset& dataset = *(flipdataset*) argument;
+
+    while (true){
+        pthread_mutex_lock(&dataset.lock);
+        int iSample = -1;
+        if (dataset.next < dataset.queue.size())
+            iSample = dataset.queue[dataset.next++];
+        pthread_mutex_unlock(&dataset.lock);
+        if (iSample < 0) break;
+
+        run_sample(dataset, iSample);
+
+        flipsample& sample = dataset.samples[iSample];
+        pthread_mutex_lock(&dataset.lock);
+        cout << "  done " << sample.label << ": " << sample.nEvents
+             << " events in " << sample.runTime << " s" << endl;
+        pthread_mutex_unlock(&dataset.lock);
+    }
+    return 0;
+} // end dataset_thread
+
+
+
+static bool bigger_first(const pair<int, int>& a, const pair<int, int>& b){
+    // (# events, sample): most events first, then manifest order
+    if (a.first != b.first) return a.first > b.first;
+    return a.second < b.second;
+} // end bigger_first
+
+
+
+int run_dataset(flipdataset& dataset){
+    // Cache first, then a queue of what's left, biggest first
+
+    vector<signalregion> signal_region;
+    fill_signalregions(signal_region);
+    for (unsigned int i = 0; i < dataset.signalRegions.size(); i++)
+        if ((dataset.signalRegions[i] < 0) ||
+            (dataset.signalRegions[i] >= (int) signal_region.size())){
+            cout << endl << "ERROR: there's no signal region "
+                 << dataset.signalRegions[i] << endl;
+            return -1;
+        }
+
+    string commandText = read_file(dataset.commandFile);
+    if (dataset.cacheDir != "") mkdir(dataset.cacheDir.c_str(), 0755);
+
+    vector< pair<int, int> > sizes;
+    for (unsigned int i = 0; i < dataset.samples.size(); i++){
+        fill_key(dataset, dataset.samples[i], commandText);
+        if (!read_cache(dataset, dataset.samples[i]))
+            sizes.push_back(make_pair(dataset.samples[i].nEvents, (int) i));
+    }
+    sort(sizes.begin(), sizes.end(), bigger_first);
+
+    dataset.queue.clear();
+    for (unsigned int i = 0; i < sizes.size(); i++)
+        dataset.queue.push_back(sizes[i].second);
+    dataset.next = 0;
+
+    cout << "Dataset " << dataset.manifest << ": "
+         << dataset.samples.size() << " samples, "
+         << dataset.samples.size() - dataset.queue.size()
+         << " from the cache, " << dataset.queue.size() << " to run (workers="
+         << dataset.nWorkers << ")" << endl;
+    if (dataset.queue.empty()) return 0;
+
+    // this thread is one of the workers
+    pthread_mutex_init(&dataset.lock, 0);
+    int nThreads = min(dataset.nWorkers, (int) dataset.queue.size()) - 1;
+    vector<pthread_t> threads(nThreads);
+    for (int i = 0; i < nThreads; i++)
+        if (pthread_create(&threads[i], 0, dataset_thread, &dataset)){
+            threads.resize(i);          // the rest run on the ones we have
+            break;
+        }
+    dataset_thread(&dataset);
+    for (unsigned int i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], 0);
+    pthread_mutex_destroy(&dataset.lock);
+
+    return dataset.queue.size();
+} // end run_dataset
+
+
+
+/********************************************************************************
+*   The numbers                                                                 *
+********************************************************************************/
+
+static double sample_sigma(flipsample& sample){
+    // pb, the manifest's or else Pythia's
+    return (sample.sigma > 0) ? sample.sigma : sample.sigmaGen * 1e9;
+} // end sample_sigma
+
+
+
+static void sum_yield(flipdataset& dataset, int iSR, double& yield,
+                      double& error){
+    // sigma * efficiency (fb) summed over the samples. The error is the
+    //  MC statistics: each sample's yield / sqrt(# events that passed)
+
+    yield = 0;
+    error = 0;
+    for (unsigned int i = 0; i < dataset.samples.size(); i++){
+        flipsample& sample = dataset.samples[i];
+        if (!sample.ok) continue;
+        double part = 1000.0 * sample_sigma(sample) * sample.efficiencies[iSR];
+        int nPassed = sample.cutflows[iSR].events[cutCharge];
+        yield += part;
+        if (nPassed > 0) error += part * part / nPassed;
+    }
+    error = sqrt(error);
+} // end sum_yield
+
+
+
+void report_dataset(flipdataset& dataset){
+    // e.g. "ttW+   SR 8:  0.00125   0.186 fb"
+
+    cout << endl << "Background dataset " << dataset.manifest
+         << " (" << dataset.commandFile << ")" << endl;
+    for (unsigned int i = 0; i < dataset.samples.size(); i++){
+        flipsample& sample = dataset.samples[i];
+        cout << sample.label << " (" << sample.file << ", "
+             << sample_sigma(sample) << " pb, " << sample.nEvents
+             << " events" << (sample.cached ? ", cached" : "") << ")" << endl;
+        if (!sample.ok){
+            cout << "  didn't run" << endl;
+            continue;
+        }
+        for (unsigned int iSR = 0; iSR < dataset.signalRegions.size(); iSR++)
+            cout << "  SR " << dataset.signalRegions[iSR] << ":\t"
+                 << sample.efficiencies[iSR] << "\t"
+                 << 1000.0 * sample_sigma(sample) * sample.efficiencies[iSR]
+                 << " fb\t(" << sample.cutflows[iSR].events[cutCharge]
+                 << " events passed)" << endl;
+    }
+
+    cout << "Total at " << dataset.lumi << " fb^-1:" << endl;
+    for (unsigned int iSR = 0; iSR < dataset.signalRegions.size(); iSR++){
+        double yield, error;
+        sum_yield(dataset, iSR, yield, error);
+        cout << "  SR " << dataset.signalRegions[iSR] << ":\t" << yield
+             << " +- " << error << " fb\t" << yield * dataset.lumi
+             << " +- " << error * dataset.lumi << " events" << endl;
+    }
+} // end report_dataset
+
+
+
+void write_dataset(flipdataset& dataset, string filename){
+    // label SR sigma(pb) efficiency yield(fb), then total SR - - yield
+
+    ofstream out(filename.c_str(), ios::app);
+    out.precision(6);
+    out << "# " << dataset.manifest << ": label SR sigma(pb) efficiency "
+        << "sigma*efficiency(fb)" << endl;
+    for (unsigned int i = 0; i < dataset.samples.size(); i++){
+        flipsample& sample = dataset.samples[i];
+        if (!sample.ok) continue;
+        for (unsigned int iSR = 0; iSR < dataset.signalRegions.size(); iSR++)
+            out << sample.label << "\t" << dataset.signalRegions[iSR] << "\t"
+                << sample_sigma(sample) << "\t" << sample.efficiencies[iSR]
+                << "\t"
+                << 1000.0 * sample_sigma(sample) * sample.efficiencies[iSR]
+                << endl;
+    }
+    for (unsigned int iSR = 0; iSR < dataset.signalRegions.size(); iSR++){
+        double yield, error;
+        sum_yield(dataset, iSR, yield, error);
+        out << "total\t" << dataset.signalRegions[iSR] << "\t-\t-\t" << yield
+            << endl;
+    }
+    out.close();
+} // end write_dataset
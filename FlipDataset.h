@@ -0,0 +1,98 @@
+// FlipDataset.h
+// Backgrounds from several LHE files at once: a manifest of files and
+//  cross sections, a pool of threads working through them (largest file
+//  first), results cached per file, yields per signal region at the end
+// INCLUDE GUARD
+#ifndef __FLIPDATASET_H_INCLUDED__
+#define __FLIPDATASET_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+#include "FlipEvent.h"
+#include <pthread.h>                        // worker threads
+using namespace std;
+
+// The manifest, one LHE file per line, # for comments:
+//
+//      # file              sigma (pb)      label
+//      eventsplus.lhe      0.1487          ttW+
+//      eventsminus.lhe     0.0636          ttW-
+//      ttZ.lhe             -               ttZ
+//
+// A cross section of - (or 0) means the one Pythia reads from the file.
+//  The label is only for the table and the skim names, the file name if
+//  there isn't one (in skim names without its directories and .lhe, and
+//  with anything but letters, digits and +-_. made _).
+
+struct flipsample{
+    // One file of the manifest, and what came out of it
+    string file;                        // LHE file
+    string label;
+    double sigma;                       // cross section (pb), 0: the LHE's
+    int nEvents;                        // # events in the file
+    unsigned int seed;                  // dice and Pythia seed (see below)
+    string key;                         // everything the result depends on
+    bool ok;                            // ran, or came out of the cache
+    bool cached;                        // came out of the cache
+    double runTime;                     // seconds it took (0 if cached)
+    double sigmaGen;                    // Pythia's cross section (mb)
+    int nEvent;                         // # events the efficiency is per
+    vector<double> efficiencies;        // per signal region, weighted
+    vector<flipcounts> cutflows;        // per signal region
+};
+
+struct flipdataset{
+    // Every sample is a signal_efficiency_b run of its own (quiet, with
+    //  the other signal regions as regions=), on one of nWorkers threads.
+    //  The samples go out biggest first, so one big file doesn't start
+    //  last and keep everyone waiting.
+    // Each sample's dice come from the run seed (seed=, 0 if not given)
+    //  and its file name, so the same manifest gives the same numbers
+    //  every time, and a sample's result can be kept. The cache file is
+    //  named after a hash of the key: file name, size and modification
+    //  time, the command file, the signal regions, the seed and the
+    //  options that change the answer. Add a file to the manifest and
+    //  only that file runs; touch a file and it runs again.
+    string manifest;
+    vector<flipsample> samples;
+    string commandFile;                 // as PartonBGRPV's [command]
+    vector<int> signalRegions;          // the first is PartonBGRPV's [SR]
+    string cacheDir;                    // "": no cache
+    string scratchDir;                  // per-sample command files
+    int nWorkers;
+    double lumi;                        // fb^-1, for the # events
+    runoptions options;                 // forced decays etc. (quiet)
+    vector<int> queue;                  // samples to run, biggest first
+    unsigned int next;                  // next one to hand out
+    pthread_mutex_t lock;               // next, and the progress lines
+};
+
+
+void fill_dataset(flipdataset&);
+    // Defaults: background.cmnd, SR 8, cache in bgcache/, scratch in
+    //  /tmp, 1 worker, 10.5 fb^-1 (SUS-12-017), default runoptions
+
+bool read_datasetoption(flipdataset&, string);
+    // workers=N, cache=dir (cache=none: no cache), lumi=L.
+    //  Returns false if it isn't one of those
+
+bool read_manifest(flipdataset&, string);
+    // Reads the samples. Returns false if the file can't be read, has
+    //  nothing in it, or a line doesn't make sense
+
+int run_dataset(flipdataset&);
+    // Takes what it can from the cache and runs the rest.
+    //  Returns the number of samples that ran (not cached), -1 if one of
+    //  the signal regions doesn't exist
+
+void report_dataset(flipdataset&);
+    // Per sample and signal region: efficiency and cross section after
+    //  cuts; then the sum, in fb and in events at lumi
+
+void write_dataset(flipdataset&, string);
+    // Appends the same numbers to a file, one line per sample and signal
+    //  region, then one per signal region for the sum
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPDATASET_H_INCLUDED__
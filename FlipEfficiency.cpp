@@ -7,6 +7,20 @@
 #include "FlipEfficiency.h"
 
 
+static effparams make_effparams(){
+    // so that the default parameters can be a static const below
+    effparams params;
+    fill_effparams(params);
+    return params;
+}
+
+static const effparams& default_effparams(){
+    // the SUS-12-017 numbers, used by the pair<int, PseudoJet> helpers
+    static const effparams params = make_effparams();
+    return params;
+}
+
+
 void read_count(vector< pair<string, int> > count){
     // outputs the contents of count to screen
     
@@ -30,10 +44,14 @@ void fill_vector(vector< pair<string, int> > &count, string line, int num){
 double get_deltaR(fastjet::PseudoJet vec1, fastjet::PseudoJet vec2){
     // outputs the Delta_R between two four-momenta (pseudoJets)
 
-    double phi1 = vec1.phi();
-    double eta1 = vec1.eta();
-    double phi2 = vec2.phi();
-    double eta2 = vec2.eta();
+    return get_deltaR(vec1.eta(), vec1.phi(), vec2.eta(), vec2.phi());
+} // end get_deltaR
+
+
+
+double get_deltaR(double eta1, double phi1, double eta2, double phi2){
+    // same thing, from eta and phi directly
+    // note: phi is not wrapped around, as it never was
 
     double Rsq = pow(phi2-phi1,2) + pow(eta2-eta1,2);
     return sqrt(Rsq);
@@ -47,24 +65,33 @@ double get_deltaR(fastjet::PseudoJet vec1, fastjet::PseudoJet vec2){
 bool lepton_kinematic_cut(pair<int, fastjet::PseudoJet> lepton){
     // returns true if a lepton passes the kinematic cuts
     
+    return lepton_kinematic_cut(lepton.first, lepton.second.pt(), 
+                                lepton.second.eta(), default_effparams());
+        
+} // end lepton_kinematic_cut
+
+
+
+bool lepton_kinematic_cut(int id, double pt, double eta, 
+                          const effparams& params){
+    // returns true if a lepton passes the kinematic cuts
+    
     // LEPTON KINEMATIC CUT PARAMETERS
-    double electron_pT  = 20.0;
-    double muon_pT      = 20.0;
-    double lepton_eta   = 2.4;
-    double eta_bar   = 1.442;
-    double eta_end   = 1.566;
+    double electron_pT  = params.electron_pT;
+    double muon_pT      = params.muon_pT;
+    double lepton_eta   = params.lepton_eta;
+    double eta_bar      = params.eta_bar;
+    double eta_end      = params.eta_end;
     
     bool passes = false;
-    int id = lepton.first;
-    fastjet::PseudoJet momentum = lepton.second;
     
-    bool pass_pT =  ((abs(id) == 11) && (momentum.pt() >= electron_pT)) ||
-                    ((abs(id) == 13) && (momentum.pt() >= muon_pT));
+    bool pass_pT =  ((abs(id) == 11) && (pt >= electron_pT)) ||
+                    ((abs(id) == 13) && (pt >= muon_pT));
                     
-    bool pass_eta = ((abs(id) == 13) && (abs(momentum.eta()) < lepton_eta)) ||
-                    ((abs(id) == 11) && (abs(momentum.eta()) < eta_bar)) ||
-                    ((abs(id) == 11) && (abs(momentum.eta()) > eta_end)
-                                     && (abs(momentum.eta()) < lepton_eta));
+    bool pass_eta = ((abs(id) == 13) && (abs(eta) < lepton_eta)) ||
+                    ((abs(id) == 11) && (abs(eta) < eta_bar)) ||
+                    ((abs(id) == 11) && (abs(eta) > eta_end)
+                                     && (abs(eta) < lepton_eta));
                                      
     if (pass_pT && pass_eta) passes = true;
     
@@ -79,16 +106,24 @@ bool jet_kinematic_cut(pair<int, fastjet::PseudoJet> jet){
     // note that in SUS-12-017 the jet and bjet kin cuts are the same
     //  so I haven't written a separate bjet_kinematic_cut function
     
-    // LEPTON KINEMATIC CUT PARAMETERS
-    double jet_pT   = 40.0;
-    double jet_eta  = 2.4;
+    return jet_kinematic_cut(jet.second.pt(), jet.second.eta(), 
+                             default_effparams());
+        
+} // end jet_kinematic_cut
+
+
+
+bool jet_kinematic_cut(double pt, double eta, const effparams& params){
+    // returns true if a jet passes the kinematic cuts
+    
+    // JET KINEMATIC CUT PARAMETERS
+    double jet_pT   = params.jet_pT;
+    double jet_eta  = params.jet_eta;
     
     bool passes = false;
-    // int id = jet.first; 
-    fastjet::PseudoJet momentum = jet.second;
     
-    bool pass_pT    = (momentum.pt() >= jet_pT);                    
-    bool pass_eta   = (abs(momentum.eta()) < jet_eta);
+    bool pass_pT    = (pt >= jet_pT);                    
+    bool pass_eta   = (abs(eta) < jet_eta);
                                      
     if (pass_pT && pass_eta) passes = true;    
     
@@ -149,15 +184,25 @@ bool lepton_selection_cut(pair<int, fastjet::PseudoJet> lepton){
 bool lepton_ID_eff(pair<int, fastjet::PseudoJet> lepton){
     // Lepton ID efficiency
     
-    bool passes = false;
     double random = (double)rand()/(double)RAND_MAX; // random from 0 to 1
     
+    return lepton_ID_eff(lepton.first, random, default_effparams());
+    
+} // end lepton_ID_eff
+
+
+
+bool lepton_ID_eff(int id, double random, const effparams& params){
+    // Lepton ID efficiency, with the dice already rolled
+    
+    bool passes = false;
+    
     // LEPTON EFFICIENCY PARAMETERS
 
     double IDefficiency = 0.0;     
     
-    if (abs(lepton.first) == 11) IDefficiency = 0.76;   // electron    
-    if (abs(lepton.first) == 13) IDefficiency = 0.86;   // muon
+    if (abs(id) == 11) IDefficiency = params.ID_e;      // electron    
+    if (abs(id) == 13) IDefficiency = params.ID_mu;     // muon
     
     if (random < IDefficiency) passes = true;
 
@@ -172,18 +217,16 @@ bool lepton_iso_eff(    pair<int, fastjet::PseudoJet> lepton,
                         vector< pair<int, fastjet::PseudoJet> > partons){
     // Lepton isolation efficiency
     
-    bool passes = false;
+    const effparams& params = default_effparams();
     double cone_pT = 0;
-    double lepton_dR  = 0.3; // lepton delta R
-    double Iiso       = 0.15;
+    double lepton_dR  = params.lepton_dR; // lepton delta R
     
     for (unsigned int iJet = 0; iJet < partons.size(); iJet++) {
         if (get_deltaR(lepton.second, partons[iJet].second) < lepton_dR)
             cone_pT += partons[iJet].second.pt();
     } // end loop over parton
     
-    if (cone_pT < Iiso*lepton.second.pt() ) passes = true;
-    return passes;
+    return lepton_iso_eff(lepton.second.pt(), cone_pT, params);
 
     
                             
@@ -191,26 +234,51 @@ bool lepton_iso_eff(    pair<int, fastjet::PseudoJet> lepton,
 
 
 
+bool lepton_iso_eff(double pt, double cone_pT, const effparams& params){
+    // Lepton isolation, once the pT in the cone has been summed up
+    
+    bool passes = false;
+    double Iiso       = params.Iiso;
+    
+    if (cone_pT < Iiso*pt ) passes = true;
+    return passes;
+    
+} // end lepton_iso_eff
+
+
+
 
 
 bool b_selection_efficiency(pair<int, fastjet::PseudoJet> bjet){
     // based on efficiencies, randomly determines if
     // a generated bjet is successfully tagged
     
-    bool passes = false;
     // int random = rand() % 1001; // random number from 0 to 1000
     double random = (double)rand()/(double)RAND_MAX; // random from 0 to 1
     
+    return b_selection_efficiency(bjet.second.pt(), random, 
+                                  default_effparams());
+} // end tag_b
+
+
+
+bool b_selection_efficiency(double pt, double random, 
+                            const effparams& params){
+    // b-tagging with the dice already rolled
+    
+    bool passes = false;
     
-    double pt = bjet.second.pt();
-    double efficiency = .65;
+    double plateau = params.b_plateau;
+    double efficiency = plateau;
     
     // parameterization form SUSY-12-917-pas
-    if( (pt > 90) && (pt < 170)) efficiency = 0.65;
-    else if (pt <= 90) efficiency = .65 - (90 - pt) * 0.0038;
-    else if (pt >= 170 ) efficiency = .65 - (pt - 170) * 0.0007;
+    if( (pt > params.b_lowpT) && (pt < params.b_highpT)) efficiency = plateau;
+    else if (pt <= params.b_lowpT) 
+        efficiency = plateau - (params.b_lowpT - pt) * params.b_lowslope;
+    else if (pt >= params.b_highpT ) 
+        efficiency = plateau - (pt - params.b_highpT) * params.b_highslope;
     
-    if (pt < 40) efficiency = 0; // cut on bjet
+    if (pt < params.b_minpT) efficiency = 0; // cut on bjet
     
     // if (random < efficiency*1000) passes = true;
     if (random < efficiency) passes = true;
@@ -225,24 +293,11 @@ bool lepton_trig_efficiency(vector< pair<int, fastjet::PseudoJet> > leptons){
     // Should also require one lepton with pT > 17, other with pT > 8
     //  but this is already automatically satisfied by lepton kinematic cuts
 
-    bool passes = false;
     double random = (double)rand()/(double)RAND_MAX; // random from 0 to 1
-    double eff_ee = 0.95;
-    double eff_emu = 0.92;
-    double eff_mumu = 0.88;
+    int id0 = leptons.empty() ? 0 : leptons[0].first;
     
-    if (leptons.size()!=2) return passes;   // exactly two leptons, check
-    
-    if ((abs(leptons[0].first) == 11) && (abs(leptons[0].first) == 11))
-        if (random < eff_ee) passes = true;
-    if ((abs(leptons[0].first) == 11) && (abs(leptons[0].first) == 13))
-        if (random < eff_emu) passes = true;
-    if ((abs(leptons[0].first) == 13) && (abs(leptons[0].first) == 11))
-        if (random < eff_emu) passes = true;
-    if ((abs(leptons[0].first) == 12) && (abs(leptons[0].first) == 13))
-        if (random < eff_mumu) passes = true;
-        
-    return passes;
+    return lepton_trig_efficiency(leptons.size(), id0, random, 
+                                  default_effparams());
             
     
     // // Minimum trigger pT cuts
@@ -270,41 +325,84 @@ bool lepton_trig_efficiency(vector< pair<int, fastjet::PseudoJet> > leptons){
 
 
 
+bool lepton_trig_efficiency(unsigned int nLeptons, int id0, double random,
+                            const effparams& params){
+    // Dilepton trigger with the dice already rolled
+    // Only the first lepton's flavor gets looked at, exactly like the
+    //  version above always did; so only ee-looking pairs can pass.
+    
+    bool passes = false;
+    double eff_ee = params.eff_ee;
+    double eff_emu = params.eff_emu;
+    double eff_mumu = params.eff_mumu;
+    
+    if (nLeptons!=2) return passes;         // exactly two leptons, check
+    
+    if ((abs(id0) == 11) && (abs(id0) == 11))
+        if (random < eff_ee) passes = true;
+    if ((abs(id0) == 11) && (abs(id0) == 13))
+        if (random < eff_emu) passes = true;
+    if ((abs(id0) == 13) && (abs(id0) == 11))
+        if (random < eff_emu) passes = true;
+    if ((abs(id0) == 12) && (abs(id0) == 13))
+        if (random < eff_mumu) passes = true;
+        
+    return passes;
+    
+} // end lepton_trig_efficiency
+
+
+
 bool METefficiency(double MET, double minMET){
     // Converts between parton-level MET and hadronic MET
     // by including effect of 'turn on curves'
     // from 1205.3933
     
-    bool passes = false;
     double random = (double)rand()/(double)RAND_MAX; // random from 0 to 1
     
+    return METefficiency(MET, minMET, random, default_effparams());
+    
+} // end METefficiency
+
+
+
+bool METefficiency(double MET, double minMET, double random, 
+                   const effparams& params){
+    // MET turn-on curves with the dice already rolled
+    
+    if (minMET == 0) return true;
+    return (random < METturnon(MET, minMET, params));
+    
+} // end METefficiency
+
+
+
+double METturnon(double MET, double minMET, const effparams& params){
+    // Probability to pass the MET cut: the turn-on curve itself
+    
+    if (minMET == 0) return 1.0;
+    
     double x = MET;
     double x12 = 0;
     double sig = 0;
     
     if (minMET >= 120){
-        x12 = 123;
-        sig = 37;
+        x12 = params.MET_x12[0];
+        sig = params.MET_sig[0];
     }
     else if (minMET >= 50){
-        x12 = 43;
-        sig = 39;
+        x12 = params.MET_x12[1];
+        sig = params.MET_sig[1];
     }
     else if (minMET >= 30){
-        x12 = 13;
-        sig = 44;
+        x12 = params.MET_x12[2];
+        sig = params.MET_sig[2];
     }
-    else if (minMET == 0); // do nothing, see below
     else cout << endl << "ERROR: METefficiency" << endl;
     
-    double efficiency = 0.5*(erf((x-x12)/sig) + 1);
-    if (random < efficiency) passes = true;
-    
-    if (minMET == 0) passes = true;
-    
-    return passes;
+    return 0.5*(erf((x-x12)/sig) + 1);
     
-} // end METefficiency
+} // end METturnon
 
 
 
@@ -313,34 +411,48 @@ bool HTefficiency(double HT, double minHT){
     // by including effect of 'turn on curves'
     // from 1205.3933
     
-    bool passes = false;
     double random = (double)rand()/(double)RAND_MAX; // random from 0 to 1
     
+    return HTefficiency(HT, minHT, random, default_effparams());
+    
+} // end HTefficiency
+
+
+
+bool HTefficiency(double HT, double minHT, double random, 
+                  const effparams& params){
+    // HT turn-on curves with the dice already rolled
+    
+    if ( (minHT == 80) || (minHT == 0) ) return true;
+    // minimum pT cuts on jet selection is 40 GeV
+    // so a min HT of 80 trivially passes cuts
+    
+    return (random < HTturnon(HT, minHT, params));
+} // end HTefficiency
+
+
+
+double HTturnon(double HT, double minHT, const effparams& params){
+    // Probability to pass the HT cut: the turn-on curve itself
+    
+    if ( (minHT == 80) || (minHT == 0) ) return 1.0;
+    
     double x = HT;
     double x12 = 0;
     double sig = 0;
     
     if (minHT >= 320){
-        x12 = 188;
-        sig = 88;
+        x12 = params.HT_x12[0];
+        sig = params.HT_sig[0];
     }
     else if (minHT >= 200){
-        x12 = 308;
-        sig = 102;
+        x12 = params.HT_x12[1];
+        sig = params.HT_sig[1];
     }
-    else if (minHT == 80); // do nothing, see below
-    else if (minHT == 0);  // equivalent to above cut
     else cout << endl << "ERROR: HTefficiency" << endl;
     
-    double efficiency = 0.5*(erf((x-x12)/sig) + 1);
-    if (random < efficiency) passes = true;
-    
-    if ( (minHT == 80) || (minHT == 0) ) passes = true;
-    // minimum pT cuts on jet selection is 40 GeV
-    // so a min HT of 80 trivially passes cuts
-    
-    return passes;
-} // end HTefficiency
+    return 0.5*(erf((x-x12)/sig) + 1);
+} // end HTturnon
 
 
 
@@ -425,3 +537,63 @@ void fill_signalregions(vector<signalregion>& signal_region){
     signal_region[8].minusminus = true;
 }
 
+
+
+void fill_effparams(effparams& params){
+    // Detector numbers from SUS-12-017 and 1205.3933
+    // These are the values that used to be hard-coded in the helpers above
+    
+    // LEPTON KINEMATIC CUT PARAMETERS
+    params.electron_pT  = 20.0;
+    params.muon_pT      = 20.0;
+    params.lepton_eta   = 2.4;
+    params.eta_bar      = 1.442;
+    params.eta_end      = 1.566;
+    
+    // JET KINEMATIC CUT PARAMETERS
+    params.jet_pT       = 40.0;
+    params.jet_eta      = 2.4;
+    
+    // LEPTON ID AND ISOLATION
+    params.ID_e         = 0.76;     // electron
+    params.ID_mu        = 0.86;     // muon
+    params.lepton_dR    = 0.3;      // lepton delta R
+    params.Iiso         = 0.15;
+    
+    // B-TAGGING, parameterization from SUS-12-017-pas
+    params.b_plateau    = 0.65;
+    params.b_lowpT      = 90;
+    params.b_highpT     = 170;
+    params.b_lowslope   = 0.0038;
+    params.b_highslope  = 0.0007;
+    params.b_minpT      = 40;
+    
+    // DILEPTON TRIGGER
+    params.eff_ee       = 0.95;
+    params.eff_emu      = 0.92;
+    params.eff_mumu     = 0.88;
+    
+    // MET TURN-ON, minMET >= 120, >= 50, >= 30
+    params.MET_x12[0]   = 123;
+    params.MET_sig[0]   = 37;
+    params.MET_x12[1]   = 43;
+    params.MET_sig[1]   = 39;
+    params.MET_x12[2]   = 13;
+    params.MET_sig[2]   = 44;
+    
+    // HT TURN-ON, minHT >= 320, >= 200
+    params.HT_x12[0]    = 188;
+    params.HT_sig[0]    = 88;
+    params.HT_x12[1]    = 308;
+    params.HT_sig[1]    = 102;
+}
+
+
+
+double wall_seconds(){
+    // Wall clock in seconds, good to a microsecond or so
+    
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.0e-6 * now.tv_usec;
+}
@@ -1,7 +1,7 @@
 // FlipEfficiency.h
 // INCLUDE GUARD
-// #ifndef __FLIPEFFICIENCY_H_INCLUDED__
-// #define __FLIPEFFICIENCY_H_INCLUDED__
+#ifndef __FLIPEFFICIENCY_H_INCLUDED__
+#define __FLIPEFFICIENCY_H_INCLUDED__
 
 
 #include "Pythia.h"                         // Include Pythia headers
@@ -12,6 +12,7 @@
 #include <iostream>                         // for i don't know
 #include <iomanip>                          // for setting precision?
 #include <fstream>                          // for file in/out
+#include <sys/time.h>                       // for timing
 using namespace std;
 
 struct signalregion{
@@ -25,6 +26,54 @@ struct signalregion{
     bool minusminus;        // allow same sign - charge leptons
 };
 
+struct effparams{
+    // All the detector numbers that used to be hard-coded in the helper
+    //  functions of FlipEfficiency.cpp, so that the one-event-at-a-time
+    //  and the batched selections use literally the same constants.
+    // fill_effparams sets them to the SUS-12-017 values.
+    
+    // lepton kinematics
+    double electron_pT;
+    double muon_pT;
+    double lepton_eta;
+    double eta_bar;         // electron barrel ends here ...
+    double eta_end;         // ... and endcap starts here
+    
+    // jet kinematics
+    double jet_pT;
+    double jet_eta;
+    
+    // lepton ID and isolation
+    double ID_e;
+    double ID_mu;
+    double lepton_dR;       // isolation cone
+    double Iiso;            // max cone pT / lepton pT
+    
+    // b-tagging, see b_selection_efficiency
+    double b_plateau;       // efficiency between b_lowpT and b_highpT
+    double b_lowpT;
+    double b_highpT;
+    double b_lowslope;      // loss per GeV below b_lowpT
+    double b_highslope;     // loss per GeV above b_highpT
+    double b_minpT;         // no tags below this
+    
+    // dilepton trigger
+    double eff_ee;
+    double eff_emu;
+    double eff_mumu;
+    
+    // MET turn-on curves for minMET >= 120, >= 50, >= 30
+    double MET_x12[3];
+    double MET_sig[3];
+    
+    // HT turn-on curves for minHT >= 320, >= 200
+    double HT_x12[2];
+    double HT_sig[2];
+};
+
+struct runoptions;      // see FlipEvent.h
+struct flipresult;      // see FlipEvent.h
+
 double signal_efficiency(string, vector< pair<string, int> >&, int);
     // This is our main workhorse, it's defined in a separate file
     // FlipEfficiencySignal.cpp
@@ -37,12 +86,25 @@ double BG_efficiency(Pythia8::Pythia&, vector< pair<string, int> >&, int, int);
     // Inputs: pythia object, count vector, signal region index, # event
     // ** eventually I shuold merge these two functions
 
-double signal_efficiency_b(string, vector< pair<string, int> >&, int);
+double signal_efficiency_b(string, vector< pair<string, int> >&, int, 
+                            double *sigmaGen = 0, runoptions *options = 0,
+                            flipresult *result = 0,
+                            Pythia8::Pythia *warm = 0);
     // Same as signal_efficiency, but with b-tagging!
     // Oct 15 2013
     // This is our main workhorse, it's defined in a separate file
     // FlipEfficiencySignal.cpp
     // Inputs: command file, intermediate count vector, signal region index
+    // Optional: if sigmaGen isn't null, it's filled with Pythia's estimate
+    //  of the generated cross section (in mb) at the end of the run
+    // Optional: run options (batching etc.), see FlipEvent.h
+    // Optional: if result isn't null, it gets the cross section, the
+    //  cutflows etc., see flipresult in FlipEvent.h
+    // Optional: a Pythia that's already been constructed (and used), to
+    //  save reading its XML files again (FlipServer.h). Its settings and
+    //  particle data go back to the defaults before the command file
+    // Several can run at once on different threads (FlipLibrary.h), as
+    //  long as they use different command and spectrum files
 
 
     
@@ -53,6 +115,7 @@ double signal_efficiency_b(string, vector< pair<string, int> >&, int);
 void read_count(vector< pair<string, int> >);
 void fill_vector(vector< pair<string, int> > &, string, int);
 double get_deltaR(fastjet::PseudoJet, fastjet::PseudoJet);
+double wall_seconds();      // wall clock in seconds, for timing things
 
 bool lepton_kinematic_cut(pair<int, fastjet::PseudoJet>);
 bool jet_kinematic_cut(pair<int, fastjet::PseudoJet>);
@@ -66,10 +129,42 @@ bool METefficiency(double, double);
 bool HTefficiency(double, double);
 
 void fill_signalregions(vector<signalregion>&);
+void fill_effparams(effparams&);
+
+
+/******************************************************************************** 
+*   Same helpers on plain numbers, with the constants and dice passed in.       *
+*   The versions above roll rand() and use the default effparams; these are     *
+*   what the per-event and batched selections in FlipEvent.h/FlipBatch.h use.  *
+********************************************************************************/
+
+double get_deltaR(double, double, double, double);
+    // Inputs: eta1, phi1, eta2, phi2
+
+bool lepton_kinematic_cut(int, double, double, const effparams&);
+    // Inputs: PDG id, pT, eta
+bool jet_kinematic_cut(double, double, const effparams&);
+    // Inputs: pT, eta
+bool lepton_ID_eff(int, double, const effparams&);
+    // Inputs: PDG id, random number in [0,1]
+bool lepton_iso_eff(double, double, const effparams&);
+    // Inputs: lepton pT, scalar sum of pT in the cone around it
+bool b_selection_efficiency(double, double, const effparams&);
+    // Inputs: pT, random number in [0,1]
+bool lepton_trig_efficiency(unsigned int, int, double, const effparams&);
+    // Inputs: number of leptons, PDG id of the first, random number
+bool METefficiency(double, double, double, const effparams&);
+    // Inputs: MET, minMET, random number
+bool HTefficiency(double, double, double, const effparams&);
+    // Inputs: HT, minHT, random number
+double METturnon(double, double, const effparams&);
+    // Inputs: MET, minMET. The probability METefficiency passes with
+double HTturnon(double, double, const effparams&);
+    // Inputs: HT, minHT. The probability HTefficiency passes with
 
 
 
 
 // END INCLUDE GUARD
-// #endif // __FLIPEFFICIENCY_H_INCLUDED__
+#endif // __FLIPEFFICIENCY_H_INCLUDED__
 
@@ -7,6 +7,156 @@
 ********************************************************************************/
 
 #include "FlipEfficiency.h"
+#include "FlipEvent.h"
+#include "FlipPipeline.h"
+#include "FlipVeto.h"
+#include "FlipBias.h"
+#include "FlipBootstrap.h"
+#include "FlipSkim.h"
+#include "FlipProduction.h"
+#include "FlipCascade.h"
+#include "FlipCalibration.h"
+#include <pthread.h>                    // pythia_setup_lock
+#include <memory>                       // auto_ptr, for a Pythia of its own
+#include <algorithm>                    // min
+
+
+static pthread_mutex_t pythia_setup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+// A warm Pythia's particle data has to be ParticleData.xml's again before
+//  every run (the SLHA and command files change it). Parsing the XML for
+//  that costs as much as building a new Pythia, so the entries are kept
+//  the first time and copied back
+struct flipchannel{
+    int onMode;
+    double bRatio;
+    int meMode;
+    vector<int> products;
+};
+
+struct flipparticle{
+    // everything "id:property = value" or an SLHA file can change
+    int id;
+    string name, antiName;
+    int spinType, chargeType, colType;
+    double m0, mWidth, mMin, mMax, tau0;
+    bool isResonance, mayDecay, doExternalDecay, isVisible, doForceWidth;
+    vector<flipchannel> channels;
+};
+
+static vector<flipparticle> pristine;  // by id, written once under the lock
+
+
+
+static void keep_particles(Pythia8::ParticleData& particleData){
+    // Every entry as it is now, in nextId order
+
+    pristine.clear();
+    for (int id = particleData.nextId(0); id != 0;
+         id = particleData.nextId(id)){
+        Pythia8::ParticleDataEntry& entry =
+            *particleData.particleDataEntryPtr(id);
+        flipparticle particle;
+        particle.id              = id;
+        particle.name            = entry.name(1);
+        particle.antiName        = entry.name(-1);
+        particle.spinType        = entry.spinType();
+        particle.chargeType      = entry.chargeType();
+        particle.colType         = entry.colType();
+        particle.m0              = entry.m0();
+        particle.mWidth          = entry.mWidth();
+        particle.mMin            = entry.mMin();
+        particle.mMax            = entry.mMax();
+        particle.tau0            = entry.tau0();
+        particle.isResonance     = entry.isResonance();
+        particle.mayDecay        = entry.mayDecay();
+        particle.doExternalDecay = entry.doExternalDecay();
+        particle.isVisible       = entry.isVisible();
+        particle.doForceWidth    = entry.doForceWidth();
+        for (int i = 0; i < entry.sizeChannels(); i++){
+            Pythia8::DecayChannel& channel = entry.channel(i);
+            flipchannel kept;
+            kept.onMode = channel.onMode();
+            kept.bRatio = channel.bRatio();
+            kept.meMode = channel.meMode();
+            for (int j = 0; j < channel.multiplicity(); j++)
+                kept.products.push_back(channel.product(j));
+            particle.channels.push_back(kept);
+        }
+        pristine.push_back(particle);
+    }
+} // end keep_particles
+
+
+
+static bool restore_particles(Pythia8::ParticleData& particleData){
+    // The kept entries back in place. False if the last run added or
+    //  removed particles (QNUMBERS in an SLHA file): only reInit undoes that
+
+    unsigned int n = 0;
+    for (int id = particleData.nextId(0); id != 0;
+         id = particleData.nextId(id), n++)
+        if ((n >= pristine.size()) || (pristine[n].id != id)) return false;
+    if (n != pristine.size()) return false;
+
+    for (unsigned int i = 0; i < pristine.size(); i++){
+        flipparticle& particle = pristine[i];
+        Pythia8::ParticleDataEntry& entry =
+            *particleData.particleDataEntryPtr(particle.id);
+        entry.setNames(particle.name, particle.antiName);
+        entry.setSpinType(particle.spinType);
+        entry.setChargeType(particle.chargeType);
+        entry.setColType(particle.colType);
+        entry.setM0(particle.m0);
+        entry.setMWidth(particle.mWidth);
+        entry.setMMin(particle.mMin);
+        entry.setMMax(particle.mMax);
+        entry.setTau0(particle.tau0);
+        entry.setIsResonance(particle.isResonance);
+        entry.setMayDecay(particle.mayDecay);
+        entry.setDoExternalDecay(particle.doExternalDecay);
+        entry.setIsVisible(particle.isVisible);
+        entry.setDoForceWidth(particle.doForceWidth);
+        entry.setResonancePtr(0);           // init() makes new ones
+        entry.clearChannels();
+        for (unsigned int j = 0; j < particle.channels.size(); j++){
+            flipchannel& channel = particle.channels[j];
+            int p[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            for (unsigned int k = 0; (k < channel.products.size()) &&
+                                     (k < 8); k++)
+                p[k] = channel.products[k];
+            entry.addChannel(channel.onMode, channel.bRatio, channel.meMode,
+                             p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+        }
+    }
+    return true;
+} // end restore_particles
+
+
+
+static void reset_pythia(Pythia8::Pythia& pythia){
+    // A warm Pythia as it was built: default settings, no hooks, the
+    //  particle data of the XML files
+
+    pythia.settings.resetAll();
+    pythia.setUserHooksPtr(0);              // the last run's veto is gone
+    string xmlPath = pythia.settings.word("xmlPath");
+
+    // kept from a Pythia of its own, once: this one may have run already
+    pthread_mutex_lock(&pythia_setup_lock);
+    if (pristine.empty()){
+        auto_ptr<Pythia8::Pythia> fresh(new Pythia8::Pythia(xmlPath));
+        keep_particles(fresh->particleData);
+    }
+    pthread_mutex_unlock(&pythia_setup_lock);
+
+    if (!restore_particles(pythia.particleData))
+        pythia.particleData.reInit(xmlPath + "ParticleData.xml");
+} // end reset_pythia
+
+
 
 double signal_efficiency(
     string command_file,                    // Pythia data
@@ -621,343 +771,348 @@ double BG_efficiency(
 double signal_efficiency_b(
     string command_file,                    // Pythia data
     vector< pair<string, int> > &counts,    // intermediate data (for checking)
-    int iSR                                 // Signal Region #
+    int iSR,                                // Signal Region #
+    double *sigmaGen,                       // cross section out (mb), or 0
+    runoptions *options,                    // batching etc., or 0
+    flipresult *result,                     // everything else out, or 0
+    Pythia8::Pythia *warm                   // a Pythia to reuse, or 0
     ){
     // For a given parameter space point, outputs the signal efficiency
     // Fills the vector with a list of intermediate counts    
+    // The cuts themselves live in select_event (FlipEvent.cpp) and, for 
+    //  batches of events, select_batch (FlipBatch.cpp); analyse_event
+    //  (FlipPipeline.cpp) picks one, on this thread or an analysis thread
     
     /****************************************************************************
     *   SET UP GENERATION                                                       *
     ****************************************************************************/
     
-    Pythia8::Pythia pythia;                 // Declare Pythia object
+    // Several of these can run at once in one program (FlipLibrary.h).
+    //  What Pythia 8.1 shares between its objects is LHAPDF's one PDF set
+    //  per process, which init() picks; that, and building a Pythia (the
+    //  XML files), go one at a time under pythia_setup_lock. The rest of
+    //  the set-up runs in parallel
+    double setupStart = wall_seconds();
+    
+    // Declare Pythia object, or reuse one: the XML files it reads when
+    //  it's constructed are most of the start-up time
+    auto_ptr<Pythia8::Pythia> own(0);
+    if (!warm){
+        pthread_mutex_lock(&pythia_setup_lock);
+        own.reset(new Pythia8::Pythia);
+        pthread_mutex_unlock(&pythia_setup_lock);
+    }
+    Pythia8::Pythia& pythia = warm ? *warm : *own;
+    if (warm) reset_pythia(pythia);
     Pythia8::Event& event = pythia.event;   // Declare event as a shortcut
     Pythia8::Event& process = pythia.process; 
                                             // only hard process, for b-tag
     
     pythia.readFile(command_file);          // Read in command file
 
-    int nEvent = pythia.mode("Main:numberOfEvents");
-    int nAbort = pythia.mode("Main:timesAllowErrors");
-
-    pythia.init();
-    
+    // RUN OPTIONS
+    runoptions defaults;
+    fill_runoptions(defaults);
+    if (!options) options = &defaults;
+    
+    // Gluino pairs made once per gluino mass, see FlipProduction.h; our
+    //  own decays (FlipCascade.h) start from them, so cascade= needs them
+    runoptions productionOptions = *options;
+    if ((options->cascade > 0) && (productionOptions.production == ""))
+        productionOptions.production = "gluinos";
+    flipproduction production;
+    use_production(production, pythia, command_file, productionOptions);
+    
+    // Hadron level: turn back on what the command files switch off
+    flipclusterer clusterer;
+    if (options->hadron){
+        pythia.readString("PartonLevel:MPI = on");
+        pythia.readString("PartonLevel:ISR = on");
+        pythia.readString("PartonLevel:FSR = on");
+        pythia.readString("HadronLevel:Hadronize = on");
+        fill_clusterer(clusterer, options->strategy);
+    }
+    
+    // DETECTOR PARAMETERS
+    effparams params;                      // b-tag, lepton ID, turn-ons...
+    fill_effparams(params);                // ... as in SUS-12-017
     
     // SIGNAL REGIONS
     vector<signalregion> signal_region;    // as defined in SUS-12-017 Table 1
     fill_signalregions(signal_region);     // fills data from above paper
+    
+    // Shifted parameters run alongside, see FlipVariation.h
+    vector<flipvariation> variations;
+    read_variations(variations, options->variations, params);
+    read_regions(variations, options->regions, signal_region, params);
+    
+    // Kinematic thresholds scanned alongside, see FlipThreshold.h
+    vector<flipthreshold> thresholds;
+    read_thresholds(thresholds, options->thresholds, params);
+    
+    // Distributions at the cut stages, see FlipHisto.h
+    fliphistos histos;
+    read_histos(histos, options->histos, options->histoFile);
+    
+    // Every cut on every event, for N-1 and correlations, see FlipMask.h
+    flipmasks masks;
+    read_masks(masks, options->allCuts, options->flow);
+    
+    // Forced decays, weighted back with the real BRs, see FlipBias.h
+    flipbias bias;
+    read_bias(bias, options->forced);
+    apply_bias(bias, pythia);
+    
+    // Process-level veto of hopeless events, see FlipVeto.h. Without
+    //  Check:abortIfVeto (older Pythias) next() would make another event
+    //  in place of a vetoed one, and the loop would never see it
+    flipveto vetohook;
+    bool veto = options->veto;
+    if (veto && !pythia.settings.isFlag("Check:abortIfVeto")){
+        cout << endl << "ERROR: this Pythia has no Check:abortIfVeto, so "
+             << "vetoed events can't be counted; running without veto="
+             << endl;
+        veto = false;
+    }
+    if (veto && (options->maps != "")){
+        cout << endl << "ERROR: veto= tags with the parton pT and maps= "
+             << "scales it (FlipVeto.h); running without veto=" << endl;
+        veto = false;
+    }
+    if (veto){
+        bool leptons = !pythia.flag("PartonLevel:ISR") 
+                    && !pythia.flag("PartonLevel:FSR")
+                    && !pythia.flag("PartonLevel:MPI")
+                    && !pythia.flag("HadronLevel:Hadronize");
+        vetohook.setup(params, leptons, &bias);
+        for (unsigned int i = 0; i < variations.size(); i++)
+            vetohook.also_tag(variations[i].params);
+        pythia.setUserHooksPtr(&vetohook);
+        pythia.readString("Check:abortIfVeto = on");
+    }
+
+    int nEvent = pythia.mode("Main:numberOfEvents");
+    int nAbort = pythia.mode("Main:timesAllowErrors");
+
+    if (options->quiet) pythia.readString("Print:quiet = on");
+    bool lhapdf = pythia.flag("PDF:useLHAPDF") 
+               || pythia.flag("PDF:useHardLHAPDF");
+    if (lhapdf) pthread_mutex_lock(&pythia_setup_lock);
+    pythia.init();
+    if (lhapdf) pthread_mutex_unlock(&pythia_setup_lock);
+    fill_bias_weights(bias, pythia);
+    
+    // Decays of our own instead of Pythia's, see FlipCascade.h
+    flipcascade cascade;
+    cascade.on = false;
+    if ((options->cascade > 0) && options->hadron)
+        cout << endl << "ERROR: cascade= is parton level only, Pythia "
+             << "decays the gluinos" << endl;
+    else if (production.on)
+        start_cascade(cascade, options->cascade, production.filename, pythia,
+                      bias);
+    if (cascade.on) nEvent = cascade.nEvent;
+    double setupTime = wall_seconds() - setupStart;
+    
+    
+    // Every event gets its own dice, see FlipEvent.h
+    unsigned int seed = options->seed;
+    if (seed == 0) seed = (unsigned int) rand();
 
     
     
     /****************************************************************************
-    *   SET UP COUNTERS FOR SANITY CHECK COUNTS                                 *
+    *   SET UP THE ANALYSIS (COUNTERS FOR SANITY CHECK COUNTS ETC.)             *
     ****************************************************************************/
     
-    int nGenerated  = 0; // # generated events 
-    int nKinematic  = 0; // # events that pass kinematic cuts on leptons
-    // int nLepSelect  = 0; // # events that pass lepton selection efficiencies
-    int nLepID      = 0; // # events that pass lepton ID efficiencies
-    int nLepIso     = 0; // # events that pass lepton isolation efficiencies
-    int nbjetSelect = 0; // # events that pass bJet selection efficiencies
-    int nDilepton   = 0; // # events that pass dilepton requirement
-    int nDilepTrig  = 0; // # events that pass dilep req & trig efficiency
-    int nSS2L       = 0; // # events that pass same sign leptons requirement
-    int nJets       = 0; // # events with mininum number of jets
-    int nbJets      = 0; // # events with minimum number of tagged b jets
-    int nMET        = 0; // # events that pass minimum MET requirement
-    int nHT         = 0; // # events that pass minimum HT requirement
-    int nCharge     = 0; // # events that pass ++ or -- requirement
-    int nPassed     = 0; // # events that passed all cuts
+    flipanalysis analysis;              // cuts and counts, see FlipPipeline.h
+    start_analysis(analysis, signal_region[iSR], params, seed, *options);
+    analysis.variations = variations;
+    analysis.thresholds = thresholds;
+    analysis.histos = histos;
+    analysis.masks = masks;
+    
+    flipevent record;                   // this event's visible particles
+    flipclusterer* jetclusterer = options->hadron ? &clusterer : 0;
+    flippipeline pipeline;              // analysis threads, if any
+    bool threaded = (options->pipeline > 0);
+    if (threaded) start_pipeline(pipeline, analysis);
+    
+    flipbootstrap bootstrap;            // stored events, see FlipBootstrap.h
+    fill_bootstrap(bootstrap, options->replicas, options->isoGrid);
+    if (cascade.on) bootstrap.copies = cascade.copies;
+    
+    // Parton-to-jet maps, measured or used, see FlipCalibration.h
+    flipcalibration calibration;
+    start_calibration(calibration, *options);
+    
+    flipskim skim;                      // events written out, see FlipSkim.h
+    runoptions skimOptions = *options;
+    size_t dot = skimOptions.skimFile.rfind('.');
+    if (cascade.on && (skimOptions.skim != "") && (dot != string::npos) &&
+        (skimOptions.skimFile.substr(dot) == ".lhe")){
+        cout << endl << "ERROR: an LHE skim needs Pythia's process record, "
+             << "no skim with cascade=" << endl;
+        skimOptions.skim = "";
+    }
+    start_skim(skim, skimOptions);
     
     
     /****************************************************************************
     *   GENERATE EVENTS                                                         *
     ****************************************************************************/
     
+    double startTime = wall_seconds();          // for events per second
     int iAbort = 0;
     for (int iEvent = 0; iEvent < nEvent; ++iEvent) { // event loop
         
+        // Our own decays, no Pythia in the loop
+        if (cascade.on){
+            flipevent& made = threaded ? pipeline_slot(pipeline) : record;
+            cascade_event(cascade, made, iEvent, seed);
+            calibrate_event(calibration, made, seed);
+            keep_event(bootstrap, made);
+            skim_event(skim, made, process, pythia.info, signal_region[iSR],
+                       params, seed);
+            if (threaded) pipeline_push(pipeline);
+            else analyse_event(analysis, made);
+            continue;
+        }
+        
+        // Vetoed: generated and failed, nothing to analyse
+        vetohook.vetoed = false;
+        bool generated = pythia.next();
+        if (generated || vetohook.vetoed) count_open_fraction(bias, pythia);
+        if (!generated && vetohook.vetoed){
+            if (bootstrap.nReplicas > 0){
+                flipevent nothing;      // fails the first cut, every time
+                nothing.HT = 0.0;
+                nothing.iEvent = iEvent;
+                nothing.weight = event_weight(bias, process);
+                keep_event(bootstrap, nothing);
+            }
+            continue;
+        }
+        
         // Quit if too many aborts
-        if (!pythia.next()) {                   // if no new event
+        if (!generated) {                       // if no new event
             if (++iAbort < nAbort) continue;    // if not over abort limit
             cout << " Event generation aborted prematurely, owing to error!\n"; 
             break;
         } // End of 'if no new event'        
         
-            
-    
-        /************************************************************************
-        * SET UP EVENT DATA FOR LATER INSPECTION                                *
-        ************************************************************************/
-        
-        vector< pair<int, fastjet::PseudoJet> > preleptons; // from event
-        vector< pair<int, fastjet::PseudoJet> > prepartons; // from event
-        vector< pair<int, fastjet::PseudoJet> > bpartons;   // from process
-        fastjet::PseudoJet METvec (0.0, 0.0, 0.0, 0.0);
-        double MET (0.0);
-        double HT (0.0);
-        
+        // ANALYSE HERE
+        // ------------
+        if (!threaded){
+            fill_event(event, process, record, jetclusterer);
+            record.iEvent = iEvent;
+            record.weight = event_weight(bias, process);
+            measure_event(calibration, process, record);
+            calibrate_event(calibration, record, seed);
+            keep_event(bootstrap, record);
+            skim_event(skim, record, process, pythia.info, signal_region[iSR],
+                       params, seed);
+            analyse_event(analysis, record);
+            continue;
+        }
+        
+        // OR ON AN ANALYSIS THREAD
+        // ------------------------
+        flipevent& slot = pipeline_slot(pipeline);
+        fill_event(event, process, slot, jetclusterer);
+        slot.iEvent = iEvent;
+        slot.weight = event_weight(bias, process);
+        measure_event(calibration, process, slot);
+        calibrate_event(calibration, slot, seed);
+        keep_event(bootstrap, slot);
+        skim_event(skim, slot, process, pythia.info, signal_region[iSR],
+                   params, seed);
+        pipeline_push(pipeline);
         
-        
-        /************************************************************************
-        * LOOP THROUGH EVENT PARTICLES                                          *
-        ************************************************************************/
-        
-        // LOOP THROUGH TOTAL EVENT PARTICLES
-        // ----------------------------------
-        // To be distinguished from the loop over the hard
-        // event ("process") particles.
-        //
-        for (int iPart = 0; iPart < event.size(); iPart++){
-            
-            // Skip things that we can't see
-            if (!event[iPart].isFinal()) continue;
-            if (!event[iPart].isVisible()) continue;   
-            if (abs(event[iPart].eta()) >= 5.0) continue;
-            
-            fastjet::PseudoJet momentum(event[iPart].px(),
-                                        event[iPart].py(),
-                                        event[iPart].pz(),
-                                        event[iPart].e());
-            
-            // Fill Missing ET vector                            
-            METvec -= momentum;
-            
-            // Keep track of leptons
-            if ((abs(event[iPart].id()) == 11) || 
-                (abs(event[iPart].id()) == 13) ) {
-                //
-                pair<int,fastjet::PseudoJet> cur_lept;
-                cur_lept.first = event[iPart].id();     // PDG code
-                cur_lept.second = momentum;             // 4-vector
-                preleptons.push_back(cur_lept);            // put in list
-                continue;
-            } // End "if this is an identfiable lepton"  
-            
-            
-            // Anything left is a parton
-            pair<int,fastjet::PseudoJet> cur_parton;
-            cur_parton.first = event[iPart].id();
-            cur_parton.second = momentum;
-            prepartons.push_back(cur_parton); 
-            HT += momentum.pt();
-            
-            
-        } // End loop through event particles
-        
-        // LOOP THROUGH HARD EVENT PARTICLES
-        // ---------------------------------
-        // Use pythia.process to accesses only the hard scattering event
-        // We will use this for b-tagging since we have the parton-level
-        // b-tagging efficiency. 
-        //
-        for (int iPart = 0; iPart < process.size(); iPart++){
-            
-            if (!process[iPart].isFinal()) continue;
-            if (!process[iPart].isVisible()) continue;   
-            if (abs(process[iPart].eta()) >= 5.0) continue;
-            if (!abs(process[iPart].id())==5) continue;     //only bjets
-            
-            fastjet::PseudoJet momentum(process[iPart].px(),
-                                        process[iPart].py(),
-                                        process[iPart].pz(),
-                                        process[iPart].e());
-            
-            // bpartons
-            pair<int,fastjet::PseudoJet> cur_bparton;
-            cur_bparton.first = process[iPart].id();
-            cur_bparton.second = momentum;
-            bpartons.push_back(cur_bparton); 
+    } // end for loop, going through Events
     
-        } // End loop through process particles
-        
+    if (threaded) stop_pipeline(pipeline, analysis);
+    else finish_analysis(analysis);     // whatever is left in the last batch
+    stop_skim(skim);
+    double runTime = wall_seconds() - startTime;
     
-        // Increment counter
-        nGenerated++;        
-        
-        
-        
-        /************************************************************************
-        * IMPOSE CUTS                                                           *
-        ************************************************************************/
-        
-        // LEPTON KINEMATICS
-        // Check that allowed leptons satisfy kinematic cuts 
-        // -------------------------------------------------
-        
-        vector< pair<int, fastjet::PseudoJet> > leptons_kin;
-        for(unsigned int iLep = 0; iLep < preleptons.size(); iLep++){
-            if (lepton_kinematic_cut(preleptons[iLep]))
-                leptons_kin.push_back(preleptons[iLep]);
-        } // end for loop over leptons
-        
-        if (leptons_kin.size() > 1) nKinematic++;
-        else continue;
-        
-        
-        
-        // PARTON KINEMATICS
-        // Check that allowed partons satisfy kinematic cuts
-        // -------------------------------------------------
-        
-        vector< pair<int, fastjet::PseudoJet> > partons;
-        for(unsigned int iJet = 0; iJet < prepartons.size(); iJet++){
-            if (jet_kinematic_cut(prepartons[iJet]))
-                partons.push_back(prepartons[iJet]);
-        } // end for loop over partons
-                
-
-        
-        // SELECTION EFFICIENCIES
-        // "selection cuts"
-        // (Roll the dice)
-        // ----------------------
-
-        // // Instead of using this, we separate into ID * iso efficiency
-        // // UNUSED: separate selection eff = ID eff * isolation eff
-        //
-        // vector< pair<int, fastjet::PseudoJet> > leptons;
-        // for(unsigned int iLep = 0; iLep < leptons_kin.size(); iLep++){
-        //     if (lepton_selection_cut(leptons_kin[iLep]))
-        //         leptons.push_back(leptons_kin[iLep]);
-        // } // end for loop over leptons
-        // 
-        // if (leptons.size() > 1) nLepSelect++;
-        // else continue;
-        
-        vector< pair<int, fastjet::PseudoJet> > leptons_ID;
-        for(unsigned int iLep = 0; iLep < leptons_kin.size(); iLep++){
-            if (lepton_ID_eff(leptons_kin[iLep]))
-                leptons_ID.push_back(leptons_kin[iLep]);
-        } // end for loop over leptons
-        
-        if (leptons_ID.size() > 1) nLepID++;
-        else continue;
-        
-        
-        
-        vector< pair<int, fastjet::PseudoJet> > leptons;
-        for(unsigned int iLep = 0; iLep < leptons_ID.size(); iLep++){
-            if (lepton_iso_eff(leptons_ID[iLep], partons))
-                leptons.push_back(leptons_ID[iLep]);
-        } // end for loop over leptons
-        
-        if (leptons.size() > 1) nLepIso++;
-        else continue;
-        
-        
-        // // bjet tagging at parton level (bpartons)
-        //         vector< pair<int, fastjet::PseudoJet> > bJets;
-        //         for(unsigned int iJet = 0; iJet < partons.size(); iJet++)
-        //             if( ( abs(partons[iJet].first)==5 ) && 
-        //                 b_selection_efficiency(partons[iJet]) )
-        //                 bJets.push_back(partons[iJet]);
-        // 
-        //         if (bJets.size() > 1) nbjetSelect++;
-        //         else continue;
-        
-        // bjet tagging at parton level (bpartons)
-        // This counts the number of b jets based on
-        // the parton level selection efficiency given by CMS
-        vector< pair<int, fastjet::PseudoJet> > bJets;
-        for(unsigned int iJet = 0; iJet < bpartons.size(); iJet++)
-            if( b_selection_efficiency(bpartons[iJet]) )
-                bJets.push_back(bpartons[iJet]);
-
-        if (bJets.size() > 1) nbjetSelect++;
-        else continue;
-        
-        
-        // Event cuts
-        // ----------
-        
-        // Exactly two leptons
-        if (leptons.size() != 2) continue;
-        else nDilepton++;
-        
-        // Trigger efficiency for dilepton
-        if (lepton_trig_efficiency(leptons)) continue;
-        else nDilepTrig++;
-        
-        // Same-sign dileptons
-        if (leptons[0].first/abs(leptons[0].first) != 
-            leptons[1].first/abs(leptons[1].first)) continue;
-        else nSS2L++;
-        
-        
-        
-        // Signal region cuts: from input
-        // ------------------------------
-        
-        if (partons.size() < signal_region[iSR].minJets) continue;        
-        else nJets++;
-        
-        if (bJets.size() < signal_region[iSR].minbJets) continue;
-        else nbJets++;
-        
-        MET = METvec.pt(); 
-        // if (MET < signal_region[iSR].minMET) continue;
-        if (!METefficiency(MET,signal_region[iSR].minMET)) continue;
-        else nMET++;
-        
-        // if (HT < signal_region[iSR].minHT) continue;
-        if (!HTefficiency(HT,signal_region[iSR].minHT)) continue;
-        else nHT++;
-        
-        bool minmin = (leptons[0].first > 0) && signal_region[iSR].minusminus;
-        bool pluplu = (leptons[0].first < 0) && signal_region[iSR].plusplus;
-        
-        if (!(minmin || pluplu)) continue;
-        else nCharge++;
-        
-        // Made it this far? YOU PASS
-        nPassed++;
-        
-    } // end for loop, going through Events
+    int nGenerated = analysis.stagecounts.events[cutGenerated];
+    // The hook's own count of what it vetoed, not the loop's
+    int nVetoed = vetohook.nVetoed;
+    veto_analysis(analysis, nVetoed, vetohook.weightVetoed);
+    flipcounts& stagecounts = analysis.stagecounts;
+    int nPassed = stagecounts.events[cutCharge];    // # events that passed
+    double weightPassed = stagecounts.weights[cutCharge];   // their weight
     
     
     
     // Fill counts
     // -----------
-    fill_vector(counts, "Generated events \t", nGenerated);
-    fill_vector(counts, ">1 lep. kin. cuts\t", nKinematic);
-    // fill_vector(counts, ">1 lep. sel. eff.\t", nLepSelect);
-    fill_vector(counts, ">1 lep. ID. eff.\t", nLepID);
-    fill_vector(counts, ">1 lep. Iso. eff.\t", nLepIso);
-    fill_vector(counts, ">1 bjets tagged \t", nbjetSelect);
-    fill_vector(counts, "exactly two leptons \t", nDilepton);
-    fill_vector(counts, "triggered two leptons \t", nDilepTrig);
-    fill_vector(counts, "same sign dileptons \t", nSS2L);
-    
-    // The following cuts depend on the signal region, so we have to
-    //  "dynamically" generate their labels
-    
-    stringstream nJetComment;
-    nJetComment << "at least " << signal_region[iSR].minJets << " jets \t";
-    fill_vector(counts, nJetComment.str(), nJets);
-    
-    stringstream nbJetComment;
-    nbJetComment << "at least " << signal_region[iSR].minbJets << " b jets \t";
-    fill_vector(counts, nbJetComment.str(), nbJets);
-    
-    stringstream nMETComment;
-    nMETComment << "at least " << signal_region[iSR].minMET << " GeV MET \t";
-    fill_vector(counts, nMETComment.str(), nMET);
-    
-    stringstream HTComment;
-    HTComment << "at least " << signal_region[iSR].minHT << " GeV HT \t";
-    fill_vector(counts, HTComment.str(), nHT);
-    
-    stringstream nChargeComment;
-    if ( signal_region[iSR].minusminus && !signal_region[iSR].plusplus)
-        nChargeComment << "only -- leptons \t";
-    else if ( !signal_region[iSR].minusminus && signal_region[iSR].plusplus)
-        nChargeComment << "only ++ leptons \t";
-    else if ( signal_region[iSR].minusminus && signal_region[iSR].plusplus)
-        nChargeComment << "either ++ or -- leptons";
-    else nChargeComment << "You fucked up, neither ++ or -- leptons ";
-    
-    fill_vector(counts, nChargeComment.str(), nCharge);
+    fill_counts(counts, stagecounts, signal_region[iSR]);
+    
+    write_histos(analysis.histos, nEvent);
+    write_calibration(calibration);
+    
+    // Same events, new dice: the spread of the efficiency
+    if (bootstrap.nReplicas > 0)
+        run_bootstrap(bootstrap, signal_region[iSR], params, seed, nEvent);
+    
+    // With cascade= Pythia never made an event: the stored production's.
+    //  Else Pythia's, without the open fractions of the forced decays,
+    //  whose BRs are in the event weights already (FlipBias.h)
+    double sigmaRun = cascade.on 
+        ? 1e-9 * production.sigma
+        : unforced_sigma(bias, pythia.info.sigmaGen());
+    double sigmaRunErr = cascade.on 
+        ? 1e-9 * production.sigmaErr
+        : unforced_sigma(bias, pythia.info.sigmaErr());
+    
+    // The efficiency counts the vetoed events as generated, so sigmaRun
+    //  has to be the cross section before the veto. Pythia 8.1 counts an
+    //  event as accepted (ProcessContainer::accumulate, what sigmaGen is
+    //  made of) when the hard process is picked, before the user hooks
+    //  get to doVetoProcessLevel, so a process-level veto shouldn't take
+    //  anything off sigmaGen. Rather than take that on trust for every
+    //  version (8.165 included), it's checked: if the vetoed events are
+    //  missing from nAccepted, they're put back into the cross section.
+    int nMissing = 0;
+    if (!cascade.on && (nVetoed > 0) && (pythia.info.nAccepted() > 0)){
+        long counted = nGenerated + nVetoed;
+        nMissing = int(min(long(nVetoed), 
+                           counted - pythia.info.nAccepted()));
+        if (nMissing > 0){
+            double restore = double(pythia.info.nAccepted() + nMissing)
+                           / double(pythia.info.nAccepted());
+            sigmaRun    *= restore;
+            sigmaRunErr *= restore;
+        }
+    }
+    if (sigmaGen) *sigmaGen = sigmaRun;
+    
+    // The skim is normalised with the same cross section
+    if (skim.stage >= 0)
+        write_skim_meta(skim, pythia, *options, nEvent, iSR, seed, sigmaRun,
+                        sigmaRunErr);
+    
+    // Everything else, for callers that want more than the efficiency
+    if (result){
+        result->efficiency  = weightPassed / double(nEvent);
+        result->sigmaGen    = sigmaRun;
+        result->sigmaErr    = sigmaRunErr;
+        result->nEvent      = nEvent;
+        result->seconds     = runTime;
+        result->setupSeconds = setupTime;
+        result->seed        = seed;
+        result->stagecounts = stagecounts;
+        result->names.clear();
+        result->varied.clear();
+        for (unsigned int i = 0; i < analysis.variations.size(); i++){
+            result->names.push_back(analysis.variations[i].name);
+            result->varied.push_back(analysis.variations[i].stagecounts);
+        }
+    }
+    
+    if (options->quiet) return weightPassed / double(nEvent);
     
     
     
@@ -965,9 +1120,68 @@ double signal_efficiency_b(
     cout << endl << endl << "STOP: " << pythia.particleData.m0(1000006) << endl;
     cout << "GLUINO: " << pythia.particleData.m0(1000021) << endl;
     cout << "Signal Region " << iSR << endl; 
-    cout << "Efficiency: " << double(nPassed) / double(nEvent) << endl;
+    cout << "Efficiency: " << weightPassed / double(nEvent) << endl;
+    if (runTime > 0)
+        cout << "Events per second: " << nEvent / runTime << " (" << nEvent
+             << " events in " << runTime << " s)" << endl;
+    cout << "Start-up: " << setupTime << " s" << (warm ? " (warm)" : "")
+         << endl;
+    report_variations(analysis.variations, weightPassed / double(nEvent),
+                      nEvent);
+    report_thresholds(analysis.thresholds, nEvent, 
+                      weightPassed / double(nEvent));
+    report_masks(analysis.masks, stagecounts, nEvent);
+    report_isogrid(analysis.state.isogrid);
+    
+    // With forced decays: the unweighted numbers, and the cutflow with
+    //  the real branching ratios (per generated event)
+    if (!bias.ids.empty()){
+        report_bias(bias);
+        cout << "Unweighted efficiency: " << double(nPassed) / double(nEvent)
+             << endl;
+        cout << "Weighted cutflow:" << endl;
+        int first = counts.size() - nCutStages;
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            cout << counts[first + iStage].first << ":\t" 
+                 << stagecounts.weights[iStage] / double(nEvent) << endl;
+    }
+    
+    if ((options->batchSize > 0) && options->validate){
+        int nStageDiff = 0;
+        for (int iStage = 0; iStage < nCutStages; iStage++)
+            if (stagecounts.events[iStage] != 
+                analysis.checkcounts.events[iStage]) 
+                nStageDiff++;
+        cout << "Batch validation: " << analysis.nMismatch << " events and "
+             << nStageDiff << " cut stages differ from the per-event path" 
+             << endl;
+    }
+    
+    if (veto)
+        cout << "Vetoed at process level: " << nVetoed << " events ("
+             << vetohook.nNoB << " for the b's, " << vetohook.nNoSS 
+             << " for the leptons)" << endl;
+    if (nMissing > 0)
+        cout << "Cross section: " << nMissing << " vetoed events weren't "
+             << "in Pythia's sigmaGen, put back" << endl;
+    report_production(production);
+    report_cascade(cascade);
+    if (cascade.on && options->validate)
+        validate_cascade(command_file, iSR, *options, stagecounts, nEvent,
+                         runTime, sigmaRun, sigmaRunErr);
+    if (options->hadron) report_clusterer(clusterer);
+    report_calibration(calibration);
+    if (options->reorder > 0) report_order(analysis.order);
+    if (skim.stage >= 0)
+        cout << "Skimmed " << skim.nSkimmed << " events (cutflow: "
+             << stagecounts.events[skim.stage] << ") into " << skim.filename
+             << ", see " << skim.filename << ".meta" << endl;
+    if (!analysis.histos.histos.empty())
+        cout << "Wrote " << analysis.histos.histos.size() << " histograms to "
+             << analysis.histos.filename << endl;
+    report_bootstrap(bootstrap, weightPassed / double(nEvent));
 
-    return double(nPassed) / double(nEvent); 
+    return weightPassed / double(nEvent); 
     
 
     
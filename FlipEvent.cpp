@@ -0,0 +1,543 @@
+/********************************************************************************
+*   FlipEvent.cpp by Flip Tanedo (pt267@cornell.edu)                            *
+*   The event loop of signal_efficiency_b, pulled apart into:                   *
+*   - fill_event: copy the visible final state out of Pythia                    *
+*   - select_event: impose the cuts, one stage after the other                  *
+*   - fill_counts: write the cutflow with the usual labels                      *
+*   The dice come from per-event streams instead of rand(), so that the         *
+*   batched selection in FlipBatch.cpp can reproduce this exactly.              *
+********************************************************************************/
+
+#include "FlipEvent.h"
+
+
+static const char* cutstage_names[nCutStages] = {
+    "generated", "kinematic", "lepid", "lepiso", "btag", "dilepton",
+    "trigger", "ss2l", "jets", "bjets", "met", "ht", "charge"
+};
+
+
+void fill_runoptions(runoptions& options){
+    // Defaults: behave like PartonRPV always did
+
+    options.batchSize   = 0;
+    options.validate    = false;
+    options.seed        = 0;
+    options.pipeline    = 0;
+    options.ringSize    = 256;
+    options.hadron      = false;
+    options.strategy    = "auto";
+    options.reorder     = 0;
+    options.veto        = false;
+    options.forced      = "24:11,13,15";    // W -> leptons, see FlipBias.h
+    options.replicas    = 0;
+    options.variations  = "";
+    options.thresholds  = "";
+    options.skim        = "";
+    options.skimFile    = "skim.dat";
+    options.regions     = "";
+    options.quiet       = false;
+    options.histos      = "";
+    options.histoFile   = "histos.dat";
+    options.allCuts     = false;
+    options.flow        = "";
+    options.isoGrid     = -1;
+    options.production  = "";
+    options.cascade     = 0;
+    options.calibrate   = "";
+    options.maps        = "";
+} // end fill_runoptions
+
+
+
+bool read_runoption(runoptions& options, string argument){
+    // Command line options look like key=value
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    if      (key == "batch")    options.batchSize = atoi(value.c_str());
+    else if (key == "validate") options.validate  = (atoi(value.c_str()) != 0);
+    else if (key == "seed")     options.seed      = strtoul(value.c_str(), 0, 10);
+    else if (key == "pipeline") options.pipeline  = atoi(value.c_str());
+    else if (key == "ring")     options.ringSize  = atoi(value.c_str());
+    else if (key == "hadron")   options.hadron    = (atoi(value.c_str()) != 0);
+    else if (key == "strategy") options.strategy  = value;
+    else if (key == "reorder")  options.reorder   = atoi(value.c_str());
+    else if (key == "veto")     options.veto      = (atoi(value.c_str()) != 0);
+    else if (key == "force")    options.forced    = value;
+    else if (key == "replicas") options.replicas  = atoi(value.c_str());
+    else if (key == "vary")     options.variations = value;
+    else if (key == "scan")     options.thresholds = value;
+    else if (key == "skim")     options.skim      = value;
+    else if (key == "skimfile") options.skimFile  = value;
+    else if (key == "regions")  options.regions   = value;
+    else if (key == "quiet")    options.quiet     = (atoi(value.c_str()) != 0);
+    else if (key == "histos")   options.histos    = value;
+    else if (key == "histofile") options.histoFile = value;
+    else if (key == "allcuts")  options.allCuts   = (atoi(value.c_str()) != 0);
+    else if (key == "flow")     options.flow      = value;
+    else if (key == "isogrid")  options.isoGrid   = atoi(value.c_str());
+    else if (key == "production") options.production = value;
+    else if (key == "cascade")  options.cascade   = atoi(value.c_str());
+    else if (key == "calibrate") options.calibrate = value;
+    else if (key == "maps")     options.maps      = value;
+    else {
+        cout << endl << "ERROR: unknown option " << argument << endl;
+        return false;
+    }
+
+    return true;
+} // end read_runoption
+
+
+
+static unsigned int hash_dice(unsigned int x){
+    // 32 bit integer hash (the "lowbias32" mixer)
+
+    x ^= x >> 16;
+    x  = (x * 0x7feb352dU) & 0xffffffffU;
+    x ^= x >> 15;
+    x  = (x * 0x846ca68bU) & 0xffffffffU;
+    x ^= x >> 16;
+    return x;
+} // end hash_dice
+
+
+
+void seed_dice(flipdice& dice, unsigned int seed, unsigned int iEvent,
+               unsigned int stream){
+    // Every (seed, event, stream) starts somewhere different
+
+    unsigned int x = hash_dice(stream + 0x9e3779b9U);
+    x = hash_dice((iEvent ^ x) & 0xffffffffU);
+    x = hash_dice((seed + x) & 0xffffffffU);
+    dice.state = x;
+} // end seed_dice
+
+
+
+double roll_dice(flipdice& dice){
+    // Hashed Weyl sequence: step the counter, hash it
+
+    dice.state = (dice.state + 0x9e3779b9U) & 0xffffffffU;
+    return hash_dice(dice.state) / 4294967296.0;
+} // end roll_dice
+
+
+
+unsigned int hash_string(string text, unsigned int hash){
+    // FNV-1a, 32 bits
+
+    for (unsigned int i = 0; i < text.size(); i++){
+        hash ^= (unsigned char) text[i];
+        hash = (hash * 16777619U) & 0xffffffffU;
+    }
+    return hash;
+} // end hash_string
+
+
+
+void fill_event(Pythia8::Event& event, Pythia8::Event& process,
+                flipevent& record, flipclusterer* clusterer){
+    // Copies the visible final state out of the event record
+    // With a clusterer, everything that isn't a lepton goes into anti-kT
+    //  and the jets take the place of the partons
+
+    record.preleptons.clear();
+    record.prepartons.clear();
+    record.bpartons.clear();
+    record.METvec = fastjet::PseudoJet(0.0, 0.0, 0.0, 0.0);
+    record.HT = 0.0;
+    record.weight = 1.0;
+    if (clusterer) clusterer->input.clear();
+
+    // LOOP THROUGH TOTAL EVENT PARTICLES
+    // ----------------------------------
+    for (int iPart = 0; iPart < event.size(); iPart++){
+
+        // Skip things that we can't see
+        if (!event[iPart].isFinal()) continue;
+        if (!event[iPart].isVisible()) continue;
+        if (abs(event[iPart].eta()) >= 5.0) continue;
+
+        fastjet::PseudoJet momentum(event[iPart].px(),
+                                    event[iPart].py(),
+                                    event[iPart].pz(),
+                                    event[iPart].e());
+
+        // Fill Missing ET vector
+        record.METvec -= momentum;
+
+        // Keep track of leptons
+        if ((abs(event[iPart].id()) == 11) ||
+            (abs(event[iPart].id()) == 13) ) {
+            record.preleptons.push_back(
+                pair<int, fastjet::PseudoJet>(event[iPart].id(), momentum));
+            continue;
+        } // End "if this is an identfiable lepton"
+
+        // Hadron level: cluster it below
+        if (clusterer){
+            clusterer->input.push_back(momentum);
+            continue;
+        }
+
+        // Anything left is a parton
+        record.prepartons.push_back(
+            pair<int, fastjet::PseudoJet>(event[iPart].id(), momentum));
+        record.HT += momentum.pt();
+
+    } // End loop through event particles
+
+    // JETS (HADRON LEVEL)
+    // -------------------
+    if (clusterer){
+        cluster_jets(*clusterer);
+        for (unsigned int iJet = 0; iJet < clusterer->jets.size(); iJet++){
+            record.prepartons.push_back(
+                pair<int, fastjet::PseudoJet>(0, clusterer->jets[iJet]));
+            record.HT += clusterer->jets[iJet].pt();
+        }
+    } // End clustering
+
+    // LOOP THROUGH HARD EVENT PARTICLES
+    // ---------------------------------
+    // Parton-level b-tagging uses pythia.process.
+    // Note: the event loop used to have an "only bjets" line here,
+    //  if (!abs(id)==5) continue; which reads as (!abs(id)) == 5 and so
+    //  never skipped anything. It's left out rather than fixed so the
+    //  numbers don't move: b_selection_efficiency sees every visible
+    //  final particle of the hard process.
+    //
+    for (int iPart = 0; iPart < process.size(); iPart++){
+
+        if (!process[iPart].isFinal()) continue;
+        if (!process[iPart].isVisible()) continue;
+        if (abs(process[iPart].eta()) >= 5.0) continue;
+
+        fastjet::PseudoJet momentum(process[iPart].px(),
+                                    process[iPart].py(),
+                                    process[iPart].pz(),
+                                    process[iPart].e());
+
+        record.bpartons.push_back(
+            pair<int, fastjet::PseudoJet>(process[iPart].id(), momentum));
+
+    } // End loop through process particles
+
+} // end fill_event
+
+
+
+string cutstage_name(int stage){
+    // One word, for options and output files
+
+    if ((stage < 0) || (stage >= nCutStages)) return "";
+    return cutstage_names[stage];
+} // end cutstage_name
+
+
+
+void clear_counts(flipcounts& counts){
+    // Nothing has passed anything
+    
+    for (int stage = 0; stage < nCutStages; stage++){
+        counts.events[stage] = 0;
+        counts.weights[stage] = 0;
+    }
+} // end clear_counts
+
+
+
+void count_stage(flipcounts& counts, int stage, double weight){
+    // One more event made it past this stage
+    
+    counts.events[stage]++;
+    counts.weights[stage] += weight;
+} // end count_stage
+
+
+
+void add_counts(flipcounts& total, flipcounts& part){
+    // Counts and weights just add
+    
+    for (int stage = 0; stage < nCutStages; stage++){
+        total.events[stage] += part.events[stage];
+        total.weights[stage] += part.weights[stage];
+    }
+} // end add_counts
+
+
+
+void fill_state(flipstate& state, int isoGrid, bool check){
+    // Once per state, before its first event
+
+    fill_isogrid(state.isogrid, isoGrid, check);
+    clear_state(state);
+} // end fill_state
+
+
+
+void clear_state(flipstate& state){
+    // A new event: nothing has been worked out yet
+    
+    state.leptons_kin.clear();
+    state.leptons_kinIndex.clear();
+    state.partons.clear();
+    state.leptons_ID.clear();
+    state.leptons.clear();
+    state.bJets.clear();
+    state.MET = 0;
+    state.partonsFilled = false;
+    state.passed = cutGenerated;
+} // end clear_state
+
+
+
+static void fill_partons(flipevent& record, const effparams& params,
+                         flipstate& state){
+    // PARTON KINEMATICS
+    // Check that allowed partons satisfy kinematic cuts
+    // (no cut on the event here; isolation and the jet count use them)
+    // -------------------------------------------------
+    
+    if (state.partonsFilled) return;
+    state.partonsFilled = true;
+    
+    state.partons.clear();
+    for(unsigned int iJet = 0; iJet < record.prepartons.size(); iJet++){
+        pair<int, fastjet::PseudoJet>& parton = record.prepartons[iJet];
+        if (jet_kinematic_cut(parton.second.pt(), parton.second.eta(), params))
+            state.partons.push_back(parton);
+    } // end for loop over partons
+} // end fill_partons
+
+
+
+bool run_stage(     int stage,                  // which cutstage
+                    flipevent& record,          // the event
+                    signalregion& region,       // cuts for this SR
+                    const effparams& params,    // detector numbers
+                    unsigned int seed,          // run seed for the dice
+                    flipstate& state){          // object lists so far
+    // One cut of signal_efficiency_b. Returns true if the event passes it.
+    
+    flipdice dice;
+    
+    switch (stage){
+    
+    // LEPTON KINEMATICS
+    // Check that allowed leptons satisfy kinematic cuts
+    // -------------------------------------------------
+    case cutKinematic:
+        state.leptons_kin.clear();
+        state.leptons_kinIndex.clear();
+        for(unsigned int iLep = 0; iLep < record.preleptons.size(); iLep++){
+            pair<int, fastjet::PseudoJet>& lepton = record.preleptons[iLep];
+            if (lepton_kinematic_cut(lepton.first, lepton.second.pt(),
+                                     lepton.second.eta(), params)){
+                state.leptons_kin.push_back(lepton);
+                state.leptons_kinIndex.push_back(iLep);
+            }
+        } // end for loop over leptons
+        return (state.leptons_kin.size() > 1);
+    
+    
+    // SELECTION EFFICIENCIES
+    // (Roll the dice)
+    // ----------------------
+    // One roll per prelepton, whether it passed the kinematics or not: a
+    //  lepton's roll doesn't depend on which others a shifted pT or eta
+    //  cut lets through (FlipVariation.h, FlipThreshold.h)
+    case cutLepID: {
+        seed_dice(dice, seed, record.iEvent, cutLepID);
+        state.leptons_ID.clear();
+        unsigned int iRolled = 0;
+        double roll = 0;
+        for(unsigned int iLep = 0; iLep < state.leptons_kin.size(); iLep++){
+            while (iRolled <= state.leptons_kinIndex[iLep]){
+                roll = roll_dice(dice);
+                iRolled++;
+            }
+            if (lepton_ID_eff(state.leptons_kin[iLep].first, roll, params))
+                state.leptons_ID.push_back(state.leptons_kin[iLep]);
+        } // end for loop over leptons
+        return (state.leptons_ID.size() > 1);
+    }
+    
+    case cutLepIso: {
+        fill_partons(record, params, state);
+        state.leptons.clear();
+
+        // many jets: look only at the ones near each lepton
+        flipisogrid& grid = state.isogrid;
+        bool useGrid = (grid.from >= 0) && !state.leptons_ID.empty()
+                    && ((int) state.partons.size() >= grid.from);
+        if (!state.leptons_ID.empty()) grid.nIsoEvents++;
+        if (useGrid){
+            bin_isogrid(grid, state.partons, params.lepton_dR);
+            grid.nGridEvents++;
+        }
+
+        for(unsigned int iLep = 0; iLep < state.leptons_ID.size(); iLep++){
+            fastjet::PseudoJet& lepton = state.leptons_ID[iLep].second;
+            double cone_pT;
+            if (useGrid){
+                cone_pT = isogrid_cone(grid, lepton.eta(), lepton.phi(),
+                                       params.lepton_dR);
+                if (grid.check){
+                    grid.nChecked++;
+                    if (cone_pT != isolation_cone(state.partons, lepton.eta(),
+                                                  lepton.phi(),
+                                                  params.lepton_dR))
+                        grid.nDiffer++;
+                }
+            }
+            else cone_pT = isolation_cone(state.partons, lepton.eta(),
+                                          lepton.phi(), params.lepton_dR);
+            if (lepton_iso_eff(lepton.pt(), cone_pT, params))
+                state.leptons.push_back(state.leptons_ID[iLep]);
+        } // end for loop over leptons
+        return (state.leptons.size() > 1);
+    }
+    
+    // bjet tagging at parton level (bpartons)
+    case cutbTag:
+        seed_dice(dice, seed, record.iEvent, cutbTag);
+        state.bJets.clear();
+        for(unsigned int iJet = 0; iJet < record.bpartons.size(); iJet++)
+            if( b_selection_efficiency(record.bpartons[iJet].second.pt(),
+                                       roll_dice(dice), params) )
+                state.bJets.push_back(record.bpartons[iJet]);
+        return (state.bJets.size() > 1);
+    
+    
+    // Event cuts
+    // ----------
+    
+    // Exactly two leptons
+    case cutDilepton:
+        return (state.leptons.size() == 2);
+    
+    // Trigger efficiency for dilepton
+    // (note: passing the trigger *fails* the event; that's how the
+    //  event loop has always been written, so it stays that way here)
+    case cutDilepTrig:
+        seed_dice(dice, seed, record.iEvent, cutDilepTrig);
+        return !lepton_trig_efficiency(state.leptons.size(), 
+                                       state.leptons[0].first,
+                                       roll_dice(dice), params);
+    
+    // Same-sign dileptons
+    case cutSS2L:
+        return (state.leptons[0].first/abs(state.leptons[0].first) ==
+                state.leptons[1].first/abs(state.leptons[1].first));
+    
+    
+    // Signal region cuts: from input
+    // ------------------------------
+    case cutJets:
+        fill_partons(record, params, state);
+        return (state.partons.size() >= region.minJets);
+    
+    case cutbJets:
+        return (state.bJets.size() >= region.minbJets);
+    
+    case cutMET:
+        state.MET = record.METvec.pt();
+        seed_dice(dice, seed, record.iEvent, cutMET);
+        return METefficiency(state.MET, region.minMET, roll_dice(dice), 
+                             params);
+    
+    case cutHT:
+        seed_dice(dice, seed, record.iEvent, cutHT);
+        return HTefficiency(record.HT, region.minHT, roll_dice(dice), params);
+    
+    case cutCharge: {
+        bool minmin = (state.leptons[0].first > 0) && region.minusminus;
+        bool pluplu = (state.leptons[0].first < 0) && region.plusplus;
+        return (minmin || pluplu);
+    }
+    
+    default:
+        return true;
+    
+    } // end switch over stages
+    
+} // end run_stage
+
+
+
+bool select_event(  flipevent& record,          // the event
+                    signalregion& region,       // cuts for this SR
+                    const effparams& params,    // detector numbers
+                    unsigned int seed,          // run seed for the dice
+                    flipstate& state,           // scratch object lists
+                    flipcounts& stagecounts){   // cutflow
+    // The cuts of signal_efficiency_b, in the same order
+    
+    clear_state(state);
+    count_stage(stagecounts, cutGenerated, record.weight);
+    
+    for (int stage = cutKinematic; stage < nCutStages; stage++){
+        if (!run_stage(stage, record, region, params, seed, state)) 
+            return false;
+        count_stage(stagecounts, stage, record.weight);
+        state.passed = stage;
+    }
+    
+    // Made it this far? YOU PASS
+    return true;
+    
+} // end select_event
+
+
+
+void fill_counts(vector< pair<string, int> > &counts, flipcounts& cutflow,
+                 signalregion& region){
+    // Same labels as the event loops in FlipEfficiencySignal.cpp
+
+    fill_vector(counts, "Generated events \t", cutflow.events[cutGenerated]);
+    fill_vector(counts, ">1 lep. kin. cuts\t", cutflow.events[cutKinematic]);
+    fill_vector(counts, ">1 lep. ID. eff.\t", cutflow.events[cutLepID]);
+    fill_vector(counts, ">1 lep. Iso. eff.\t", cutflow.events[cutLepIso]);
+    fill_vector(counts, ">1 bjets tagged \t", cutflow.events[cutbTag]);
+    fill_vector(counts, "exactly two leptons \t", cutflow.events[cutDilepton]);
+    fill_vector(counts, "triggered two leptons \t", cutflow.events[cutDilepTrig]);
+    fill_vector(counts, "same sign dileptons \t", cutflow.events[cutSS2L]);
+
+    // The following cuts depend on the signal region, so we have to
+    //  "dynamically" generate their labels
+
+    stringstream nJetComment;
+    nJetComment << "at least " << region.minJets << " jets \t";
+    fill_vector(counts, nJetComment.str(), cutflow.events[cutJets]);
+
+    stringstream nbJetComment;
+    nbJetComment << "at least " << region.minbJets << " b jets \t";
+    fill_vector(counts, nbJetComment.str(), cutflow.events[cutbJets]);
+
+    stringstream nMETComment;
+    nMETComment << "at least " << region.minMET << " GeV MET \t";
+    fill_vector(counts, nMETComment.str(), cutflow.events[cutMET]);
+
+    stringstream HTComment;
+    HTComment << "at least " << region.minHT << " GeV HT \t";
+    fill_vector(counts, HTComment.str(), cutflow.events[cutHT]);
+
+    stringstream nChargeComment;
+    if ( region.minusminus && !region.plusplus)
+        nChargeComment << "only -- leptons \t";
+    else if ( !region.minusminus && region.plusplus)
+        nChargeComment << "only ++ leptons \t";
+    else if ( region.minusminus && region.plusplus)
+        nChargeComment << "either ++ or -- leptons";
+    else nChargeComment << "You fucked up, neither ++ or -- leptons ";
+
+    fill_vector(counts, nChargeComment.str(), cutflow.events[cutCharge]);
+
+} // end fill_counts
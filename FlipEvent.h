@@ -0,0 +1,204 @@
+// FlipEvent.h
+// One event's visible final state, the dice, and the selection of
+//  signal_efficiency_b written out one stage at a time
+// INCLUDE GUARD
+#ifndef __FLIPEVENT_H_INCLUDED__
+#define __FLIPEVENT_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+#include "FlipCluster.h"
+#include "FlipIsoGrid.h"
+using namespace std;
+
+enum cutstage{
+    // The cutflow of signal_efficiency_b, in the order it's reported
+    cutGenerated = 0,       // generated events
+    cutKinematic,           // >1 lepton passes kinematic cuts
+    cutLepID,               // >1 lepton passes ID
+    cutLepIso,              // >1 lepton passes isolation
+    cutbTag,                // >1 b tagged
+    cutDilepton,            // exactly two leptons
+    cutDilepTrig,           // dilepton trigger
+    cutSS2L,                // same sign
+    cutJets,                // signal region: jets
+    cutbJets,               // signal region: b jets
+    cutMET,                 // signal region: MET turn-on
+    cutHT,                  // signal region: HT turn-on
+    cutCharge,              // signal region: ++ and/or --
+    nCutStages
+};
+
+struct flipevent{
+    // Everything the selection needs from Pythia, copied out once
+    vector< pair<int, fastjet::PseudoJet> > preleptons; // from event
+    vector< pair<int, fastjet::PseudoJet> > prepartons; // from event, or
+                                                        //  jets (id 0)
+    vector< pair<int, fastjet::PseudoJet> > bpartons;   // from process
+    fastjet::PseudoJet METvec;
+    double HT;
+    int iEvent;             // event number, picks this event's dice
+    double weight;          // 1, or the decay weight (FlipBias.h)
+};
+
+struct flipcounts{
+    // The cutflow: how many events got past each cutstage, and the sum
+    //  of their weights. Without forced decays the two are the same.
+    int events[nCutStages];
+    double weights[nCutStages];
+};
+
+struct flipstate{
+    // Intermediate object lists of select_event. Keep one around and
+    //  pass it in every time, so the vectors don't get reallocated.
+    vector< pair<int, fastjet::PseudoJet> > leptons_kin;
+    vector<unsigned int> leptons_kinIndex;  // their places in preleptons
+    vector< pair<int, fastjet::PseudoJet> > partons;
+    vector< pair<int, fastjet::PseudoJet> > leptons_ID;
+    vector< pair<int, fastjet::PseudoJet> > leptons;
+    vector< pair<int, fastjet::PseudoJet> > bJets;
+    double MET;
+    bool partonsFilled;     // partons worked out for this event yet?
+    int passed;             // last cutstage passed (select_event)
+    flipisogrid isogrid;    // isolation with many jets (FlipIsoGrid.h);
+                            //  set up by fill_state, kept between events
+};
+
+struct flipdice{
+    // Counter-based random numbers. Every (run seed, event, stage) gets
+    //  its own stream, so it doesn't matter in which order the events
+    //  and stages are processed: the same event always rolls the same dice.
+    unsigned int state;
+};
+
+struct runoptions{
+    // Things that change how a run is done but not what it computes.
+    // On the command line they look like key=value, e.g. batch=64
+    int batchSize;          // 0: one event at a time, K: batches of K events
+    bool validate;          // also run the per-event path and compare
+    unsigned int seed;      // dice seed, 0 means draw one from rand()
+    int pipeline;           // 0: analyse on the generator thread,
+                            //  N: hand events to N analysis threads
+    int ringSize;           // event slots per analysis thread
+    bool hadron;            // shower + hadronize, cluster anti-kT jets
+    string strategy;        // FastJet strategy for hadron, or "auto"
+    int reorder;            // 0: canonical cut order, N: pick the order on
+                            //  the first N events (FlipOrder.h)
+    bool veto;              // veto hopeless events at the process level,
+                            //  before decays and showers (FlipVeto.h)
+    string forced;          // forced decays, e.g. 24:11,13,15 (FlipBias.h)
+    int replicas;           // 0: one efficiency, R: also replay the dice R
+                            //  times for its spread (FlipBootstrap.h)
+    string variations;      // shifted parameters to run alongside, e.g.
+                            //  b_plateau-0.05,ID_e*0.97 (FlipVariation.h)
+    string thresholds;      // kinematic thresholds to scan, e.g.
+                            //  jet_pT:30,40,50;lepton_eta:2.1,2.4
+                            //  (FlipThreshold.h)
+    string skim;            // write out the events past this cut stage,
+                            //  e.g. ss2l (FlipSkim.h); "" for none
+    string skimFile;        // ... to this file: .lhe for LHE, else records
+    string regions;         // other signal regions to cut on in the same
+                            //  run, e.g. 1,2,8 (FlipVariation.h)
+    bool quiet;             // don't print anything (FlipLibrary.h)
+    string histos;          // distributions at cut stages, e.g.
+                            //  met:ss2l,charge;njets (FlipHisto.h)
+    string histoFile;       // ... to this file: .bin for binary, else text
+    bool allCuts;           // also every cut on every event, for N-1 and
+                            //  correlations (FlipMask.h)
+    string flow;            // ... and a cutflow in this order, e.g.
+                            //  met,ht,jets (implies allCuts)
+    int isoGrid;            // isolation on an eta-phi grid for events with
+                            //  at least this many jets, -1: never (the
+                            //  default, FlipIsoGrid.h)
+    string production;      // make the gluino pairs once per gluino mass,
+                            //  keep them here and decay them for every stop
+                            //  mass, e.g. gluinos (FlipProduction.h)
+    int cascade;            // 0: Pythia decays, K: decay each stored gluino
+                            //  pair K times ourselves, parton level only
+                            //  (FlipCascade.h)
+    string calibrate;       // hadron=1: match partons to jets and write the
+                            //  maps to this file, e.g. maps.dat
+    string maps;            // parton level: apply the maps in this file
+                            //  (FlipCalibration.h)
+};
+
+
+struct flipresult{
+    // What signal_efficiency_b found, for callers that want more than the
+    //  efficiency (FlipLibrary.h)
+    double efficiency;          // weighted, per generated event
+    double sigmaGen;            // cross section (mb)
+    double sigmaErr;
+    int nEvent;
+    double seconds;             // in the event loop
+    double setupSeconds;        // before it: Pythia, init(), the lock
+    unsigned int seed;          // the dice seed that was used
+    flipcounts stagecounts;     // cutflow for the run's signal region
+    vector<string> names;       // variations and other signal regions ...
+    vector<flipcounts> varied;  // ... and their cutflows
+};
+
+
+void fill_runoptions(runoptions&);
+    // Defaults: no batching, no validation, seed from rand(), no threads
+
+bool read_runoption(runoptions&, string);
+    // Reads one key=value argument; returns false if it isn't one
+
+void seed_dice(flipdice&, unsigned int, unsigned int, unsigned int);
+    // Inputs: dice, run seed, event number, stream (use the cutstage)
+
+double roll_dice(flipdice&);
+    // Uniform random number in [0,1)
+
+unsigned int hash_string(string, unsigned int = 2166136261U);
+    // Inputs: text, starting value. For the names of cache files
+    //  (FlipDataset.h, FlipIncremental.h), not for dice
+
+void fill_event(Pythia8::Event&, Pythia8::Event&, flipevent&,
+                flipclusterer* = 0);
+    // Inputs: pythia.event, pythia.process, event record to fill,
+    //  clusterer for hadron level (0: the partons are the jets)
+    // Same particle loops that signal_efficiency_b always had
+
+string cutstage_name(int);
+    // generated, kinematic, lepid, lepiso, btag, dilepton, trigger, ss2l,
+    //  jets, bjets, met, ht, charge
+
+void clear_counts(flipcounts&);
+    // Zeroes the cutflow
+
+void count_stage(flipcounts&, int, double);
+    // Inputs: cutflow, cutstage, event weight. One more event past it
+
+void add_counts(flipcounts&, flipcounts&);
+    // Adds the second cutflow to the first
+
+void fill_state(flipstate&, int, bool = false);
+    // Inputs: lists, isolation grid from this many jets (runoptions'
+    //  isoGrid), check the grid against the plain loop. Call once, before
+    //  the first event
+
+void clear_state(flipstate&);
+    // Call before the first stage of every event
+
+bool run_stage(int, flipevent&, signalregion&, const effparams&,
+               unsigned int, flipstate&);
+    // Inputs: cutstage, event, signal region, parameters, run seed, lists
+    // Runs one cut stage and returns true if the event passes it. The
+    //  stages it builds on (see stage_needs in FlipOrder.cpp) must have
+    //  run and passed already.
+
+bool select_event(flipevent&, signalregion&, const effparams&,
+                  unsigned int, flipstate&, flipcounts&);
+    // Inputs: event, signal region, parameters, run seed, scratch lists,
+    //  cutflow (incremented as it goes)
+    // Returns true if the event passes all cuts. Stops at the first
+    //  failing cut, just like the event loop used to.
+
+void fill_counts(vector< pair<string, int> >&, flipcounts&, signalregion&);
+    // Turns the cutflow into the usual labelled list (event counts)
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPEVENT_H_INCLUDED__
@@ -0,0 +1,318 @@
+/********************************************************************************
+*   FlipHisto.cpp by Flip Tanedo (pt267@cornell.edu)                            *
+*   Histograms at the cut stages:                                               *
+*   - read_histos: which variables at which stages, with fixed binnings         *
+*   - fill_histos: from the lists select_event left in the flipstate            *
+*   - fill_batch_histos: from the columns select_batch left in the flipbatch    *
+*   - add_histos / write_histos: per-thread copies added up, then written       *
+********************************************************************************/
+
+#include "FlipHisto.h"
+#include "FlipSkim.h"                       // read_skim_stage
+
+
+static const char* histo_names[nHistoVariables] = {
+    "met", "ht", "lep_pt", "nlep", "njets", "nbjets"
+};
+
+// bins, low, high: GeV for the first three, integers (bins of 1, centred
+//  on the numbers) for the multiplicities
+static const int histo_bins[nHistoVariables]      = {50, 50, 50, 10, 16, 8};
+static const double histo_low[nHistoVariables]    = {0, 0, 0, -0.5, -0.5,
+                                                     -0.5};
+static const double histo_high[nHistoVariables]   = {1000, 2500, 500, 9.5,
+                                                     15.5, 7.5};
+
+
+
+static void add_histo(fliphistos& histos, int variable, int stage){
+    // Empty, with the variable's binning
+
+    fliphisto histo;
+    histo.variable  = variable;
+    histo.stage     = stage;
+    histo.nBins     = histo_bins[variable];
+    histo.low       = histo_low[variable];
+    histo.high      = histo_high[variable];
+    histo.perBin    = histo.nBins / (histo.high - histo.low);
+    histo.sumw.assign(histo.nBins + 2, 0.0);
+    histo.sumw2.assign(histo.nBins + 2, 0.0);
+    histo.entries.assign(histo.nBins + 2, 0);
+    histos.histos.push_back(histo);
+} // end add_histo
+
+
+
+bool read_histos(fliphistos& histos, string declaration, string filename){
+    // name:stage,stage;name;...
+
+    histos.histos.clear();
+    histos.filename = filename;
+    histos.nVetoed = 0;
+    histos.weightVetoed = 0;
+    if ((declaration == "") || (declaration == "none")) return true;
+    if (declaration == "all"){
+        for (int variable = 0; variable < nHistoVariables; variable++)
+            for (int stage = 0; stage < nCutStages; stage++)
+                add_histo(histos, variable, stage);
+        return true;
+    }
+
+    bool ok = true;
+    stringstream variables(declaration);
+    string variable;
+    while (getline(variables, variable, ';')){
+        if (variable == "") continue;
+
+        size_t colon = variable.find(':');
+        string name = variable.substr(0, colon);
+        int iVariable = -1;
+        for (int i = 0; i < nHistoVariables; i++)
+            if (name == histo_names[i]) iVariable = i;
+        if (iVariable < 0){
+            cout << endl << "ERROR: can't histogram " << name
+                 << ", leaving it out" << endl;
+            ok = false;
+            continue;
+        }
+
+        if (colon == string::npos){
+            for (int stage = 0; stage < nCutStages; stage++)
+                add_histo(histos, iVariable, stage);
+            continue;
+        }
+
+        stringstream stages(variable.substr(colon+1));
+        string stage;
+        while (getline(stages, stage, ',')){
+            if (stage == "") continue;
+            int iStage = read_skim_stage(stage);
+            if (iStage < 0){
+                cout << endl << "ERROR: no cut stage called " << stage
+                     << ", leaving " << name << " there out" << endl;
+                ok = false;
+                continue;
+            }
+            add_histo(histos, iVariable, iStage);
+        }
+    }
+    return ok;
+} // end read_histos
+
+
+
+void clear_histos(fliphistos& histos){
+    // Same binnings, no events
+
+    histos.nVetoed = 0;
+    histos.weightVetoed = 0;
+    for (unsigned int i = 0; i < histos.histos.size(); i++){
+        fliphisto& histo = histos.histos[i];
+        histo.sumw.assign(histo.nBins + 2, 0.0);
+        histo.sumw2.assign(histo.nBins + 2, 0.0);
+        histo.entries.assign(histo.nBins + 2, 0);
+    }
+} // end clear_histos
+
+
+
+static vector< pair<int, fastjet::PseudoJet> >& stage_leptons(
+        flipevent& record, flipstate& state, int stage){
+    // The leptons as they are after the stage
+    if (stage >= cutLepIso) return state.leptons;
+    if (stage == cutLepID) return state.leptons_ID;
+    if (stage == cutKinematic) return state.leptons_kin;
+    return record.preleptons;
+} // end stage_leptons
+
+
+
+static void fill_bin(fliphisto& histo, double value, double weight){
+    // Underflow, overflow or the bin the value is in
+
+    int bin = 0;
+    if (value >= histo.high) bin = histo.nBins + 1;
+    else if (value >= histo.low)
+        bin = 1 + (int) ((value - histo.low) * histo.perBin);
+    histo.sumw[bin]  += weight;
+    histo.sumw2[bin] += weight * weight;
+    histo.entries[bin]++;
+} // end fill_bin
+
+
+
+void fill_histos(fliphistos& histos, flipevent& record, signalregion& region,
+                 const effparams& params, unsigned int seed,
+                 flipstate& state){
+    // Every histogram at a stage the event got past
+
+    if (histos.histos.empty()) return;
+
+    // the jets, if the cuts stopped before they were needed
+    if (!state.partonsFilled) run_stage(cutJets, record, region, params, seed,
+                                        state);
+
+    double weight = record.weight;
+    for (unsigned int i = 0; i < histos.histos.size(); i++){
+        fliphisto& histo = histos.histos[i];
+        if (histo.stage > state.passed) continue;
+
+        double value = 0;
+        switch (histo.variable){
+        case histoMET:      value = record.METvec.pt();                 break;
+        case histoHT:       value = record.HT;                          break;
+        case histoLepPT: {
+            vector< pair<int, fastjet::PseudoJet> >& leptons =
+                stage_leptons(record, state, histo.stage);
+            for (unsigned int j = 0; j < leptons.size(); j++)
+                if (leptons[j].second.pt() > value)
+                    value = leptons[j].second.pt();
+            break;
+        }
+        case histoNLep:
+            value = stage_leptons(record, state, histo.stage).size();   break;
+        case histoNJets:    value = state.partons.size();               break;
+        case histoNbJets:   // by the histogram's stage, not how far the
+                            //  event got: tags from the btag stage on
+            value = (histo.stage >= cutbTag) ? state.bJets.size()
+                                             : record.bpartons.size();
+            break;
+        }
+
+        fill_bin(histo, value, weight);
+    }
+} // end fill_histos
+
+
+
+void fill_batch_histos(fliphistos& histos, flipbatch& batch,
+                       const effparams& params){
+    // Same numbers as fill_histos, event by event from the columns
+
+    if (histos.histos.empty()) return;
+
+    for (int k = 0; k < batch.nEvents; k++){
+        double weight = batch.weight[k];
+
+        // the jets, if the cuts stopped before they were needed
+        int nJet = batch.nJet[k];
+        if (batch.passed[k] < cutKinematic){
+            nJet = 0;
+            for (int j = batch.jetBegin[k]; j < batch.jetBegin[k+1]; j++)
+                nJet += jet_kinematic_cut(batch.jetPt[j], batch.jetEta[j],
+                                          params);
+        }
+
+        for (unsigned int i = 0; i < histos.histos.size(); i++){
+            fliphisto& histo = histos.histos[i];
+            if (histo.stage > batch.passed[k]) continue;
+
+            // the leptons as they are after the stage
+            int lepStage = (histo.stage < cutLepIso) ? histo.stage
+                                                      : int(cutLepIso);
+            double value = 0;
+            switch (histo.variable){
+            case histoMET:      value = batch.MET[k];                   break;
+            case histoHT:       value = batch.HT[k];                    break;
+            case histoLepPT:
+                for (int l = batch.lepBegin[k]; l < batch.lepBegin[k+1]; l++)
+                    if ((batch.lepStage[l] >= lepStage) &&
+                        (batch.lepPt[l] > value))
+                        value = batch.lepPt[l];
+                break;
+            case histoNLep:
+                for (int l = batch.lepBegin[k]; l < batch.lepBegin[k+1]; l++)
+                    value += (batch.lepStage[l] >= lepStage);
+                break;
+            case histoNJets:    value = nJet;                           break;
+            case histoNbJets:
+                value = (histo.stage >= cutbTag) ? batch.nbTag[k]
+                        : batch.bBegin[k+1] - batch.bBegin[k];
+                break;
+            }
+            fill_bin(histo, value, weight);
+        }
+    }
+} // end fill_batch_histos
+
+
+
+void add_histos(fliphistos& total, fliphistos& part){
+    // Bin by bin
+
+    total.nVetoed      += part.nVetoed;
+    total.weightVetoed += part.weightVetoed;
+    for (unsigned int i = 0; (i < total.histos.size()) &&
+                             (i < part.histos.size()); i++)
+        for (unsigned int bin = 0; bin < total.histos[i].sumw.size(); bin++){
+            total.histos[i].sumw[bin]    += part.histos[i].sumw[bin];
+            total.histos[i].sumw2[bin]   += part.histos[i].sumw2[bin];
+            total.histos[i].entries[bin] += part.histos[i].entries[bin];
+        }
+} // end add_histos
+
+
+
+void write_histos(fliphistos& histos, int nEvent){
+    // Text: a header line per histogram, then one line per bin (the
+    //  underflow and overflow first and last). Binary (.bin): "FLIPHST2",
+    //  # histograms, nEvent, # vetoed (ints), their weight (double), then
+    //  for each: variable, stage, nBins (ints), low, high (doubles), and
+    //  sumw, sumw2 (nBins+2 doubles each), entries (nBins+2 ints)
+    // The vetoed events are generated ones: the generated-stage histograms
+    //  are short of exactly those
+
+    if (histos.histos.empty()) return;
+
+    size_t dot = histos.filename.rfind('.');
+    bool binary = (dot != string::npos) &&
+                  (histos.filename.substr(dot) == ".bin");
+
+    if (binary){
+        ofstream out(histos.filename.c_str(), ios::out | ios::binary);
+        int nHistos = histos.histos.size();
+        out.write("FLIPHST2", 8);
+        out.write((const char*) &nHistos, sizeof(nHistos));
+        out.write((const char*) &nEvent, sizeof(nEvent));
+        out.write((const char*) &histos.nVetoed, sizeof(histos.nVetoed));
+        out.write((const char*) &histos.weightVetoed,
+                  sizeof(histos.weightVetoed));
+        for (int i = 0; i < nHistos; i++){
+            fliphisto& histo = histos.histos[i];
+            int size = histo.nBins + 2;
+            out.write((const char*) &histo.variable, sizeof(histo.variable));
+            out.write((const char*) &histo.stage, sizeof(histo.stage));
+            out.write((const char*) &histo.nBins, sizeof(histo.nBins));
+            out.write((const char*) &histo.low, sizeof(histo.low));
+            out.write((const char*) &histo.high, sizeof(histo.high));
+            out.write((const char*) &histo.sumw[0], size * sizeof(double));
+            out.write((const char*) &histo.sumw2[0], size * sizeof(double));
+            out.write((const char*) &histo.entries[0], size * sizeof(int));
+        }
+        out.close();
+        return;
+    }
+
+    ofstream out(histos.filename.c_str());
+    out << setprecision(10);
+    out << "# " << nEvent << " events generated; per bin: low edge, high "
+        << "edge, sum of weights, sum of weights^2, entries" << endl;
+    out << "# vetoed " << histos.nVetoed << " " << histos.weightVetoed
+        << " (at process level: generated, in no bin)" << endl;
+    for (unsigned int i = 0; i < histos.histos.size(); i++){
+        fliphisto& histo = histos.histos[i];
+        out << endl << "histogram " << histo_names[histo.variable] << " "
+            << cutstage_name(histo.stage) << " " << histo.nBins << " "
+            << histo.low << " " << histo.high << endl;
+        double width = (histo.high - histo.low) / histo.nBins;
+        for (int bin = 0; bin < histo.nBins + 2; bin++){
+            if (bin == 0) out << "-inf\t" << histo.low;
+            else if (bin == histo.nBins + 1) out << histo.high << "\tinf";
+            else out << histo.low + (bin - 1) * width << "\t"
+                     << histo.low + bin * width;
+            out << "\t" << histo.sumw[bin] << "\t" << histo.sumw2[bin] << "\t"
+                << histo.entries[bin] << endl;
+        }
+    }
+    out.close();
+} // end write_histos
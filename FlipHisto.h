@@ -0,0 +1,82 @@
+// FlipHisto.h
+// Distributions at the cut stages: MET, HT, lepton pT, and the lepton,
+//  jet and b multiplicities of the events that got that far
+// INCLUDE GUARD
+#ifndef __FLIPHISTO_H_INCLUDED__
+#define __FLIPHISTO_H_INCLUDED__
+
+#include "FlipEvent.h"
+#include "FlipBatch.h"
+using namespace std;
+
+enum histovariable{
+    // What can be histogrammed, with the lists as they are at the stage
+    histoMET = 0,           // met:    MET (GeV)
+    histoHT,                // ht:     HT (GeV)
+    histoLepPT,             // lep_pt: pT of the leading lepton (GeV)
+    histoNLep,              // nlep:   # leptons
+    histoNJets,             // njets:  # partons (jets) past the jet cuts
+    histoNbJets,            // nbjets: # b tags (# b partons before btag)
+    nHistoVariables
+};
+
+struct fliphisto{
+    // One variable at one cutstage. Bin 0 is the underflow, bin nBins+1
+    //  the overflow; the sums are of the event weights (FlipBias.h)
+    int variable;                       // histovariable
+    int stage;                          // cutstage
+    int nBins;
+    double low, high;
+    double perBin;                      // nBins / (high - low)
+    vector<double> sumw;
+    vector<double> sumw2;
+    vector<int> entries;
+};
+
+struct fliphistos{
+    // Declared on the command line as histos=name:stage,stage;name;...
+    //  e.g. histos=met:ss2l,charge;njets (no stages: every stage), or
+    //  histos=all. Every analysis (and every analysis thread) fills its
+    //  own copy with nothing shared, no locks, no atomics; the copies are
+    //  added up at the end (merge_analysis in FlipPipeline.cpp).
+    // Filling is a bin number and three adds per histogram the event
+    //  gets to: the numbers come from what the selection already worked
+    //  out (select_event's lists, order_event's, select_batch's columns),
+    //  so the nominal selection isn't run twice.
+    vector<fliphisto> histos;
+    string filename;                    // .bin: binary, anything else: text
+    int nVetoed;                        // vetoed at process level (veto=1):
+    double weightVetoed;                //  generated, but with nothing to
+                                        //  put in a bin
+};
+
+
+bool read_histos(fliphistos&, string, string);
+    // Inputs: histos, declaration, output file name
+    // "" or "none": no histograms. Returns false (and leaves them out)
+    //  for names or stages it doesn't know
+
+void clear_histos(fliphistos&);
+    // Same histograms, empty
+
+void fill_histos(fliphistos&, flipevent&, signalregion&, const effparams&,
+                 unsigned int, flipstate&);
+    // Inputs: histos, event, signal region, parameters, run seed, and the
+    //  lists select_event left behind for this event (state.passed says
+    //  how far it got)
+
+void fill_batch_histos(fliphistos&, flipbatch&, const effparams&);
+    // Inputs: histos, batch, parameters. Same, for a batch after
+    //  select_batch (its passed and lepStage columns say how far each
+    //  event and each lepton got)
+
+void add_histos(fliphistos&, fliphistos&);
+    // Adds the second to the first (same declaration)
+
+void write_histos(fliphistos&, int);
+    // Inputs: histos, nEvent. Writes histos.filename
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPHISTO_H_INCLUDED__
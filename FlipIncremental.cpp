@@ -0,0 +1,600 @@
+/********************************************************************************
+*   FlipIncremental.cpp by Flip Tanedo (pt267@cornell.edu)                      *
+*   The selection on skimmed events, one stored stage at a time:                *
+*   - keys: each stage's parameters and the keys of the stages it uses          *
+*   - the stages themselves, the same cuts and dice as run_stage                *
+*   - the signal region cuts, from the stored numbers, every time               *
+********************************************************************************/
+
+#include "FlipIncremental.h"
+#include "FlipVariation.h"                  // effparam_members
+#include "FlipSkim.h"                       // read_skim_event
+#include <sys/stat.h>                       // stat, mkdir
+
+
+static const char* incstage_names[nIncStages] = {
+    "events", "kinematic", "jets", "lepid", "lepiso", "btag", "preselection"
+};
+
+
+
+void fill_incremental(flipincremental& inc){
+    // Nothing read yet
+
+    inc.eventsFile  = "events.dat";
+    inc.cacheDir    = "replaycache";
+    inc.settings    = "";
+    inc.seed        = 0;
+    inc.nEvent      = -1;
+    inc.skimStage   = "";
+    inc.mstop       = 0;
+    inc.mglu        = 0;
+    fill_effparams(inc.params);
+    vector<signalregion> signal_region;
+    fill_signalregions(signal_region);
+    inc.region      = signal_region[8];
+    inc.loaded      = false;
+    inc.events.clear();
+    for (int stage = 0; stage < nIncStages; stage++){
+        inc.keys[stage] = 0;
+        inc.recomputed[stage] = false;
+        inc.stageTime[stage] = 0;
+    }
+    inc.tailTime    = 0;
+    clear_counts(inc.stagecounts);
+} // end fill_incremental
+
+
+
+bool read_incrementaloption(flipincremental& inc, string argument){
+    // key=value, like read_runoption
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    if      (key == "cache")    inc.cacheDir = value;
+    else if (key == "set")      inc.settings = value;
+    else return false;
+    return true;
+} // end read_incrementaloption
+
+
+
+static bool apply_setting(flipincremental& inc, string setting){
+    // name=value, into the signal region or the parameters
+
+    size_t equals = setting.find('=');
+    if (equals == string::npos) return false;
+    string name = setting.substr(0, equals);
+    double value = atof(setting.substr(equals+1).c_str());
+
+    if      (name == "minJets")     inc.region.minJets    = (unsigned int) value;
+    else if (name == "minbJets")    inc.region.minbJets   = (unsigned int) value;
+    else if (name == "minMET")      inc.region.minMET     = value;
+    else if (name == "minHT")       inc.region.minHT      = value;
+    else if (name == "plusplus")    inc.region.plusplus   = (value != 0);
+    else if (name == "minusminus")  inc.region.minusminus = (value != 0);
+    else {
+        vector<double*> members;
+        effparam_members(inc.params, name, members);
+        if (members.empty()) return false;
+        for (unsigned int i = 0; i < members.size(); i++)
+            *members[i] = value;
+    }
+    return true;
+} // end apply_setting
+
+
+
+bool read_incremental(flipincremental& inc, string filename, int iSR){
+    // The records, what the .meta says about them, the cuts
+
+    inc.eventsFile = filename;
+    ifstream test(filename.c_str());
+    if (!test.is_open()){
+        cout << endl << "ERROR: can't read " << filename << endl;
+        return false;
+    }
+
+    vector<signalregion> signal_region;
+    fill_signalregions(signal_region);
+    if ((iSR < 0) || (iSR >= (int) signal_region.size())){
+        cout << endl << "ERROR: there's no signal region " << iSR << endl;
+        return false;
+    }
+    inc.region = signal_region[iSR];
+    fill_effparams(inc.params);
+
+    // key value, see write_skim_meta
+    string metafile = filename + ".meta";
+    ifstream meta(metafile.c_str());
+    string line;
+    while (getline(meta, line)){
+        stringstream words(line);
+        string key, value;
+        words >> key >> value;
+        if      (key == "seed")   inc.seed      = strtoul(value.c_str(), 0, 10);
+        else if (key == "nEvent") inc.nEvent    = atoi(value.c_str());
+        else if (key == "stage")  inc.skimStage = value;
+        else if (key == "mstop")  inc.mstop     = atof(value.c_str());
+        else if (key == "mglu")   inc.mglu      = atof(value.c_str());
+    }
+    if (!meta.is_open())
+        cout << "No " << metafile << ": give the seed of the run that "
+             << "skimmed with seed=, or the dice won't be the same" << endl;
+
+    stringstream settings(inc.settings);
+    string setting;
+    while (getline(settings, setting, ','))
+        if ((setting != "") && !apply_setting(inc, setting)){
+            cout << endl << "ERROR: can't set " << setting << endl;
+            return false;
+        }
+    return true;
+} // end read_incremental
+
+
+
+/********************************************************************************
+*   Keys and files                                                              *
+********************************************************************************/
+
+static unsigned int stage_key(flipincremental& inc, int stage){
+    // Hash of what the stage's results depend on, upstream keys included,
+    //  so a change anywhere upstream changes the key too
+
+    effparams& p = inc.params;
+    stringstream key;
+    key << setprecision(17) << incstage_names[stage];
+
+    switch (stage){
+    case incEvents: {
+        struct stat info;
+        long size = 0, modified = 0;
+        if (stat(inc.eventsFile.c_str(), &info) == 0){
+            size = (long) info.st_size;
+            modified = (long) info.st_mtime;
+        }
+        key << " file=" << inc.eventsFile << " size=" << size
+            << " modified=" << modified;
+        break;
+    }
+    case incKinematic:
+        key << " events=" << inc.keys[incEvents]
+            << " electron_pT=" << p.electron_pT << " muon_pT=" << p.muon_pT
+            << " lepton_eta=" << p.lepton_eta << " eta_bar=" << p.eta_bar
+            << " eta_end=" << p.eta_end;
+        break;
+    case incJets:
+        key << " events=" << inc.keys[incEvents]
+            << " jet_pT=" << p.jet_pT << " jet_eta=" << p.jet_eta;
+        break;
+    case incLepID:
+        key << " kinematic=" << inc.keys[incKinematic]
+            << " ID_e=" << p.ID_e << " ID_mu=" << p.ID_mu
+            << " seed=" << inc.seed;
+        break;
+    case incLepIso:
+        key << " lepid=" << inc.keys[incLepID]
+            << " jets=" << inc.keys[incJets]
+            << " lepton_dR=" << p.lepton_dR << " Iiso=" << p.Iiso;
+        break;
+    case incbTag:
+        key << " events=" << inc.keys[incEvents]
+            << " b_plateau=" << p.b_plateau << " b_lowpT=" << p.b_lowpT
+            << " b_highpT=" << p.b_highpT << " b_lowslope=" << p.b_lowslope
+            << " b_highslope=" << p.b_highslope << " b_minpT=" << p.b_minpT
+            << " seed=" << inc.seed;
+        break;
+    case incPreselection:
+        key << " lepiso=" << inc.keys[incLepIso]
+            << " btag=" << inc.keys[incbTag]
+            << " eff_ee=" << p.eff_ee << " eff_emu=" << p.eff_emu
+            << " eff_mumu=" << p.eff_mumu << " seed=" << inc.seed;
+        break;
+    }
+    return hash_string(key.str());
+} // end stage_key
+
+
+
+static string stage_file(flipincremental& inc, int stage){
+    // cacheDir/name_key.bin
+    stringstream name;
+    name << inc.cacheDir << "/" << incstage_names[stage] << "_" << hex
+         << setw(8) << setfill('0') << inc.keys[stage] << ".bin";
+    return name.str();
+} // end stage_file
+
+
+
+template <class T>
+static void put_vector(ostream& out, vector<T>& values){
+    // size, then the values as they are in memory
+    unsigned int n = values.size();
+    out.write((const char*) &n, sizeof(n));
+    if (n > 0) out.write((const char*) &values[0], n * sizeof(T));
+} // end put_vector
+
+template <class T>
+static bool get_vector(istream& in, vector<T>& values, unsigned int n){
+    // n values, or false
+    unsigned int stored = 0;
+    if (!in.read((char*) &stored, sizeof(stored)) || (stored != n))
+        return false;
+    values.resize(n);
+    if (n > 0) in.read((char*) &values[0], n * sizeof(T));
+    return !in.fail();
+} // end get_vector
+
+
+
+static void write_stage(flipincremental& inc, int stage){
+    // FLIPINC1, key, vectors. To a temporary name first, then renamed
+
+    string filename = stage_file(inc, stage);
+    string temporary = filename + ".tmp";
+    ofstream out(temporary.c_str(), ios::out | ios::binary);
+    out.write("FLIPINC1", 8);
+    out.write((const char*) &inc.keys[stage], sizeof(inc.keys[stage]));
+
+    switch (stage){
+    case incEvents:
+        put_vector(out, inc.iEvent);
+        put_vector(out, inc.weight);
+        put_vector(out, inc.MET);
+        put_vector(out, inc.HT);
+        put_vector(out, inc.leptonStart);
+        put_vector(out, inc.partonStart);
+        break;
+    case incKinematic:      put_vector(out, inc.kinematic);     break;
+    case incJets:           put_vector(out, inc.jets);
+                            put_vector(out, inc.nJets);         break;
+    case incLepID:          put_vector(out, inc.lepID);         break;
+    case incLepIso:         put_vector(out, inc.lepIso);        break;
+    case incbTag:           put_vector(out, inc.nbJets);        break;
+    case incPreselection:   put_vector(out, inc.passed);
+                            put_vector(out, inc.leadID);        break;
+    }
+    out.close();
+    rename(temporary.c_str(), filename.c_str());
+} // end write_stage
+
+
+
+static bool read_stage(flipincremental& inc, int stage){
+    // Only if it's there, has the key, and has the right sizes
+
+    ifstream in(stage_file(inc, stage).c_str(), ios::in | ios::binary);
+    if (!in.is_open()) return false;
+
+    char header[8];
+    unsigned int key = 0;
+    if (!in.read(header, 8) || (string(header, 8) != "FLIPINC1")) return false;
+    if (!in.read((char*) &key, sizeof(key)) || (key != inc.keys[stage]))
+        return false;
+
+    if (stage == incEvents){
+        unsigned int n = 0;
+        in.read((char*) &n, sizeof(n));     // # events, from the first one
+        in.seekg(-(int) sizeof(n), ios::cur);
+        return get_vector(in, inc.iEvent, n) && get_vector(in, inc.weight, n)
+            && get_vector(in, inc.MET, n) && get_vector(in, inc.HT, n)
+            && get_vector(in, inc.leptonStart, n + 1)
+            && get_vector(in, inc.partonStart, n + 1);
+    }
+
+    unsigned int nEvents  = inc.iEvent.size();
+    unsigned int nLeptons = inc.leptonStart.back();
+    unsigned int nPartons = inc.partonStart.back();
+    switch (stage){
+    case incKinematic:      return get_vector(in, inc.kinematic, nLeptons);
+    case incJets:           return get_vector(in, inc.jets, nPartons)
+                                && get_vector(in, inc.nJets, nEvents);
+    case incLepID:          return get_vector(in, inc.lepID, nLeptons);
+    case incLepIso:         return get_vector(in, inc.lepIso, nLeptons);
+    case incbTag:           return get_vector(in, inc.nbJets, nEvents);
+    case incPreselection:   return get_vector(in, inc.passed, nEvents)
+                                && get_vector(in, inc.leadID, nEvents);
+    }
+    return false;
+} // end read_stage
+
+
+
+static bool load_events(flipincremental& inc){
+    // The skim records, once
+
+    if (inc.loaded) return true;
+    ifstream in(inc.eventsFile.c_str(), ios::in | ios::binary);
+    char header[8];
+    if (!in.read(header, 8) || (string(header, 8) != "FLIPSKM1")){
+        cout << endl << "ERROR: " << inc.eventsFile << " isn't a skim of "
+             << "event records (skimfile= without .lhe)" << endl;
+        return false;
+    }
+
+    inc.events.clear();
+    flipevent record;
+    while (read_skim_event(in, record)) inc.events.push_back(record);
+    inc.loaded = true;
+    return true;
+} // end load_events
+
+
+
+/********************************************************************************
+*   The stages: the cuts of run_stage, for every event and object at once       *
+********************************************************************************/
+
+static void compute_stage(flipincremental& inc, int stage){
+    // Needs the events, and the stages this one uses
+
+    effparams& params = inc.params;
+    int nEvents = inc.events.size();
+    flipdice dice;
+
+    switch (stage){
+
+    case incEvents:
+        inc.iEvent.resize(nEvents);
+        inc.weight.resize(nEvents);
+        inc.MET.resize(nEvents);
+        inc.HT.resize(nEvents);
+        inc.leptonStart.assign(1, 0);
+        inc.partonStart.assign(1, 0);
+        for (int e = 0; e < nEvents; e++){
+            flipevent& record = inc.events[e];
+            inc.iEvent[e] = record.iEvent;
+            inc.weight[e] = record.weight;
+            inc.MET[e]    = record.METvec.pt();
+            inc.HT[e]     = record.HT;
+            inc.leptonStart.push_back(inc.leptonStart.back()
+                                      + record.preleptons.size());
+            inc.partonStart.push_back(inc.partonStart.back()
+                                      + record.prepartons.size());
+        }
+        break;
+
+    case incKinematic:
+        inc.kinematic.assign(inc.leptonStart.back(), 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& leptons =
+                inc.events[e].preleptons;
+            for (unsigned int i = 0; i < leptons.size(); i++)
+                inc.kinematic[inc.leptonStart[e] + i] =
+                    lepton_kinematic_cut(leptons[i].first,
+                                         leptons[i].second.pt(),
+                                         leptons[i].second.eta(), params);
+        }
+        break;
+
+    case incJets:
+        inc.jets.assign(inc.partonStart.back(), 0);
+        inc.nJets.assign(nEvents, 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& partons =
+                inc.events[e].prepartons;
+            for (unsigned int i = 0; i < partons.size(); i++)
+                if (jet_kinematic_cut(partons[i].second.pt(),
+                                      partons[i].second.eta(), params)){
+                    inc.jets[inc.partonStart[e] + i] = 1;
+                    inc.nJets[e]++;
+                }
+        }
+        break;
+
+    case incLepID:
+        // one roll per lepton, kinematic or not, in order (as cutLepID)
+        inc.lepID.assign(inc.leptonStart.back(), 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& leptons =
+                inc.events[e].preleptons;
+            seed_dice(dice, inc.seed, inc.iEvent[e], cutLepID);
+            for (unsigned int i = 0; i < leptons.size(); i++){
+                int k = inc.leptonStart[e] + i;
+                double roll = roll_dice(dice);
+                if (inc.kinematic[k])
+                    inc.lepID[k] = lepton_ID_eff(leptons[i].first, roll,
+                                                 params);
+            }
+        }
+        break;
+
+    case incLepIso:
+        // cone pT from the partons that pass the jet cuts (as cutLepIso)
+        inc.lepIso.assign(inc.leptonStart.back(), 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& leptons =
+                inc.events[e].preleptons;
+            vector< pair<int, fastjet::PseudoJet> >& partons =
+                inc.events[e].prepartons;
+            for (unsigned int i = 0; i < leptons.size(); i++){
+                int k = inc.leptonStart[e] + i;
+                if (!inc.lepID[k]) continue;
+                fastjet::PseudoJet& lepton = leptons[i].second;
+                double cone_pT = 0;
+                for (unsigned int j = 0; j < partons.size(); j++){
+                    if (!inc.jets[inc.partonStart[e] + j]) continue;
+                    fastjet::PseudoJet& parton = partons[j].second;
+                    if (get_deltaR(lepton.eta(), lepton.phi(),
+                                   parton.eta(), parton.phi())
+                        < params.lepton_dR)
+                        cone_pT += parton.pt();
+                }
+                inc.lepIso[k] = lepton_iso_eff(lepton.pt(), cone_pT, params);
+            }
+        }
+        break;
+
+    case incbTag:
+        inc.nbJets.assign(nEvents, 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& bpartons =
+                inc.events[e].bpartons;
+            seed_dice(dice, inc.seed, inc.iEvent[e], cutbTag);
+            for (unsigned int i = 0; i < bpartons.size(); i++)
+                if (b_selection_efficiency(bpartons[i].second.pt(),
+                                           roll_dice(dice), params))
+                    inc.nbJets[e]++;
+        }
+        break;
+
+    case incPreselection:
+        // cutKinematic ... cutSS2L, stopping at the first that fails
+        inc.passed.assign(nEvents, cutGenerated);
+        inc.leadID.assign(nEvents, 0);
+        for (int e = 0; e < nEvents; e++){
+            vector< pair<int, fastjet::PseudoJet> >& leptons =
+                inc.events[e].preleptons;
+            int nKin = 0, nID = 0, nIso = 0;
+            int lead = 0, second = 0;
+            for (unsigned int i = 0; i < leptons.size(); i++){
+                int k = inc.leptonStart[e] + i;
+                nKin += inc.kinematic[k];
+                nID  += inc.lepID[k];
+                if (!inc.lepIso[k]) continue;
+                if (nIso == 0) lead = leptons[i].first;
+                if (nIso == 1) second = leptons[i].first;
+                nIso++;
+            }
+            inc.leadID[e] = lead;
+
+            int& passed = inc.passed[e];
+            if (nKin < 2) continue;
+            passed = cutKinematic;
+            if (nID < 2) continue;
+            passed = cutLepID;
+            if (nIso < 2) continue;
+            passed = cutLepIso;
+            if (inc.nbJets[e] < 2) continue;
+            passed = cutbTag;
+            if (nIso != 2) continue;
+            passed = cutDilepton;
+            seed_dice(dice, inc.seed, inc.iEvent[e], cutDilepTrig);
+            if (lepton_trig_efficiency(nIso, lead, roll_dice(dice), params))
+                continue;               // (inverted, as in run_stage)
+            passed = cutDilepTrig;
+            if (lead/abs(lead) != second/abs(second)) continue;
+            passed = cutSS2L;
+        }
+        break;
+    }
+} // end compute_stage
+
+
+
+static void run_tail(flipincremental& inc){
+    // The cutflow: the stored preselection, then the signal region cuts
+
+    signalregion& region = inc.region;
+    clear_counts(inc.stagecounts);
+    flipdice dice;
+
+    for (unsigned int e = 0; e < inc.iEvent.size(); e++){
+        double weight = inc.weight[e];
+        for (int stage = cutGenerated; stage <= inc.passed[e]; stage++)
+            count_stage(inc.stagecounts, stage, weight);
+        if (inc.passed[e] != cutSS2L) continue;
+
+        if (inc.nJets[e] < (int) region.minJets) continue;
+        count_stage(inc.stagecounts, cutJets, weight);
+        if (inc.nbJets[e] < (int) region.minbJets) continue;
+        count_stage(inc.stagecounts, cutbJets, weight);
+
+        seed_dice(dice, inc.seed, inc.iEvent[e], cutMET);
+        if (!METefficiency(inc.MET[e], region.minMET, roll_dice(dice),
+                           inc.params)) continue;
+        count_stage(inc.stagecounts, cutMET, weight);
+
+        seed_dice(dice, inc.seed, inc.iEvent[e], cutHT);
+        if (!HTefficiency(inc.HT[e], region.minHT, roll_dice(dice),
+                          inc.params)) continue;
+        count_stage(inc.stagecounts, cutHT, weight);
+
+        bool minmin = (inc.leadID[e] > 0) && region.minusminus;
+        bool pluplu = (inc.leadID[e] < 0) && region.plusplus;
+        if (!(minmin || pluplu)) continue;
+        count_stage(inc.stagecounts, cutCharge, weight);
+    }
+} // end run_tail
+
+
+
+bool run_incremental(flipincremental& inc){
+    // Stage by stage: the key, then the cache or the work
+
+    if (inc.cacheDir != "") mkdir(inc.cacheDir.c_str(), 0755);
+
+    for (int stage = 0; stage < nIncStages; stage++){
+        double startTime = wall_seconds();
+        inc.keys[stage] = stage_key(inc, stage);
+        inc.recomputed[stage] = false;
+
+        if ((inc.cacheDir == "") || !read_stage(inc, stage)){
+            if (!load_events(inc)) return false;
+            compute_stage(inc, stage);
+            inc.recomputed[stage] = true;
+            if (inc.cacheDir != "") write_stage(inc, stage);
+        }
+        inc.stageTime[stage] = wall_seconds() - startTime;
+    }
+
+    if (inc.nEvent < 0) inc.nEvent = inc.iEvent.size();
+
+    double startTime = wall_seconds();
+    run_tail(inc);
+    inc.tailTime = wall_seconds() - startTime;
+    return true;
+} // end run_incremental
+
+
+
+bool validate_incremental(flipincremental& inc, const runoptions& options){
+    // The straightforward way, on the same events
+
+    if (!load_events(inc)) return false;
+
+    flipstate state;
+    fill_state(state, options.isoGrid);
+    flipcounts check;
+    clear_counts(check);
+    for (unsigned int e = 0; e < inc.events.size(); e++)
+        select_event(inc.events[e], inc.region, inc.params, inc.seed, state,
+                     check);
+
+    int nStageDiff = 0;
+    for (int stage = 0; stage < nCutStages; stage++)
+        if (check.events[stage] != inc.stagecounts.events[stage]) nStageDiff++;
+    cout << "Validation: " << nStageDiff << " cut stages differ from "
+         << "select_event" << endl;
+    return (nStageDiff == 0);
+} // end validate_incremental
+
+
+
+void report_incremental(flipincremental& inc){
+    // Where each stage came from, then the usual
+
+    cout << endl << "Replay of " << inc.eventsFile;
+    if (inc.skimStage != "") cout << " (skimmed past " << inc.skimStage << ")";
+    cout << ", seed " << inc.seed << endl;
+    for (int stage = 0; stage < nIncStages; stage++)
+        cout << "  " << incstage_names[stage] << ":\t"
+             << (inc.recomputed[stage] ? "worked out" : "from the cache")
+             << " (" << inc.stageTime[stage] << " s)" << endl;
+    cout << "  signal region cuts:\t" << inc.tailTime << " s" << endl;
+
+    vector< pair<string, int> > counts;
+    fill_counts(counts, inc.stagecounts, inc.region);
+    read_count(counts);
+    if ((inc.skimStage != "") && (inc.skimStage != "generated"))
+        cout << "(the cuts up to " << inc.skimStage << " only see the "
+             << "skimmed events)" << endl;
+
+    cout << "Efficiency: " << inc.stagecounts.weights[cutCharge]
+                              / double(inc.nEvent)
+         << " (per " << inc.nEvent << " generated)" << endl;
+} // end report_incremental
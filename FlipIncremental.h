@@ -0,0 +1,100 @@
+// FlipIncremental.h
+// The selection on stored events (skim records, FlipSkim.h) one stage at
+//  a time, each stage's per-event results kept on disk under a key made
+//  of its parameters and the keys of the stages it uses, so a rerun only
+//  redoes the stages something changed for
+// INCLUDE GUARD
+#ifndef __FLIPINCREMENTAL_H_INCLUDED__
+#define __FLIPINCREMENTAL_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+enum incstage{
+    // What gets kept, and what each one uses
+    incEvents = 0,          // weight, MET, HT, # objects: the file
+    incKinematic,           // lepton kinematic cuts: the file, lepton cuts
+    incJets,                // parton/jet kinematic cuts: the file, jet cuts
+    incLepID,               // lepton ID: kinematic, ID_e/mu, seed
+    incLepIso,              // isolation: ID, jets, lepton_dR, Iiso
+    incbTag,                // # b tags: the file, b_..., seed
+    incPreselection,        // last cut passed up to ss2l, the leading
+                            //  lepton: isolation, b tags, trigger, seed
+    nIncStages
+};
+// The signal region cuts (jets, b jets, MET, HT, charge) use the numbers
+//  above and are worked out every time; they're a loop over a few
+//  numbers per event, with no particles in it.
+
+struct flipincremental{
+    // Every per-event result is a flat vector: one entry per event, or
+    //  one per lepton (parton) with the event's leptons from
+    //  leptonStart[iEvent] to leptonStart[iEvent+1]. A stage that's on
+    //  disk with the right key is read back as it is; the events are only
+    //  read if some stage has to be worked out again.
+    // The answer is the same as select_event's on the same events and
+    //  seed (validate=1 checks), because every stage rolls the same dice
+    //  (seed, event, cutstage) for the same objects in the same order.
+    string eventsFile;                      // skim records
+    string cacheDir;
+    string settings;                        // set=, applied by
+                                            //  read_incremental
+    unsigned int seed;                      // dice of the run that skimmed
+    int nEvent;                             // # generated in that run
+    string skimStage;                       // what the skim cut on
+    double mstop, mglu;                     // from the .meta, for output
+    effparams params;
+    signalregion region;
+
+    vector<flipevent> events;               // only if needed
+    bool loaded;
+
+    // incEvents
+    vector<int> iEvent;
+    vector<double> weight, MET, HT;
+    vector<int> leptonStart, partonStart;
+    // per lepton / per parton
+    vector<unsigned char> kinematic, jets, lepID, lepIso;
+    // per event
+    vector<int> nJets, nbJets;
+    vector<int> passed;                     // last cutstage passed, <= ss2l
+    vector<int> leadID;                     // PDG id of leptons[0]
+
+    unsigned int keys[nIncStages];
+    bool recomputed[nIncStages];
+    double stageTime[nIncStages];           // seconds, read or worked out
+    double tailTime;                        // the signal region cuts
+    flipcounts stagecounts;
+};
+
+
+void fill_incremental(flipincremental&);
+    // Defaults: events.dat, cache in replaycache/, SUS-12-017 parameters
+    //  and SR 8, seed 0 (the .meta's, once read_incremental has run)
+
+bool read_incrementaloption(flipincremental&, string);
+    // cache=dir, set=name=value,name=value,... where name is a member of
+    //  effparams (as in vary=) or of signalregion (minJets, minbJets,
+    //  minMET, minHT, plusplus, minusminus). Returns false if it isn't
+    //  one of those
+
+bool read_incremental(flipincremental&, string, int);
+    // Inputs: records file, signal region. Reads file.meta (seed, nEvent,
+    //  masses) and sets up the signal region; set= on top. False if the
+    //  file isn't there
+
+bool run_incremental(flipincremental&);
+    // Every stage from the cache or worked out (and stored), then the
+    //  signal region cuts. False if the events can't be read
+
+bool validate_incremental(flipincremental&, const runoptions&);
+    // select_event on every stored event (options: isoGrid); true if the
+    //  cutflow's the same
+
+void report_incremental(flipincremental&);
+    // Cutflow, efficiency, and what came from where
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPINCREMENTAL_H_INCLUDED__
@@ -0,0 +1,165 @@
+/********************************************************************************
+*   FlipIsoGrid.cpp by Flip Tanedo (pt267@cornell.edu)                          *
+*   Isolation cones on an eta-phi grid:                                         *
+*   - bin_isogrid: a counting sort of the jets into cells, once per event       *
+*   - isogrid_cone: the 3x3 cells around the lepton, phi wrapping around        *
+*   - isolation_cone: the plain loop over every jet, to check against           *
+********************************************************************************/
+
+#include "FlipIsoGrid.h"
+#include <algorithm>                        // sort
+#include <cmath>                            // floor
+
+
+static const double gridEta = 5.0;         // visible particles: |eta| < 5
+static const double twoPi = 6.283185307179586;
+
+
+
+void fill_isogrid(flipisogrid& grid, int from, bool check){
+    // No cells until the first event
+
+    grid.from        = (check && (from > 0)) ? 0 : from;
+    grid.check       = check;
+    grid.etaWidth    = 0;
+    grid.phiWidth    = 0;
+    grid.nEta        = 0;
+    grid.nPhi        = 0;
+    grid.nIsoEvents  = 0;
+    grid.nGridEvents = 0;
+    grid.nChecked    = 0;
+    grid.nDiffer     = 0;
+} // end fill_isogrid
+
+
+
+static int eta_cell(flipisogrid& grid, double eta){
+    int iEta = (int) floor((eta + gridEta) / grid.etaWidth);
+    if (iEta < 0) return 0;
+    if (iEta >= grid.nEta) return grid.nEta - 1;
+    return iEta;
+} // end eta_cell
+
+static int phi_cell(flipisogrid& grid, double phi){
+    // PseudoJet::phi() is in [0, 2 pi)
+    int iPhi = (int) floor(phi / grid.phiWidth);
+    if (iPhi < 0) return 0;
+    if (iPhi >= grid.nPhi) return grid.nPhi - 1;
+    return iPhi;
+} // end phi_cell
+
+
+
+void bin_isogrid(flipisogrid& grid,
+                 vector< pair<int, fastjet::PseudoJet> >& jets, double dR){
+    // Cells only change with the cone size; the vectors are reused
+
+    int nEta = (int) floor(2 * gridEta / dR);
+    int nPhi = (int) floor(twoPi / dR);
+    if (nEta < 1) nEta = 1;
+    if (nPhi < 1) nPhi = 1;
+    if ((nEta != grid.nEta) || (nPhi != grid.nPhi)){
+        grid.nEta = nEta;
+        grid.nPhi = nPhi;
+        grid.etaWidth = 2 * gridEta / nEta;     // >= dR
+        grid.phiWidth = twoPi / nPhi;           // >= dR
+    }
+    int nCells = grid.nEta * grid.nPhi;
+
+    int nJets = jets.size();
+    grid.eta.resize(nJets);
+    grid.phi.resize(nJets);
+    grid.pt.resize(nJets);
+    grid.cell.resize(nJets);
+    grid.members.resize(nJets);
+    grid.cellStart.assign(nCells + 1, 0);
+
+    for (int j = 0; j < nJets; j++){
+        fastjet::PseudoJet& jet = jets[j].second;
+        grid.eta[j] = jet.eta();
+        grid.phi[j] = jet.phi();
+        grid.pt[j]  = jet.pt();
+        grid.cell[j] = eta_cell(grid, grid.eta[j]) * grid.nPhi
+                     + phi_cell(grid, grid.phi[j]);
+        grid.cellStart[grid.cell[j] + 1]++;
+    }
+    for (int c = 0; c < nCells; c++)
+        grid.cellStart[c+1] += grid.cellStart[c];
+
+    // jets in increasing order within each cell
+    grid.matched.assign(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (int j = 0; j < nJets; j++)
+        grid.members[grid.matched[grid.cell[j]]++] = j;
+} // end bin_isogrid
+
+
+
+double isogrid_cone(flipisogrid& grid, double eta, double phi, double dR){
+    // The jets of the 3x3 cells around the lepton's that are in the cone,
+    //  added up in the order of the jet list
+
+    grid.matched.clear();
+    int iEta = eta_cell(grid, eta);
+    int iPhi = phi_cell(grid, phi);
+
+    for (int e = iEta - 1; e <= iEta + 1; e++){
+        if ((e < 0) || (e >= grid.nEta)) continue;
+        // with fewer than 3 phi cells, -1 and +1 would be the same cell
+        int first = (grid.nPhi < 3) ? 0 : iPhi - 1;
+        int last  = (grid.nPhi < 3) ? grid.nPhi - 1 : iPhi + 1;
+        for (int p = first; p <= last; p++){
+            int c = e * grid.nPhi + (p + grid.nPhi) % grid.nPhi;
+            for (int m = grid.cellStart[c]; m < grid.cellStart[c+1]; m++){
+                int j = grid.members[m];
+                if (get_deltaR(eta, phi, grid.eta[j], grid.phi[j]) < dR)
+                    grid.matched.push_back(j);
+            }
+        }
+    }
+
+    sort(grid.matched.begin(), grid.matched.end());
+    double cone_pT = 0;
+    for (unsigned int i = 0; i < grid.matched.size(); i++)
+        cone_pT += grid.pt[grid.matched[i]];
+    return cone_pT;
+} // end isogrid_cone
+
+
+
+double isolation_cone(vector< pair<int, fastjet::PseudoJet> >& jets,
+                      double eta, double phi, double dR){
+    // Every jet
+
+    double cone_pT = 0;
+    for (unsigned int iJet = 0; iJet < jets.size(); iJet++){
+        fastjet::PseudoJet& parton = jets[iJet].second;
+        if (get_deltaR(eta, phi, parton.eta(), parton.phi()) < dR)
+            cone_pT += parton.pt();
+    } // end loop over partons
+    return cone_pT;
+} // end isolation_cone
+
+
+
+void add_isogrid(flipisogrid& total, flipisogrid& part){
+    // Counts only
+
+    total.nIsoEvents  += part.nIsoEvents;
+    total.nGridEvents += part.nGridEvents;
+    total.nChecked    += part.nChecked;
+    total.nDiffer     += part.nDiffer;
+} // end add_isogrid
+
+
+
+void report_isogrid(flipisogrid& grid){
+    // e.g. "Isolation on the eta-phi grid: 1234 of 9876 events"
+
+    if ((grid.nGridEvents == 0) && !grid.check) return;
+    cout << "Isolation on the eta-phi grid: " << grid.nGridEvents << " of "
+         << grid.nIsoEvents << " events" << endl;
+    if (grid.check)
+        cout << "Isolation grid validation: " << grid.nDiffer << " of "
+             << grid.nChecked << " cones differ from the loop over every jet"
+             << endl;
+} // end report_isogrid
@@ -0,0 +1,78 @@
+// FlipIsoGrid.h
+// Lepton isolation against many jets: the jets are put in eta-phi cells
+//  once per event, and each lepton's cone only looks at the cells next to
+//  its own
+// INCLUDE GUARD
+#ifndef __FLIPISOGRID_H_INCLUDED__
+#define __FLIPISOGRID_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+using namespace std;
+
+struct flipisogrid{
+    // Cells at least lepton_dR wide in eta and in phi, so everything in a
+    //  lepton's cone is in its own cell or one of the 8 around it. The
+    //  cells wrap around in phi (the last cell's neighbour is the first);
+    //  eta runs from -5 to 5, with anything further out in the end cells.
+    // The cone is get_deltaR's, unwrapped in phi as it always was, and
+    //  the pT's in it are added up in the order of the jet list, so the
+    //  cone pT comes out the same as the loop over every jet to the last
+    //  bit. The grid only saves looking at the jets that can't be in it.
+    // The jets are state.partons: the partons (or anti-kT jets, hadron=1)
+    //  that passed the jet pT and eta cuts. Even with showers on and
+    //  hadron=0, where every visible hadron goes into prepartons, few of
+    //  them get past the jet pT cut, so it's a handful to a dozen per
+    //  event, and at that size the grid and the loop cost about the same.
+    //  So it's off by default (isogrid=-1); 8 is where to start if it's
+    //  wanted, what the multijet end of the signal reaches, gluino pairs
+    //  with ISR jets at hadron level; a list in the hundreds would need
+    //  the isolation to look at particles instead of jets.
+    // With check (validate=1) every event with leptons goes on the grid,
+    //  whatever from says (unless -1), and every cone is checked against
+    //  the loop.
+    int from;                           // use the grid for events with at
+                                        //  least this many jets; -1: never
+    bool check;                         // also do the plain loop, compare
+    double etaWidth, phiWidth;
+    int nEta, nPhi;
+    vector<int> cellStart;              // jets of cell c: members from
+    vector<int> members;                //  cellStart[c] to cellStart[c+1]
+    vector<int> cell;                   // per jet
+    vector<double> eta, phi, pt;        // per jet
+    vector<int> matched;                // scratch, jets in the cone
+
+    // counts, added up over threads
+    int nIsoEvents;                     // # events isolated, any way
+    int nGridEvents;                    // # of those on the grid
+    int nChecked;                       // # leptons checked (check)
+    int nDiffer;                        // # of those that came out different
+};
+
+
+void fill_isogrid(flipisogrid&, int, bool);
+    // Inputs: grid, from, check. Zeroes the counts; check puts every
+    //  event on the grid (from 0) unless from is -1
+
+void bin_isogrid(flipisogrid&, vector< pair<int, fastjet::PseudoJet> >&,
+                 double);
+    // Inputs: grid, jets, cone size. Puts the jets in their cells
+
+double isogrid_cone(flipisogrid&, double, double, double);
+    // Inputs: grid, lepton eta, lepton phi, cone size
+    // Sum of the pT of the jets within the cone
+
+double isolation_cone(vector< pair<int, fastjet::PseudoJet> >&, double,
+                      double, double);
+    // Inputs: jets, lepton eta, lepton phi, cone size
+    // Same, looking at every jet (the way run_stage always did it)
+
+void add_isogrid(flipisogrid&, flipisogrid&);
+    // Adds the counts of the second to the first
+
+void report_isogrid(flipisogrid&);
+    // How many events used the grid, and how the check went
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPISOGRID_H_INCLUDED__
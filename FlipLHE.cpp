@@ -24,7 +24,7 @@ int getnevents(std::string &lhefile){
            keepgoing = false;
            foundit = true;
         }
-        if (instream.eof())
+        if (!instream.good())           // end of file, or no file at all
             keepgoing = false;
     }
     
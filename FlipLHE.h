@@ -1,8 +1,8 @@
 // FlipCommandFileFixer.h
 // For modifying Pythia Command Files
 // INCLUDE GUARD
-// #ifndef __FLIPLHE_H_INCLUDED__
-// #define __FLIPLHE_H_INCLUDED__
+#ifndef __FLIPLHE_H_INCLUDED__
+#define __FLIPLHE_H_INCLUDED__
 
 #include <string>              
 #include <sstream>              // for string stream
@@ -23,5 +23,5 @@ int getnevents(std::string &lhefile);
 
 
 // END INCLUDE GUARD
-// #endif // __FLIPLHE_H_INCLUDED__
+#endif // __FLIPLHE_H_INCLUDED__
 
@@ -0,0 +1,142 @@
+/********************************************************************************
+*   FlipLibrary.cpp by Flip Tanedo (pt267@cornell.edu)                          *
+*   flip_efficiency: what PartonRPV's main does, as a function that returns     *
+*   the numbers instead of appending them to a file.                            *
+*   - per-call command/spectrum files, so calls can run side by side           *
+*   - the other signal regions ride along on the same events                    *
+********************************************************************************/
+
+#include "FlipLibrary.h"
+#include "FlipCommandFileFixer.h"
+#include <pthread.h>                        // call_lock
+#include <unistd.h>                         // getpid
+#include <cstdio>                           // remove
+
+
+static pthread_mutex_t call_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int nCalls = 0;             // for the file names
+
+
+
+void fill_effpoint(flipeffpoint& point){
+    // Same as running ./PartonRPV with no arguments, but quiet
+
+    point.mstop         = 300;
+    point.mglu          = 800;
+    point.signalRegions.clear();
+    point.signalRegions.push_back(8);
+    point.settings.clear();
+    point.cmndTemplate  = "CmndTemp.cmnd";
+    point.spcTemplate   = "template.spc";
+    point.scratchDir    = "/tmp";
+    point.seed          = 0;
+    fill_runoptions(point.options);
+    point.options.quiet = true;
+} // end fill_effpoint
+
+
+
+flipeffresult flip_efficiency(const flipeffpoint& point,
+                              Pythia8::Pythia* warm){
+    // FixMassPoint into this call's own files, then signal_efficiency_b
+
+    flipeffresult result;
+    result.ok       = false;
+    result.sigmaGen = 0;
+    result.sigmaErr = 0;
+    result.nEvent   = 0;
+    result.seed     = point.seed;
+    result.setupSeconds = 0;
+    result.signalRegions = point.signalRegions;
+
+    vector<signalregion> signal_region;
+    fill_signalregions(signal_region);
+    if (point.signalRegions.empty()){
+        result.error = "no signal regions";
+        return result;
+    }
+    for (unsigned int i = 0; i < point.signalRegions.size(); i++){
+        int iSR = point.signalRegions[i];
+        if ((iSR < 0) || (iSR >= (int) signal_region.size())){
+            stringstream error;
+            error << "there's no signal region " << iSR;
+            result.error = error.str();
+            return result;
+        }
+    }
+
+    // FILES OF ITS OWN
+    // ----------------
+    pthread_mutex_lock(&call_lock);
+    unsigned int iCall = nCalls++;
+    pthread_mutex_unlock(&call_lock);
+
+    stringstream base;
+    base << point.scratchDir << "/flipeff_" << getpid() << "_" << iCall;
+    string cmndtemp = point.cmndTemplate;
+    string spctemp  = point.spcTemplate;
+    string cmndrun  = base.str() + ".cmnd";
+    string spcint   = base.str() + "_intermediate.spc";
+    string spcrun   = base.str() + ".spc";
+
+    stringstream mstop, mglu;
+    mstop << point.mstop;
+    mglu << point.mglu;
+    string stopmass  = mstop.str();
+    string glumass   = mglu.str();
+
+    if (!FixMassPoint(cmndtemp, cmndrun, spctemp, spcint, spcrun,
+                      stopmass, glumass)){
+        result.error = "couldn't write the command and spectrum files";
+        remove(cmndrun.c_str());
+        remove(spcint.c_str());
+        remove(spcrun.c_str());
+        return result;
+    }
+
+    // later lines win, so the settings go at the end
+    ofstream cmndstream(cmndrun.c_str(), ios::app);
+    cmndstream << endl << "! flip_efficiency settings" << endl;
+    for (unsigned int i = 0; i < point.settings.size(); i++)
+        cmndstream << point.settings[i] << endl;
+    cmndstream.close();
+
+    // RUN
+    // ---
+    runoptions options = point.options;
+    options.seed = point.seed;
+    stringstream regions;
+    for (unsigned int i = 1; i < point.signalRegions.size(); i++)
+        regions << (i > 1 ? "," : "") << point.signalRegions[i];
+    options.regions = regions.str();
+
+    vector< pair<string, int> > counts;
+    flipresult run;
+    double efficiency = signal_efficiency_b(cmndrun, counts,
+                                            point.signalRegions[0], 0,
+                                            &options, &run, warm);
+
+    remove(cmndrun.c_str());
+    remove(spcint.c_str());
+    remove(spcrun.c_str());
+
+    // RESULTS
+    // -------
+    // the other signal regions are the last variations
+    result.efficiencies.push_back(efficiency);
+    result.cutflows.push_back(run.stagecounts);
+    int first = run.varied.size() - (point.signalRegions.size() - 1);
+    for (unsigned int i = first; i < run.varied.size(); i++){
+        result.efficiencies.push_back(run.varied[i].weights[cutCharge]
+                                      / double(run.nEvent));
+        result.cutflows.push_back(run.varied[i]);
+    }
+
+    result.sigmaGen = run.sigmaGen;
+    result.sigmaErr = run.sigmaErr;
+    result.nEvent   = run.nEvent;
+    result.seed     = run.seed;
+    result.setupSeconds = run.setupSeconds;
+    result.ok       = true;
+    return result;
+} // end flip_efficiency
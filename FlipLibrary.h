@@ -0,0 +1,73 @@
+// FlipLibrary.h
+// The signal efficiency as a function call, for programs that want lots
+//  of points without running PartonRPV for each one (libflipeff)
+// INCLUDE GUARD
+#ifndef __FLIPLIBRARY_H_INCLUDED__
+#define __FLIPLIBRARY_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+#include "FlipEvent.h"
+using namespace std;
+
+// Usage, e.g. from a fit, any number of threads at once:
+//
+//      flipeffpoint point;
+//      fill_effpoint(point);
+//      point.mstop = 400;
+//      point.mglu  = 900;
+//      point.signalRegions.push_back(8);
+//      point.signalRegions.push_back(6);
+//      point.settings.push_back("Main:numberOfEvents = 2000");
+//      point.seed  = 12345;
+//      flipeffresult result = flip_efficiency(point);
+//      if (result.ok) ... result.efficiencies[0] (SR 8), [1] (SR 6)
+//
+// Each call writes its own command and spectrum files (named after the
+//  process and the call) into scratchDir and deletes them at the end, so
+//  calls don't step on each other or on PartonRPV's CommandRun.cmnd.
+//  Same point, same seed: same result, whatever else is running.
+// Link with libflipeff.a (or .so) and Pythia/FastJet, see the Makefile.
+
+struct flipeffpoint{
+    // One point to run
+    double mstop;
+    double mglu;
+    vector<int> signalRegions;          // the first one is the run's, the
+                                        //  others use the same events and
+                                        //  dice (regions= in FlipEvent.h)
+    vector<string> settings;            // Pythia settings on top of the
+                                        //  command file template
+    string cmndTemplate;                // as PartonRPV's [cmnd]
+    string spcTemplate;                 // as PartonRPV's [spc]
+    string scratchDir;                  // for the per-call files
+    unsigned int seed;                  // dice seed, 0: drawn from rand()
+    runoptions options;                 // batch, force, ... (quiet=1)
+};
+
+struct flipeffresult{
+    // What came out, per signal region in the order asked for
+    bool ok;                            // false: see error, nothing else
+    string error;
+    vector<int> signalRegions;
+    vector<double> efficiencies;        // weighted, per generated event
+    vector<flipcounts> cutflows;
+    double sigmaGen;                    // cross section (mb)
+    double sigmaErr;
+    int nEvent;
+    unsigned int seed;                  // the dice seed that was used
+    double setupSeconds;                // start-up, before the events
+};
+
+
+void fill_effpoint(flipeffpoint&);
+    // Defaults: PartonRPV's (300, 800, SR 8, CmndTemp.cmnd, template.spc),
+    //  scratch files in /tmp, seed 0, default runoptions but quiet
+
+flipeffresult flip_efficiency(const flipeffpoint&, Pythia8::Pythia* = 0);
+    // Runs the point. Safe to call from several threads at once
+    // Optional: a Pythia to reuse (one per thread), see signal_efficiency_b
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPLIBRARY_H_INCLUDED__
@@ -0,0 +1,581 @@
+/********************************************************************************
+*   FlipLimits.cpp by Flip Tanedo (pt267@cornell.edu)                           *
+*   CLs over the scanned (mstop, mglu) plane:                                   *
+*   - background-only toys per signal region: CLb and the median count          *
+*   - signal + background toys per (point, SR), on a pool of threads            *
+*   - the best expected SR per point, the map and the contour                   *
+********************************************************************************/
+
+#include "FlipLimits.h"
+#include <algorithm>                        // sort, max
+#include <cstdlib>                          // atoi, atof, rand
+#include <unistd.h>                         // sysconf, for the # of cores
+
+
+static const double twoPi = 6.283185307179586;
+
+
+
+void fill_limits(fliplimits& limits){
+    // SR numbers as in SUS-12-017, at its luminosity
+
+    limits.efficiencyFile   = "output.dat";
+    limits.regionFile       = "regions.dat";
+    limits.xsecFile         = "";
+    limits.mapFile          = "limits.dat";
+    limits.contourFile      = "limitcontour.dat";
+    limits.lumi             = 10.5;
+    limits.prefactor        = 1.0;
+    limits.CL               = 0.95;
+    limits.nToys            = 10000;
+    limits.nWorkers         = 0;
+    limits.seed             = 0;
+    limits.next             = 0;
+    limits.nJobs            = 0;
+    limits.nThrown          = 0;
+} // end fill_limits
+
+
+
+bool read_limitoption(fliplimits& limits, string argument){
+    // key=value
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    if      (key == "lumi")      limits.lumi      = atof(value.c_str());
+    else if (key == "prefactor") limits.prefactor = atof(value.c_str());
+    else if (key == "cl")        limits.CL        = atof(value.c_str());
+    else if (key == "toys")      limits.nToys     = atoi(value.c_str());
+    else if (key == "workers")   limits.nWorkers  = atoi(value.c_str());
+    else if (key == "seed")      limits.seed = strtoul(value.c_str(), 0, 10);
+    else if (key == "xsec")      limits.xsecFile  = value;
+    else return false;
+
+    if (limits.nToys < 1) limits.nToys = 1;
+    return true;
+} // end read_limitoption
+
+
+
+/********************************************************************************
+*   Inputs                                                                      *
+********************************************************************************/
+
+static bool read_regions(fliplimits& limits){
+    // SR nObserved background error
+
+    ifstream instream(limits.regionFile.c_str());
+    string line;
+    while (getline(instream, line)){
+        if (line.empty() || (line[0] == '#')) continue;
+        stringstream linestream(line);
+        limitregion region;
+        if (!(linestream >> region.iSR >> region.nObserved
+                         >> region.background)) continue;
+        if (!(linestream >> region.bgError)) region.bgError = 0;
+        if ((region.nObserved < 0) || (region.background < 0)) continue;
+        region.nMedian   = 0;
+        region.CLb       = 1;
+        region.CLbMedian = 1;
+        limits.regions.push_back(region);
+    }
+    instream.close();
+    return !limits.regions.empty();
+} // end read_regions
+
+
+
+static void read_xsec(fliplimits& limits){
+    // mglu sigma(pb), in any order
+
+    ifstream instream(limits.xsecFile.c_str());
+    string line;
+    while (getline(instream, line)){
+        if (line.empty() || (line[0] == '#')) continue;
+        stringstream linestream(line);
+        double mglu, sigma;
+        if (!(linestream >> mglu >> sigma) || (sigma <= 0)) continue;
+        limits.xsec.push_back(make_pair(mglu, sigma));
+    }
+    instream.close();
+    sort(limits.xsec.begin(), limits.xsec.end());
+} // end read_xsec
+
+
+
+double limit_xsec(fliplimits& limits, double mglu){
+    // Straight lines in log(sigma) between the table's points
+
+    vector< pair<double, double> >& table = limits.xsec;
+    if (table.empty() || (mglu < table[0].first - 1.0e-6) ||
+        (mglu > table.back().first + 1.0e-6)) return -1;
+
+    for (unsigned int i = 0; i + 1 < table.size(); i++){
+        if (mglu > table[i+1].first) continue;
+        double width = table[i+1].first - table[i].first;
+        if (width <= 0) return table[i].second;
+        double t = (mglu - table[i].first) / width;
+        return exp( (1-t) * log(table[i].second)
+                    + t * log(table[i+1].second) );
+    }
+    return table.back().second;
+} // end limit_xsec
+
+
+
+bool read_limitinputs(fliplimits& limits){
+    // Regions, cross sections, then the points
+
+    if (!read_regions(limits)){
+        cout << endl << "ERROR: no signal regions in " << limits.regionFile
+             << " (lines of: SR nObserved background error)" << endl;
+        return false;
+    }
+    map<int, int> regionIndex;              // SR -> index in regions
+    for (unsigned int r = 0; r < limits.regions.size(); r++)
+        regionIndex[limits.regions[r].iSR] = r;
+    int nRegions = limits.regions.size();
+
+    if (limits.xsecFile != ""){
+        read_xsec(limits);
+        if (limits.xsec.empty()){
+            cout << endl << "ERROR: no cross sections in " << limits.xsecFile
+                 << " (lines of: mglu sigma(pb))" << endl;
+            return false;
+        }
+    }
+
+    // running sums per point: efficiency and # runs per region, sigma
+    map< pair<double, double>, int > pointIndex;
+    vector< vector<double> > effSums;
+    vector< vector<int> > nRuns;
+    vector<double> sigmaSums;
+    vector<int> nSigmas;
+
+    ifstream instream(limits.efficiencyFile.c_str());
+    string line;
+    while (getline(instream, line)){
+
+        if (line.empty() || (line[0] == '#')) continue;
+
+        stringstream linestream(line);
+        double mstop, mglu, eff;
+        int iSR;
+        if (!(linestream >> mstop >> mglu >> iSR >> eff)) continue;
+        if (regionIndex.find(iSR) == regionIndex.end()) continue;
+
+        pair<double, double> masses(mstop, mglu);
+        if (pointIndex.find(masses) == pointIndex.end()){
+            pointIndex[masses] = limits.points.size();
+            limitpoint point;
+            point.mstop = mstop;
+            point.mglu  = mglu;
+            point.sigma = -1;
+            point.efficiency.assign(nRegions, -1);
+            point.CLs.assign(nRegions, -1);
+            point.CLsExpected.assign(nRegions, -1);
+            point.best = -1;
+            point.excluded = false;
+            limits.points.push_back(point);
+            effSums.push_back(vector<double>(nRegions, 0));
+            nRuns.push_back(vector<int>(nRegions, 0));
+            sigmaSums.push_back(0);
+            nSigmas.push_back(0);
+        }
+        int i = pointIndex[masses];
+        int r = regionIndex[iSR];
+        effSums[i][r] += eff;
+        nRuns[i][r]++;
+
+        double sigma;
+        if ((linestream >> sigma) && (sigma > 0)){
+            sigmaSums[i] += sigma;
+            nSigmas[i]++;
+        }
+    }
+    instream.close();
+
+    int nNoSigma = 0;
+    for (unsigned int i = 0; i < limits.points.size(); i++){
+        limitpoint& point = limits.points[i];
+        for (int r = 0; r < nRegions; r++)
+            if (nRuns[i][r] > 0)
+                point.efficiency[r] = effSums[i][r] / nRuns[i][r];
+        if (!limits.xsec.empty())
+            point.sigma = limit_xsec(limits, point.mglu);
+        else if (nSigmas[i] > 0)
+            point.sigma = sigmaSums[i] / nSigmas[i];
+        if (point.sigma < 0) nNoSigma++;
+    }
+
+    if (limits.points.empty()){
+        cout << endl << "ERROR: no points in " << limits.efficiencyFile
+             << " for the signal regions of " << limits.regionFile << endl;
+        return false;
+    }
+    if (nNoSigma > 0)
+        cout << "WARNING: no cross section for " << nNoSigma << " of "
+             << limits.points.size() << " points, they're left out" << endl;
+    return true;
+} // end read_limitinputs
+
+
+
+/********************************************************************************
+*   Toys                                                                        *
+********************************************************************************/
+
+static unsigned int hash_limit(unsigned int x){
+    // 32 bit integer hash (the "lowbias32" mixer), as in FlipEvent.cpp;
+    //  LimitRPV doesn't link Pythia, so it can't use seed_dice itself
+
+    x ^= x >> 16;
+    x  = (x * 0x7feb352dU) & 0xffffffffU;
+    x ^= x >> 15;
+    x  = (x * 0x846ca68bU) & 0xffffffffU;
+    x ^= x >> 16;
+    return x;
+} // end hash_limit
+
+static void seed_limit(limitdice& dice, unsigned int seed, unsigned int index,
+                       unsigned int stream){
+    // Every (seed, index, stream) starts somewhere different
+
+    unsigned int x = hash_limit(stream + 0x9e3779b9U);
+    x = hash_limit((index ^ x) & 0xffffffffU);
+    x = hash_limit((seed + x) & 0xffffffffU);
+    dice.state = x;
+} // end seed_limit
+
+static double roll_limit(limitdice& dice){
+    // Uniform in [0,1)
+
+    dice.state = (dice.state + 0x9e3779b9U) & 0xffffffffU;
+    return hash_limit(dice.state) / 4294967296.0;
+} // end roll_limit
+
+
+
+static void toy_means(fliplimits& limits, limitregion& region, double signal,
+                      unsigned int index, unsigned int stream,
+                      vector<double>& means){
+    // signal + a background drawn from its Gaussian (Box-Muller, drawn
+    //  again if it comes out negative), nToys times; just signal +
+    //  background if there's no error on it
+
+    if (region.bgError <= 0){
+        means.assign(1, signal + region.background);
+        return;
+    }
+
+    limitdice dice;
+    seed_limit(dice, limits.seed, index, stream);
+    means.resize(limits.nToys);
+    for (int iToy = 0; iToy < limits.nToys; iToy++){
+        double background = -1;
+        while (background < 0){
+            double u1 = roll_limit(dice);
+            double u2 = roll_limit(dice);
+            double gauss = sqrt(-2 * log(1 - u1)) * cos(twoPi * u2);
+            background = region.background + region.bgError * gauss;
+        }
+        means[iToy] = signal + background;
+    }
+} // end toy_means
+
+
+
+void toy_cdf(vector<double>& means, int n, vector<double>& cdf){
+    // The Poisson terms in logs, so a large mean doesn't underflow at k = 0:
+    //  log P(k) = log P(k-1) + log(mean) - log(k)
+
+    int nToys = means.size();
+    vector<double> logTerm(nToys);
+    vector<double> logMean(nToys);
+    for (int i = 0; i < nToys; i++){
+        logMean[i] = (means[i] > 0) ? log(means[i]) : 0;
+        logTerm[i] = -means[i];
+    }
+
+    cdf.assign(n + 1, 0);
+    double total = 0;
+    for (int k = 0; k <= n; k++){
+        double logK = (k > 0) ? log((double) k) : 0;
+        for (int i = 0; i < nToys; i++){
+            if (means[i] <= 0){             // everything at k = 0
+                if (k == 0) total += 1;
+                continue;
+            }
+            if (k > 0) logTerm[i] += logMean[i] - logK;
+            total += exp(logTerm[i]);
+        }
+        cdf[k] = min(1.0, total / nToys);
+    }
+} // end toy_cdf
+
+
+
+static void background_job(fliplimits& limits, int r, vector<double>& means,
+                           vector<double>& cdf){
+    // CLb, and the median of the background-only counts: it's below b
+    //  plus a few times its spread
+
+    limitregion& region = limits.regions[r];
+    toy_means(limits, region, 0, r, 0, means);
+
+    double spread = sqrt(region.background + region.bgError * region.bgError);
+    int n = (int) (region.background + 6 * region.bgError + 6 * spread) + 10;
+    n = max(n, region.nObserved);
+    toy_cdf(means, n, cdf);
+
+    region.nMedian = 0;
+    while ((region.nMedian < n) && (cdf[region.nMedian] < 0.5))
+        region.nMedian++;
+    region.CLb       = cdf[region.nObserved];
+    region.CLbMedian = cdf[region.nMedian];
+} // end background_job
+
+
+
+static double CLs_ratio(double CLsb, double CLb){
+    // CLs+b / CLb, 1 (no exclusion) if CLb is 0: then CLs+b is too
+    return (CLb > 0) ? CLsb / CLb : 1.0;
+} // end CLs_ratio
+
+
+
+static void signal_job(fliplimits& limits, int job, vector<double>& means,
+                       vector<double>& cdf){
+    // One (point, SR): the same background draws as background_job (SR
+    //  r's stream 0), with the point's signal on top
+
+    int nRegions = limits.regions.size();
+    int iPoint = job / nRegions;
+    int r = job % nRegions;
+    limitpoint& point = limits.points[iPoint];
+    limitregion& region = limits.regions[r];
+    if ((point.sigma < 0) || (point.efficiency[r] < 0)) return;
+
+    double signal = point.sigma * 1000.0 * limits.lumi
+                  * point.efficiency[r] * limits.prefactor;
+    toy_means(limits, region, signal, r, 0, means);
+    toy_cdf(means, max(region.nObserved, region.nMedian), cdf);
+
+    point.CLs[r]         = CLs_ratio(cdf[region.nObserved], region.CLb);
+    point.CLsExpected[r] = CLs_ratio(cdf[region.nMedian], region.CLbMedian);
+} // end signal_job
+
+
+
+static void* background_thread(void* argument){
+    fliplimits& limits = *(fliplimits*) argument;
+    vector<double> means, cdf;
+    double nThrown = 0;
+
+    while (true){
+        pthread_mutex_lock(&limits.lock);
+        int job = (limits.next < limits.nJobs) ? (int) limits.next++ : -1;
+        pthread_mutex_unlock(&limits.lock);
+        if (job < 0) break;
+        background_job(limits, job, means, cdf);
+        nThrown += means.size();
+    }
+
+    pthread_mutex_lock(&limits.lock);
+    limits.nThrown += nThrown;
+    pthread_mutex_unlock(&limits.lock);
+    return 0;
+} // end background_thread
+
+static void* signal_thread(void* argument){
+    fliplimits& limits = *(fliplimits*) argument;
+    vector<double> means, cdf;
+    double nThrown = 0;
+
+    while (true){
+        pthread_mutex_lock(&limits.lock);
+        int job = (limits.next < limits.nJobs) ? (int) limits.next++ : -1;
+        pthread_mutex_unlock(&limits.lock);
+        if (job < 0) break;
+        means.clear();
+        signal_job(limits, job, means, cdf);
+        nThrown += means.size();
+    }
+
+    pthread_mutex_lock(&limits.lock);
+    limits.nThrown += nThrown;
+    pthread_mutex_unlock(&limits.lock);
+    return 0;
+} // end signal_thread
+
+
+
+static void run_pool(fliplimits& limits, unsigned int nJobs,
+                     void* (*work)(void*)){
+    // This thread is one of the workers, as in run_dataset
+
+    limits.next  = 0;
+    limits.nJobs = nJobs;
+    int nThreads = min(limits.nWorkers, (int) nJobs) - 1;
+    vector<pthread_t> threads(max(nThreads, 0));
+    for (unsigned int i = 0; i < threads.size(); i++)
+        if (pthread_create(&threads[i], 0, work, &limits)){
+            threads.resize(i);          // the rest run on the ones we have
+            break;
+        }
+    work(&limits);
+    for (unsigned int i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], 0);
+} // end run_pool
+
+
+
+double run_limits(fliplimits& limits){
+    // The signal toys need the background ones' median, so two rounds
+
+    if (limits.nWorkers < 1) limits.nWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (limits.nWorkers < 1) limits.nWorkers = 1;
+    if (limits.seed == 0) limits.seed = rand();
+    limits.nThrown = 0;
+
+    pthread_mutex_init(&limits.lock, 0);
+    run_pool(limits, limits.regions.size(), background_thread);
+    for (unsigned int r = 0; r < limits.regions.size(); r++)
+        if (limits.regions[r].CLb <= 0)
+            cout << "WARNING: SR " << limits.regions[r].iSR << ": CLb = 0 "
+                 << "(far fewer events observed than the background), its "
+                 << "CLs is taken as 1" << endl;
+    run_pool(limits, limits.points.size() * limits.regions.size(),
+             signal_thread);
+    pthread_mutex_destroy(&limits.lock);
+
+    // smallest expected CLs, the first region on a tie
+    for (unsigned int i = 0; i < limits.points.size(); i++){
+        limitpoint& point = limits.points[i];
+        point.best = -1;
+        for (unsigned int r = 0; r < limits.regions.size(); r++){
+            if (point.CLsExpected[r] < 0) continue;
+            if ((point.best < 0) ||
+                (point.CLsExpected[r] < point.CLsExpected[point.best]))
+                point.best = r;
+        }
+        point.excluded = (point.best >= 0) &&
+                         (point.CLs[point.best] < 1 - limits.CL);
+    }
+
+    return limits.nThrown;
+} // end run_limits
+
+
+
+/********************************************************************************
+*   Output                                                                      *
+********************************************************************************/
+
+void limit_contour(fliplimits& limits, vector< vector<double> >& segments){
+    // As contour_segments in FlipAdaptiveScan.cpp, on log(CLs/(1-CL)): CLs
+    //  falls roughly exponentially with the signal. The best SR can change
+    //  from one corner to the next, so the line can jump a little there.
+
+    map< pair<double, double>, int > index;
+    vector<double> stops, glus;
+    for (unsigned int i = 0; i < limits.points.size(); i++){
+        limitpoint& point = limits.points[i];
+        if (point.best < 0) continue;
+        index[make_pair(point.mstop, point.mglu)] = i;
+        stops.push_back(point.mstop);
+        glus.push_back(point.mglu);
+    }
+    sort(stops.begin(), stops.end());
+    stops.erase(unique(stops.begin(), stops.end()), stops.end());
+    sort(glus.begin(), glus.end());
+    glus.erase(unique(glus.begin(), glus.end()), glus.end());
+
+    double limit = 1 - limits.CL;
+    double smallest = 1.0e-9;               // CLs can be zero
+
+    for (unsigned int i = 0; i + 1 < stops.size(); i++){
+        for (unsigned int j = 0; j + 1 < glus.size(); j++){
+
+            // corners, going around the cell counterclockwise
+            double x[4] = { stops[i], stops[i+1], stops[i+1], stops[i] };
+            double y[4] = { glus[j],  glus[j],    glus[j+1],  glus[j+1] };
+            double f[4];
+            bool complete = true;
+            for (int k = 0; k < 4; k++){
+                map< pair<double, double>, int >::iterator it =
+                    index.find(make_pair(x[k], y[k]));
+                if (it == index.end()){
+                    complete = false;
+                    break;
+                }
+                limitpoint& point = limits.points[it->second];
+                double CLs = max(point.CLs[point.best], smallest);
+                f[k] = log(CLs / limit);
+            }
+            if (!complete) continue;
+
+            // points where the contour crosses an edge
+            vector<double> crossings;
+            for (int k = 0; k < 4; k++){
+                int l = (k+1) % 4;
+                if ((f[k] > 0) == (f[l] > 0)) continue;
+                double t = f[k] / (f[k] - f[l]);
+                crossings.push_back(x[k] + t*(x[l] - x[k]));
+                crossings.push_back(y[k] + t*(y[l] - y[k]));
+            }
+
+            // two crossings make one segment; a saddle has four, i.e. two
+            for (unsigned int k = 0; k + 3 < crossings.size(); k += 4){
+                vector<double> segment(crossings.begin() + k,
+                                       crossings.begin() + k + 4);
+                segments.push_back(segment);
+            }
+        }
+    }
+} // end limit_contour
+
+
+
+void write_limits(fliplimits& limits, vector< vector<double> >& segments){
+    // One line per point with a result; contour as in AdaptiveRPV
+
+    ofstream mapstream;
+    mapstream.open(limits.mapFile.c_str());
+    mapstream.precision(6);
+    mapstream.setf(ios::fixed);
+    mapstream.setf(ios::showpoint);
+
+    mapstream << "# mstop \t mglu \t SR \t sigma(pb) \t efficiency \t"
+              << " nSignal \t CLs \t CLs(expected) \t excluded" << endl;
+    for (unsigned int i = 0; i < limits.points.size(); i++){
+        limitpoint& point = limits.points[i];
+        if (point.best < 0) continue;
+        int r = point.best;
+        mapstream << point.mstop << "\t" << point.mglu << "\t"
+                  << limits.regions[r].iSR << "\t" << point.sigma << "\t"
+                  << point.efficiency[r] << "\t"
+                  << point.sigma * 1000.0 * limits.lumi
+                     * point.efficiency[r] * limits.prefactor << "\t"
+                  << point.CLs[r] << "\t" << point.CLsExpected[r] << "\t"
+                  << point.excluded << endl;
+    }
+    mapstream.close();
+
+    // one segment per line, blank lines in between so gnuplot
+    //  draws them as separate pieces
+    ofstream contourstream;
+    contourstream.open(limits.contourFile.c_str());
+    contourstream.precision(2);
+    contourstream.setf(ios::fixed);
+    for (unsigned int iSeg = 0; iSeg < segments.size(); iSeg++){
+        contourstream << segments[iSeg][0] << "\t" << segments[iSeg][1] << endl;
+        contourstream << segments[iSeg][2] << "\t" << segments[iSeg][3] << endl;
+        contourstream << endl;
+    }
+    contourstream.close();
+} // end write_limits
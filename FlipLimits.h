@@ -0,0 +1,134 @@
+// FlipLimits.h
+// CLs limits from the stored efficiencies: pseudo-experiments for every
+//  (mass point, signal region) on a pool of threads, the most sensitive
+//  signal region at each point, and the contour of the excluded points
+// INCLUDE GUARD
+#ifndef __FLIPLIMITS_H_INCLUDED__
+#define __FLIPLIMITS_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <sstream>              // for string stream
+#include <iostream>             // for i don't know
+#include <fstream>              // for file in/out
+#include <pthread.h>            // worker threads
+using namespace std;
+
+// Each signal region is a counting experiment: n observed events on top of
+//  a background b +/- db. A point with s expected signal events is
+//  excluded at CL (95%) if
+//
+//      CLs = CLs+b / CLb = P(n <= nObserved | s+b) / P(n <= nObserved | b)
+//
+//  is below 1 - CL. The background error is folded in by drawing b from a
+//  Gaussian (cut off at 0) for every pseudo-experiment. Given that b the
+//  Poisson probability of n <= nObserved is summed rather than drawn: the
+//  same average as drawing n, with less spread, so the toys are only
+//  needed for the background error (with db = 0 there are none).
+// The expected CLs is the same with nObserved replaced by the median of
+//  the background-only toys; the signal region with the smallest expected
+//  CLs is the one a point is judged by, so the choice doesn't depend on
+//  what was observed.
+//
+// Every signal region rolls its own stream of dice (the same
+//  counter-based ones as FlipEvent.h), so the numbers don't depend on the
+//  # of threads or which one got which point: same seed, same limits.
+//  The b-only toys and every point's s+b toys in that region draw the
+//  same backgrounds, so CLs+b <= CLb toy by toy and CLs <= 1. If CLb
+//  comes out 0 (n observed far below b), so does CLs+b, and CLs is 1.
+
+struct limitdice{
+    unsigned int state;
+};
+
+struct limitregion{
+    // One signal region, from the regions file: SR nObserved b db
+    int iSR;
+    int nObserved;
+    double background;              // expected events, all backgrounds
+    double bgError;                 // absolute, 0: known exactly
+
+    // from the background-only toys
+    int nMedian;                    // median # of events
+    double CLb;                     // P(n <= nObserved | b)
+    double CLbMedian;               // P(n <= nMedian | b)
+};
+
+struct limitpoint{
+    double mstop;
+    double mglu;
+    double sigma;                   // pb, < 0 if unknown
+    vector<double> efficiency;      // per region, < 0 if not in the file
+    vector<double> CLs;             // per region, < 0 if not worked out
+    vector<double> CLsExpected;
+    int best;                       // region (index) with the smallest
+                                    //  expected CLs, -1: none
+    bool excluded;
+};
+
+struct fliplimits{
+    // Settings
+    string efficiencyFile;          // mstop mglu SR efficiency [sigma(pb)]
+    string regionFile;              // SR nObserved background error
+    string xsecFile;                // mglu sigma(pb), "" if in the above
+    string mapFile;                 // per point: best SR, CLs, excluded
+    string contourFile;             // segments of the CLs = 1-CL line
+    double lumi;                    // fb^-1
+    double prefactor;               // overall factor on the efficiency
+    double CL;                      // confidence level, 0.95
+    int nToys;                      // per (point, SR) and per SR for b
+    int nWorkers;                   // threads, 0: one per core
+    unsigned int seed;              // 0: draw one from rand()
+
+    // State
+    vector<limitregion> regions;
+    vector<limitpoint> points;
+    vector< pair<double, double> > xsec;    // (mglu, sigma), by mglu
+    unsigned int next;              // next job to hand out ...
+    unsigned int nJobs;             //  ... of these
+    double nThrown;                 // toys, added up over the threads
+    pthread_mutex_t lock;           // next and nThrown
+};
+
+
+void fill_limits(fliplimits&);
+    // Defaults: output.dat, regions.dat, 10.5 fb^-1, 95% CL, 10^4 toys,
+    //  a thread per core
+
+bool read_limitoption(fliplimits&, string);
+    // key=value: lumi=, prefactor=, cl=, toys=, workers=, seed=, xsec=.
+    //  False if it's none of those
+
+bool read_limitinputs(fliplimits&);
+    // Reads the regions, the cross sections and the efficiencies (repeated
+    //  runs of a point are averaged, as in FlipSurrogate.h). A line with a
+    //  5th number, as in adaptive.dat, brings its own cross section. False
+    //  (with a message) if there's nothing to work with
+
+double limit_xsec(fliplimits&, double);
+    // Inputs: limits, mglu. Cross section (pb), interpolated in log(sigma)
+    //  between the table's gluino masses; -1 outside of them
+
+void toy_cdf(vector<double>&, int, vector<double>&);
+    // Inputs: Poisson mean of each toy, n, output. P(k <= j) averaged over
+    //  the toys, for j = 0 ... n
+
+double run_limits(fliplimits&);
+    // The background-only toys of every region, then every (point, SR) on
+    //  nWorkers threads; picks the best SR and decides exclusion
+    // Returns the number of toys thrown (10^9 and more isn't unusual)
+
+void limit_contour(fliplimits&, vector< vector<double> >&);
+    // Marching squares over the cells of the (mstop, mglu) grid of the
+    //  points that have all four corners: each segment is (mstop1, mglu1,
+    //  mstop2, mglu2), interpolated in log(CLs) of the best SR
+
+void write_limits(fliplimits&, vector< vector<double> >&);
+    // The map and the contour files
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPLIMITS_H_INCLUDED__
@@ -0,0 +1,271 @@
+/********************************************************************************
+*   FlipMask.cpp by Flip Tanedo (pt267@cornell.edu)                             *
+*   All the cuts on every event, as bits:                                       *
+*   - event_mask: every stage, none skipped, one bit each                       *
+*   - mask_event: counted in a table by mask (4096 entries)                     *
+*   - mask_cutflow / report_masks: cutflows, N-1 and correlations as sums       *
+*     over the table, with popcounts for "fails how many cuts"                  *
+********************************************************************************/
+
+#include "FlipMask.h"
+#include "FlipSkim.h"                       // read_skim_stage
+#include <algorithm>                        // find
+#include <cmath>                            // sqrt
+#include <iomanip>                          // setw
+
+
+static const int nMaskCuts = nCutStages - cutKinematic;    // 12
+static const unsigned int allCuts = (1U << nMaskCuts) - 1;
+
+static unsigned int stage_bit(int stage){
+    return 1U << (stage - cutKinematic);
+}
+
+
+
+bool read_masks(flipmasks& masks, bool on, string flow){
+    // flow is a comma separated list of cut stages
+
+    masks.on = on || (flow != "");
+    masks.flow.clear();
+    masks.events.clear();
+    masks.weights.clear();
+    masks.nVetoed = 0;
+    masks.weightVetoed = 0;
+    if (!masks.on) return true;
+
+    masks.events.assign(allCuts + 1, 0);
+    masks.weights.assign(allCuts + 1, 0.0);
+
+    bool ok = true;
+    stringstream stages(flow);
+    string stage;
+    while (getline(stages, stage, ',')){
+        if (stage == "") continue;
+        int iStage = read_skim_stage(stage);
+        if (iStage < 0){
+            cout << endl << "ERROR: no cut stage called " << stage
+                 << ", leaving it out of the flow" << endl;
+            ok = false;
+            continue;
+        }
+        if (iStage == cutGenerated) continue;   // always first
+        masks.flow.push_back(iStage);
+    }
+    return ok;
+} // end read_masks
+
+
+
+void clear_masks(flipmasks& masks){
+    // Same flow, no events
+
+    masks.nVetoed = 0;
+    masks.weightVetoed = 0;
+    if (!masks.on) return;
+    masks.events.assign(allCuts + 1, 0);
+    masks.weights.assign(allCuts + 1, 0.0);
+} // end clear_masks
+
+
+
+unsigned int event_mask(flipevent& record, signalregion& region,
+                        const effparams& params, unsigned int seed,
+                        flipstate& state){
+    // run_stage for every stage; the lepton, jet and b lists are filled
+    //  from what the event has, whether or not the count cut before passed
+
+    clear_state(state);
+
+    unsigned int mask = 0;
+    for (int stage = cutKinematic; stage < nCutStages; stage++){
+        bool passes;
+        switch (stage){
+        // the trigger passes anything that isn't two leptons (see
+        //  run_stage), including none
+        case cutDilepTrig:
+            passes = state.leptons.empty() ||
+                     run_stage(stage, record, region, params, seed, state);
+            break;
+        case cutSS2L:
+            passes = (state.leptons.size() > 1) &&
+                     run_stage(stage, record, region, params, seed, state);
+            break;
+        case cutCharge:
+            passes = !state.leptons.empty() &&
+                     run_stage(stage, record, region, params, seed, state);
+            break;
+        default:
+            passes = run_stage(stage, record, region, params, seed, state);
+        }
+        if (passes) mask |= stage_bit(stage);
+    }
+    return mask;
+} // end event_mask
+
+
+
+void mask_event(flipmasks& masks, flipevent& record, signalregion& region,
+                const effparams& params, unsigned int seed,
+                flipstate& state){
+    // One more event in its mask's entry
+
+    if (!masks.on) return;
+    unsigned int mask = event_mask(record, region, params, seed, state);
+    masks.events[mask]++;
+    masks.weights[mask] += record.weight;
+} // end mask_event
+
+
+
+void add_masks(flipmasks& total, flipmasks& part){
+    // Entry by entry
+
+    if (!total.on || !part.on) return;
+    total.nVetoed      += part.nVetoed;
+    total.weightVetoed += part.weightVetoed;
+    for (unsigned int mask = 0; mask <= allCuts; mask++){
+        total.events[mask]  += part.events[mask];
+        total.weights[mask] += part.weights[mask];
+    }
+} // end add_masks
+
+
+
+void mask_cutflow(flipmasks& masks, vector<int>& order, flipcounts& counts){
+    // An event counts at every stage of the order up to its first failure
+
+    clear_counts(counts);
+    if (!masks.on) return;
+
+    // vetoed: generated, and nothing after that
+    counts.events[cutGenerated]  += masks.nVetoed;
+    counts.weights[cutGenerated] += masks.weightVetoed;
+
+    for (unsigned int mask = 0; mask <= allCuts; mask++){
+        if (masks.events[mask] == 0) continue;
+        counts.events[cutGenerated]  += masks.events[mask];
+        counts.weights[cutGenerated] += masks.weights[mask];
+        for (unsigned int i = 0; i < order.size(); i++){
+            if (!(mask & stage_bit(order[i]))) break;
+            counts.events[order[i]]  += masks.events[mask];
+            counts.weights[order[i]] += masks.weights[mask];
+        }
+    }
+} // end mask_cutflow
+
+
+
+void report_masks(flipmasks& masks, flipcounts& nominal, int nEvent){
+    // The numbers are per generated event, like the efficiency
+
+    if (!masks.on) return;
+
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+
+    // the usual order first: same as the nominal cutflow?
+    vector<int> order;
+    for (int stage = cutKinematic; stage < nCutStages; stage++)
+        order.push_back(stage);
+    flipcounts counts;
+    mask_cutflow(masks, order, counts);
+    int nDiff = 0;
+    for (int stage = cutGenerated; stage < nCutStages; stage++)
+        if (counts.events[stage] != nominal.events[stage]) nDiff++;
+    cout << "All cuts on every event: " << nDiff << " stages of the usual "
+         << "cutflow differ from the nominal one" << endl;
+
+    // flow=, then the other cuts in the usual order
+    if (!masks.flow.empty()){
+        order = masks.flow;
+        for (int stage = cutKinematic; stage < nCutStages; stage++)
+            if (find(order.begin(), order.end(), stage) == order.end())
+                order.push_back(stage);
+        mask_cutflow(masks, order, counts);
+        cout << "Cutflow in the order asked for:" << endl;
+        for (unsigned int i = 0; i < order.size(); i++)
+            cout << "  " << setw(10) << left << cutstage_name(order[i])
+                 << right << counts.weights[order[i]] / double(nEvent)
+                 << "\t(" << counts.events[order[i]] << " events)" << endl;
+    }
+
+    // per cut: passing the others, and failing only this one
+    double passWeight[nCutStages];
+    double bothWeight[nCutStages][nCutStages];
+    for (int i = 0; i < nCutStages; i++){
+        passWeight[i] = 0;
+        for (int j = 0; j < nCutStages; j++) bothWeight[i][j] = 0;
+    }
+    double total = 0, passedAll = masks.weights[allCuts];
+    int nFailing[nMaskCuts + 1];
+    double failingWeight[nMaskCuts + 1];
+    for (int k = 0; k <= nMaskCuts; k++){
+        nFailing[k] = 0;
+        failingWeight[k] = 0;
+    }
+    for (unsigned int mask = 0; mask <= allCuts; mask++){
+        if (masks.events[mask] == 0) continue;
+        double weight = masks.weights[mask];
+        total += weight;
+        int k = __builtin_popcount(~mask & allCuts);
+        nFailing[k] += masks.events[mask];
+        failingWeight[k] += weight;
+        for (int i = cutKinematic; i < nCutStages; i++){
+            if (!(mask & stage_bit(i))) continue;
+            passWeight[i] += weight;
+            for (int j = cutKinematic; j < nCutStages; j++)
+                if (mask & stage_bit(j)) bothWeight[i][j] += weight;
+        }
+    }
+
+    cout << "N-1 (all the other cuts passed), and failing this cut only:"
+         << endl;
+    for (int stage = cutKinematic; stage < nCutStages; stage++){
+        unsigned int others = allCuts & ~stage_bit(stage);
+        double nMinus1 = masks.weights[others] + passedAll;
+        cout << "  " << setw(10) << left << cutstage_name(stage) << right
+             << nMinus1 / double(nEvent) << "\t"
+             << masks.weights[others] / double(nEvent) << "\t("
+             << masks.events[others] << " events)";
+        if (nMinus1 > 0)
+            cout << "\tkeeps " << 100 * passedAll / nMinus1 << "%";
+        cout << endl;
+    }
+
+    cout << "Cuts failed per event:" << endl;
+    if (masks.nVetoed > 0)
+        cout << "  vetoed at process level:  "
+             << masks.weightVetoed / double(nEvent) << "\t(" << masks.nVetoed
+             << " events)" << endl;
+    for (int k = 0; k <= nMaskCuts; k++)
+        if (nFailing[k] > 0)
+            cout << "  " << setw(2) << k << ":  "
+                 << failingWeight[k] / double(nEvent) << "\t(" << nFailing[k]
+                 << " events)" << endl;
+
+    // correlation of passing i with passing j, over the events
+    cout << "Correlations of the cuts (- where a cut passes or fails "
+         << "every event):" << endl << setw(12) << "";
+    for (int j = cutKinematic; j < nCutStages; j++)
+        cout << setw(6) << cutstage_name(j).substr(0, 5);
+    cout << endl << fixed << setprecision(2);
+    for (int i = cutKinematic; i < nCutStages; i++){
+        cout << "  " << setw(10) << left << cutstage_name(i) << right;
+        for (int j = cutKinematic; j < nCutStages; j++){
+            double spread = passWeight[i] * (total - passWeight[i])
+                          * passWeight[j] * (total - passWeight[j]);
+            if (spread <= 0){
+                cout << setw(6) << "-";
+                continue;
+            }
+            cout << setw(6) << (total * bothWeight[i][j]
+                                - passWeight[i] * passWeight[j])
+                               / sqrt(spread);
+        }
+        cout << endl;
+    }
+
+    cout.flags(flags);
+    cout.precision(precision);
+} // end report_masks
@@ -0,0 +1,69 @@
+// FlipMask.h
+// Every cut on every event, without stopping at the first one that fails:
+//  one bit per cut, and from the bits the cutflow in any order, the N-1
+//  efficiencies and how the cuts go together
+// INCLUDE GUARD
+#ifndef __FLIPMASK_H_INCLUDED__
+#define __FLIPMASK_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+struct flipmasks{
+    // Bit (stage - cutKinematic) is set if the event passes that cut
+    //  (cutKinematic ... cutCharge: 12 bits). The object lists are worked
+    //  out whatever happened before, so an event that failed the b tag
+    //  still gets its jets and MET looked at. Where select_event would have
+    //  got that far the lists, the dice and so the bits are the same as
+    //  its; the cutflow in the usual order comes out the same.
+    // There's nothing to keep per event: two events with the same bits
+    //  look the same to every question below, so the masks are counted in
+    //  a table of 4096 (# events, weight) entries. Cutflows, N-1 and
+    //  correlations are sums over the table, whatever the # of events;
+    //  the tables of different threads just add.
+    bool on;
+    vector<int> flow;                   // a cutflow in this order, if any
+    vector<int> events;                 // per mask: # events
+    vector<double> weights;             // per mask: their weight
+    int nVetoed;                        // vetoed at process level (veto=1):
+    double weightVetoed;                //  generated, in no mask
+};
+
+
+bool read_masks(flipmasks&, bool, string);
+    // Inputs: masks, on, order of a cutflow to show, e.g. met,ht,jets
+    //  (the other cuts follow in the usual order; implies on). Returns
+    //  false (and leaves it out) for a stage it doesn't know
+
+void clear_masks(flipmasks&);
+    // Zeroes the table
+
+unsigned int event_mask(flipevent&, signalregion&, const effparams&,
+                        unsigned int, flipstate&);
+    // Inputs: event, signal region, parameters, run seed, scratch lists
+    // Every cut, whatever the ones before it did. ss2l and charge fail
+    //  without the leptons they look at; the trigger passes anything but
+    //  two leptons, as it does in run_stage
+
+void mask_event(flipmasks&, flipevent&, signalregion&, const effparams&,
+                unsigned int, flipstate&);
+    // Same, counted in the table (nothing at all if masks aren't on)
+
+void add_masks(flipmasks&, flipmasks&);
+    // Adds the table of the second to the first
+
+void mask_cutflow(flipmasks&, vector<int>&, flipcounts&);
+    // Inputs: masks, cut stages in order, cutflow to fill
+    // The cutflow with the cuts in that order (generated: every event in
+    //  the table, and the vetoed ones)
+
+void report_masks(flipmasks&, flipcounts&, int);
+    // Inputs: masks, the nominal cutflow, nEvent
+    // Checks the usual cutflow against the nominal one, then prints the
+    //  flow=, N-1 efficiencies, the events failing only that cut, how
+    //  many cuts the events fail, and the correlations of the cuts
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPMASK_H_INCLUDED__
@@ -0,0 +1,688 @@
+/********************************************************************************
+*   FlipOptimize.cpp by Flip Tanedo (pt267@cornell.edu)                         *
+*   Signal regions designed for the RPV model:                                  *
+*   - the skimmed events, cut down to what the SR cuts look at, once            *
+*   - the yields of every candidate on a pool of threads                        *
+*   - the dominated candidates dropped, the frontier ranked                     *
+********************************************************************************/
+
+#include "FlipOptimize.h"
+#include <algorithm>                        // sort, min, max
+#include <cstdlib>                          // atoi, atof
+#include <unistd.h>                         // sysconf, for the # of cores
+
+
+
+void fill_optimize(flipoptimize& opt){
+    // The cut values the turn-on curves know, SUS-12-017's luminosity
+
+    opt.manifest        = "optimize.samples";
+    opt.outFile         = "optimize.dat";
+    opt.jets.clear();
+    for (int j = 2; j <= 8; j++) opt.jets.push_back(j);
+    opt.bjets.clear();
+    for (int b = 2; b <= 4; b++) opt.bjets.push_back(b);
+    double met[4] = {0, 30, 50, 120};
+    opt.met.assign(met, met + 4);
+    double ht[3] = {80, 200, 320};
+    opt.ht.assign(ht, ht + 3);
+    opt.charges.clear();
+    opt.charges.push_back(3);
+    opt.charges.push_back(1);
+    opt.charges.push_back(2);
+    opt.lumi            = 10.5;
+    opt.bgError         = 0.3;
+    opt.minBackground   = 0.5;
+    opt.metric          = "asimov";
+    opt.nWorkers        = 0;
+    opt.nTop            = 20;
+    runoptions options;
+    fill_runoptions(options);
+    opt.isoGrid         = options.isoGrid;
+    fill_effparams(opt.params);
+    opt.nSignal         = 0;
+    opt.nFrontier       = 0;
+    opt.nLowBackground  = 0;
+    opt.next            = 0;
+    opt.nJobs           = 0;
+    opt.nSkipped        = 0;
+    opt.nLooked         = 0;
+} // end fill_optimize
+
+
+
+static bool read_values(vector<double>& values, string text){
+    // 2,4,6 or 2:8 (every integer from 2 to 8)
+
+    values.clear();
+    size_t colon = text.find(':');
+    if (colon != string::npos){
+        int first = atoi(text.substr(0, colon).c_str());
+        int last  = atoi(text.substr(colon + 1).c_str());
+        for (int i = first; i <= last; i++) values.push_back(i);
+        return !values.empty();
+    }
+    stringstream list(text);
+    string value;
+    while (getline(list, value, ','))
+        if (value != "") values.push_back(atof(value.c_str()));
+    return !values.empty();
+} // end read_values
+
+
+
+bool read_optimizeoption(flipoptimize& opt, string argument){
+    // key=value
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    vector<double> values;
+    if ((key == "jets") || (key == "bjets")){
+        read_values(values, value);
+        vector<int>& cuts = (key == "jets") ? opt.jets : opt.bjets;
+        cuts.clear();
+        for (unsigned int i = 0; i < values.size(); i++)
+            cuts.push_back((int) values[i]);
+    }
+    else if (key == "met")      read_values(opt.met, value);
+    else if (key == "ht")       read_values(opt.ht, value);
+    else if (key == "charge"){
+        opt.charges.clear();
+        stringstream list(value);
+        string charge;
+        while (getline(list, charge, ',')){
+            if      (charge == "both")  opt.charges.push_back(3);
+            else if (charge == "plus")  opt.charges.push_back(1);
+            else if (charge == "minus") opt.charges.push_back(2);
+        }
+    }
+    else if (key == "lumi")     opt.lumi          = atof(value.c_str());
+    else if (key == "bgerror")  opt.bgError       = atof(value.c_str());
+    else if (key == "minbg")    opt.minBackground = atof(value.c_str());
+    else if (key == "metric")   opt.metric        = value;
+    else if (key == "workers")  opt.nWorkers      = atoi(value.c_str());
+    else if (key == "top")      opt.nTop          = atoi(value.c_str());
+    else if (key == "isogrid")  opt.isoGrid       = atoi(value.c_str());
+    else return false;
+
+    return true;
+} // end read_optimizeoption
+
+
+
+/********************************************************************************
+*   Inputs                                                                      *
+********************************************************************************/
+
+static bool read_meta(optsample& sample){
+    // key value, see write_skim_meta
+
+    string metafile = sample.file + ".meta";
+    ifstream meta(metafile.c_str());
+    if (!meta.is_open()){
+        cout << endl << "ERROR: no " << metafile << ", it has the seed and "
+             << "the # of events generated" << endl;
+        return false;
+    }
+
+    string line, format = "", stage = "";
+    double sigmaGen = 0;
+    sample.nEvent = 0;
+    while (getline(meta, line)){
+        stringstream words(line);
+        string key, value;
+        words >> key >> value;
+        if      (key == "seed")   sample.seed = strtoul(value.c_str(), 0, 10);
+        else if (key == "nEvent") sample.nEvent = atoi(value.c_str());
+        else if (key == "format") format = value;
+        else if (key == "stage")  stage = value;
+        else if (key == "sigmaGen_mb") sigmaGen = atof(value.c_str());
+    }
+    if (sample.sigma <= 0) sample.sigma = 1e9 * sigmaGen;
+
+    if (format != "records"){
+        cout << endl << "ERROR: " << sample.file << " isn't event records"
+             << endl;
+        return false;
+    }
+    if ((read_skim_stage(stage) < 0) || (read_skim_stage(stage) > cutSS2L)){
+        cout << endl << "ERROR: " << sample.file << " is skimmed at " << stage
+             << ", the signal region cuts need it at ss2l or before" << endl;
+        return false;
+    }
+    if ((sample.nEvent <= 0) || (sample.sigma <= 0)){
+        cout << endl << "ERROR: no # of events or cross section for "
+             << sample.file << endl;
+        return false;
+    }
+    return true;
+} // end read_meta
+
+
+
+static bool read_sample(flipoptimize& opt, optsample& sample){
+    // The cuts up to same-sign with the skim's dice; what's left goes in
+
+    if (!read_meta(sample)) return false;
+
+    ifstream in(sample.file.c_str(), ios::in | ios::binary);
+    char header[8];
+    if (!in.read(header, 8) || (string(header, 8) != "FLIPSKM1")){
+        cout << endl << "ERROR: " << sample.file << " isn't a skim" << endl;
+        return false;
+    }
+
+    vector<signalregion> signal_region;     // none of them cut before SS2L
+    fill_signalregions(signal_region);
+    // The .meta's sigma has the forced decays' open fractions put back
+    //  (unforced_sigma, FlipBias.h): their BRs are in record.weight once
+    double scale = 1000.0 * opt.lumi * sample.sigma / sample.nEvent;
+
+    flipevent record;
+    flipstate state;
+    fill_state(state, opt.isoGrid);
+    sample.nRead = 0;
+    while (read_skim_event(in, record)){
+        sample.nRead++;
+        clear_state(state);
+        bool passed = true;
+        for (int stage = cutKinematic; passed && (stage <= cutSS2L); stage++)
+            passed = run_stage(stage, record, signal_region[0], opt.params,
+                               sample.seed, state);
+        if (!passed) continue;
+
+        double MET = record.METvec.pt();
+        sample.nJets.push_back(state.partons.size());
+        sample.nbJets.push_back(state.bJets.size());
+        sample.minus.push_back(state.leptons[0].first > 0);
+        sample.MET.push_back(MET);
+        sample.HT.push_back(record.HT);
+        sample.weight.push_back(scale * record.weight);
+        for (unsigned int m = 0; m < opt.met.size(); m++)
+            sample.METpass.push_back(METturnon(MET, opt.met[m], opt.params));
+        for (unsigned int h = 0; h < opt.ht.size(); h++)
+            sample.HTpass.push_back(HTturnon(record.HT, opt.ht[h],
+                                             opt.params));
+    }
+    return true;
+} // end read_sample
+
+
+
+bool read_optimizeinputs(flipoptimize& opt){
+    // file signal/background sigma label, one per line
+
+    // the turn-on curves only take these (anything else is an ERROR
+    //  message per event)
+    for (unsigned int m = 0; m < opt.met.size(); m++)
+        if ((opt.met[m] != 0) && (opt.met[m] < 30)){
+            cout << endl << "ERROR: minMET " << opt.met[m] << ", it's 0 or "
+                 << "at least 30" << endl;
+            return false;
+        }
+    for (unsigned int h = 0; h < opt.ht.size(); h++)
+        if ((opt.ht[h] != 0) && (opt.ht[h] != 80) && (opt.ht[h] < 200)){
+            cout << endl << "ERROR: minHT " << opt.ht[h] << ", it's 0, 80 "
+                 << "or at least 200" << endl;
+            return false;
+        }
+    if (opt.jets.empty() || opt.bjets.empty() || opt.met.empty() ||
+        opt.ht.empty() || opt.charges.empty()){
+        cout << endl << "ERROR: nothing to try for one of the cuts" << endl;
+        return false;
+    }
+
+    ifstream manifest(opt.manifest.c_str());
+    if (!manifest.is_open()){
+        cout << endl << "ERROR: can't read " << opt.manifest << endl;
+        return false;
+    }
+
+    int nBackground = 0;
+    opt.nSignal = 0;
+    string line;
+    while (getline(manifest, line)){
+        stringstream words(line);
+        optsample sample;
+        string kind, sigma;
+        if (!(words >> sample.file) || (sample.file[0] == '#')) continue;
+        if (!(words >> kind >> sigma)){
+            cout << endl << "ERROR: " << opt.manifest << ": " << line << endl;
+            return false;
+        }
+        if (!(words >> sample.label)) sample.label = sample.file;
+        sample.signal = (kind == "signal");
+        sample.sigma  = (sigma == "-") ? 0.0 : atof(sigma.c_str());
+        sample.seed   = 0;
+        sample.iSignal = sample.signal ? opt.nSignal++ : -1;
+        if (!sample.signal) nBackground++;
+
+        opt.samples.push_back(sample);
+        if (!read_sample(opt, opt.samples.back())) return false;
+        cout << "  " << sample.label << ": " << opt.samples.back().nRead
+             << " events, " << opt.samples.back().weight.size()
+             << " same-sign" << endl;
+    }
+    if ((opt.nSignal == 0) || (nBackground == 0)){
+        cout << endl << "ERROR: " << opt.manifest << " needs at least one "
+             << "signal and one background" << endl;
+        return false;
+    }
+    return true;
+} // end read_optimizeinputs
+
+
+
+/********************************************************************************
+*   Yields, on a pool of threads                                                *
+********************************************************************************/
+
+static void clear_candidate(flipoptimize& opt, optcandidate& candidate){
+    candidate.signal.assign(opt.nSignal, 0.0);
+    candidate.background = 0;
+    candidate.bgError    = 0;
+    candidate.sumw2      = 0;
+    candidate.metric     = 0;
+    candidate.ranked     = false;
+}
+
+
+
+static void add_event(optcandidate& candidate, optsample& sample,
+                      double yield){
+    if (sample.signal) candidate.signal[sample.iSignal] += yield;
+    else{
+        candidate.background += yield;
+        candidate.sumw2 += yield * yield;
+    }
+}
+
+
+
+static double yield_job(flipoptimize& opt, int job){
+    // One (jets, b jets, charge): all the MET and HT cuts in one go
+
+    int nQ = opt.charges.size();
+    int nB = opt.bjets.size();
+    int nM = opt.met.size();
+    int nH = opt.ht.size();
+    int iQ = job % nQ;
+    int iB = (job / nQ) % nB;
+    int iJ = job / (nQ * nB);
+    int minJets = opt.jets[iJ];
+    int minbJets = opt.bjets[iB];
+    bool plusplus = opt.charges[iQ] & 1;
+    bool minusminus = opt.charges[iQ] & 2;
+    optcandidate* first = &opt.candidates[job * nM * nH];
+
+    double nLooked = 0;
+    for (unsigned int iSample = 0; iSample < opt.samples.size(); iSample++){
+        optsample& sample = opt.samples[iSample];
+        for (unsigned int i = 0; i < sample.weight.size(); i++){
+            if (sample.nJets[i] < minJets) continue;
+            if (sample.nbJets[i] < minbJets) continue;
+            if (sample.minus[i] ? !minusminus : !plusplus) continue;
+            for (int m = 0; m < nM; m++){
+                double yield = sample.weight[i] * sample.METpass[i * nM + m];
+                for (int h = 0; h < nH; h++)
+                    add_event(first[m * nH + h], sample,
+                              yield * sample.HTpass[i * nH + h]);
+            }
+        }
+        nLooked += sample.weight.size() * double(nM * nH);
+    }
+    return nLooked;
+} // end yield_job
+
+
+
+static void reference_yields(flipoptimize& opt, optcandidate& candidate){
+    // One region, cut by cut, for SUS-12-017's own
+
+    signalregion& region = candidate.region;
+    for (unsigned int iSample = 0; iSample < opt.samples.size(); iSample++){
+        optsample& sample = opt.samples[iSample];
+        for (unsigned int i = 0; i < sample.weight.size(); i++){
+            if (sample.nJets[i] < (int) region.minJets) continue;
+            if (sample.nbJets[i] < (int) region.minbJets) continue;
+            if (sample.minus[i] ? !region.minusminus : !region.plusplus)
+                continue;
+            add_event(candidate, sample, sample.weight[i]
+                      * METturnon(sample.MET[i], region.minMET, opt.params)
+                      * HTturnon(sample.HT[i], region.minHT, opt.params));
+        }
+    }
+} // end reference_yields
+
+
+
+static bool all_low(flipoptimize& opt, int job){
+    // Every candidate of the job below minbg
+
+    int nMH = opt.met.size() * opt.ht.size();
+    for (int i = job * nMH; i < (job + 1) * nMH; i++)
+        if (!(opt.candidates[i].background < opt.minBackground)) return false;
+    return true;
+} // end all_low
+
+
+
+static bool hopeless(flipoptimize& opt, int job){
+    // A finished job with the same charge, no more jets and no more b
+    //  jets, all below minbg? Then so is this one: its events are a
+    //  subset, and the weights aren't negative. Under opt.lock
+
+    int nQ = opt.charges.size();
+    int nB = opt.bjets.size();
+    int iQ = job % nQ;
+    int iB = (job / nQ) % nB;
+    int iJ = job / (nQ * nB);
+    for (unsigned int k = iQ; k < opt.nJobs; k += nQ){
+        if ((int) k == job || !opt.jobDone[k] || !opt.jobLow[k]) continue;
+        int kB = (k / nQ) % nB;
+        int kJ = k / (nQ * nB);
+        if ((opt.jets[kJ] <= opt.jets[iJ]) && (opt.bjets[kB] <= opt.bjets[iB]))
+            return true;
+    }
+    return false;
+} // end hopeless
+
+
+
+static void* yield_thread(void* argument){
+    flipoptimize& opt = *(flipoptimize*) argument;
+    double nLooked = 0;
+    while (true){
+        pthread_mutex_lock(&opt.lock);
+        int job = (opt.next < opt.nJobs) ? (int) opt.next++ : -1;
+        bool skip = (job >= 0) && hopeless(opt, job);
+        if (skip){
+            opt.jobDone[job] = true;        // its yields stay 0: below minbg
+            opt.jobLow[job]  = true;
+            opt.nSkipped++;
+        }
+        pthread_mutex_unlock(&opt.lock);
+        if (job < 0) break;
+        if (skip) continue;
+        nLooked += yield_job(opt, job);
+        bool low = all_low(opt, job);
+        pthread_mutex_lock(&opt.lock);
+        opt.jobDone[job] = true;
+        opt.jobLow[job]  = low;
+        pthread_mutex_unlock(&opt.lock);
+    }
+    pthread_mutex_lock(&opt.lock);
+    opt.nLooked += nLooked;
+    pthread_mutex_unlock(&opt.lock);
+    return 0;
+} // end yield_thread
+
+
+
+static void run_pool(flipoptimize& opt, unsigned int nJobs){
+    // This thread is one of the workers, as in run_limits
+
+    opt.next  = 0;
+    opt.nJobs = nJobs;
+    opt.jobDone.assign(nJobs, false);
+    opt.jobLow.assign(nJobs, false);
+    opt.nSkipped = 0;
+    int nThreads = min(opt.nWorkers, (int) nJobs) - 1;
+    vector<pthread_t> threads(max(nThreads, 0));
+    for (unsigned int i = 0; i < threads.size(); i++)
+        if (pthread_create(&threads[i], 0, yield_thread, &opt)){
+            threads.resize(i);          // the rest run on the ones we have
+            break;
+        }
+    yield_thread(&opt);
+    for (unsigned int i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], 0);
+} // end run_pool
+
+
+
+/********************************************************************************
+*   Pruning and ranking                                                         *
+********************************************************************************/
+
+static double sensitivity(const string& metric, double s, double b,
+                          double db){
+    // Goes up with s, down with b and db
+
+    if ((s <= 0) || (b <= 0)) return 0.0;  // no background: nothing to say
+    if (metric == "simple") return s / sqrt(b + db * db);
+
+    double var = db * db;
+    if (var <= 0)
+        return sqrt(2 * ((s + b) * log(1 + s / b) - s));
+    double z2 = 2 * ((s + b) * log((s + b) * (b + var)
+                                   / (b * b + (s + b) * var))
+                     - b * b / var * log(1 + var * s / (b * (b + var))));
+    return (z2 > 0) ? sqrt(z2) : 0.0;
+} // end sensitivity
+
+
+
+static void rate(flipoptimize& opt, optcandidate& candidate){
+    // The weakest signal point decides
+
+    candidate.bgError = sqrt(pow(opt.bgError * candidate.background, 2)
+                             + candidate.sumw2);
+    candidate.metric = -1;
+    for (int k = 0; k < opt.nSignal; k++){
+        double z = sensitivity(opt.metric, candidate.signal[k],
+                               candidate.background, candidate.bgError);
+        if ((candidate.metric < 0) || (z < candidate.metric))
+            candidate.metric = z;
+    }
+} // end rate
+
+
+
+static vector<optcandidate>* sorting;       // for the comparisons below
+
+static bool less_background(int a, int b){
+    // Background, then its error, then more signal first: nothing can be
+    //  dominated by something that comes after it
+
+    optcandidate& A = (*sorting)[a];
+    optcandidate& B = (*sorting)[b];
+    if (A.background != B.background) return A.background < B.background;
+    if (A.sumw2 != B.sumw2) return A.sumw2 < B.sumw2;
+    double sA = 0, sB = 0;
+    for (unsigned int k = 0; k < A.signal.size(); k++){
+        sA += A.signal[k];
+        sB += B.signal[k];
+    }
+    if (sA != sB) return sA > sB;
+    return a < b;
+} // end less_background
+
+static bool better(int a, int b){
+    optcandidate& A = (*sorting)[a];
+    optcandidate& B = (*sorting)[b];
+    if (A.metric != B.metric) return A.metric > B.metric;
+    return a < b;
+} // end better
+
+
+
+static bool dominates(optcandidate& a, optcandidate& b){
+    // a has no more background (by the order) and no more error: every
+    //  signal at least as big too?
+
+    if (a.sumw2 > b.sumw2) return false;
+    for (unsigned int k = 0; k < a.signal.size(); k++)
+        if (a.signal[k] < b.signal[k]) return false;
+    return true;
+} // end dominates
+
+
+
+double run_optimize(flipoptimize& opt){
+    // Yields, then the frontier, then the ranking
+
+    if (opt.nWorkers < 1) opt.nWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (opt.nWorkers < 1) opt.nWorkers = 1;
+
+    // every combination, in the order of the jobs
+    opt.candidates.clear();
+    for (unsigned int iJ = 0; iJ < opt.jets.size(); iJ++)
+    for (unsigned int iB = 0; iB < opt.bjets.size(); iB++)
+    for (unsigned int iQ = 0; iQ < opt.charges.size(); iQ++)
+    for (unsigned int m = 0; m < opt.met.size(); m++)
+    for (unsigned int h = 0; h < opt.ht.size(); h++){
+        optcandidate candidate;
+        clear_candidate(opt, candidate);
+        candidate.region.minJets    = opt.jets[iJ];
+        candidate.region.minbJets   = opt.bjets[iB];
+        candidate.region.minMET     = opt.met[m];
+        candidate.region.minHT      = opt.ht[h];
+        candidate.region.plusplus   = opt.charges[iQ] & 1;
+        candidate.region.minusminus = opt.charges[iQ] & 2;
+        opt.candidates.push_back(candidate);
+    }
+
+    opt.nLooked = 0;
+    pthread_mutex_init(&opt.lock, 0);
+    run_pool(opt, opt.jets.size() * opt.bjets.size() * opt.charges.size());
+    pthread_mutex_destroy(&opt.lock);
+
+    // the frontier: in order of background, each one against the ones
+    //  kept so far
+    vector<int> order;
+    opt.nLowBackground = 0;
+    for (unsigned int i = 0; i < opt.candidates.size(); i++){
+        if (opt.candidates[i].background < opt.minBackground)
+            opt.nLowBackground++;
+        else order.push_back(i);
+    }
+    sorting = &opt.candidates;
+    sort(order.begin(), order.end(), less_background);
+    vector<int> frontier;
+    for (unsigned int i = 0; i < order.size(); i++){
+        optcandidate& candidate = opt.candidates[order[i]];
+        bool dominated = false;
+        for (unsigned int j = 0; !dominated && (j < frontier.size()); j++)
+            dominated = dominates(opt.candidates[frontier[j]], candidate);
+        if (dominated) continue;
+        frontier.push_back(order[i]);
+        candidate.ranked = true;
+        rate(opt, candidate);
+    }
+    opt.nFrontier = frontier.size();
+
+    // best first
+    sort(frontier.begin(), frontier.end(), better);
+    vector<optcandidate> ranked;
+    for (unsigned int i = 0; i < frontier.size(); i++)
+        ranked.push_back(opt.candidates[frontier[i]]);
+    for (unsigned int i = 0; i < opt.candidates.size(); i++)
+        if (!opt.candidates[i].ranked) ranked.push_back(opt.candidates[i]);
+    opt.candidates.swap(ranked);
+
+    // and SUS-12-017's, on the same events
+    vector<signalregion> signal_region;
+    fill_signalregions(signal_region);
+    opt.reference.clear();
+    for (unsigned int r = 0; r < signal_region.size(); r++){
+        optcandidate candidate;
+        clear_candidate(opt, candidate);
+        candidate.region = signal_region[r];
+        reference_yields(opt, candidate);
+        rate(opt, candidate);
+        opt.reference.push_back(candidate);
+    }
+
+    return opt.nLooked;
+} // end run_optimize
+
+
+
+/********************************************************************************
+*   Output                                                                      *
+********************************************************************************/
+
+static string charge_name(signalregion& region){
+    if (region.plusplus && region.minusminus) return "both";
+    if (region.plusplus) return "++";
+    if (region.minusminus) return "--";
+    return "none";
+}
+
+
+
+static void print_candidate(ostream& out, optcandidate& candidate){
+    signalregion& region = candidate.region;
+    out << region.minJets << "\t" << region.minbJets << "\t"
+        << region.minMET << "\t" << region.minHT << "\t"
+        << charge_name(region) << "\t" << candidate.metric << "\t"
+        << candidate.background << "\t" << candidate.bgError;
+    for (unsigned int k = 0; k < candidate.signal.size(); k++)
+        out << "\t" << candidate.signal[k];
+    out << endl;
+}
+
+
+
+static void print_heading(ostream& out, flipoptimize& opt, string first){
+    out << first << "\tjets\tbjets\tMET\tHT\tcharge\t" << opt.metric
+        << "\tbackground\terror";
+    for (unsigned int i = 0; i < opt.samples.size(); i++)
+        if (opt.samples[i].signal) out << "\t" << opt.samples[i].label;
+    out << endl;
+}
+
+
+
+void report_optimize(flipoptimize& opt){
+    // e.g. "756 candidates: 41 on the frontier, 120 with too little
+    //  background"
+
+    cout << endl << opt.candidates.size() << " candidates: " << opt.nFrontier
+         << " on the frontier, " << opt.nLowBackground
+         << " with less than " << opt.minBackground
+         << " background events (" << opt.lumi << " fb^-1)" << endl;
+    if (opt.nSkipped > 0)
+        cout << opt.nSkipped << " of " << opt.nJobs << " (jets, b jets, "
+             << "charge) jobs skipped, a looser one was all below that" 
+             << endl;
+    cout << "WARNING: the regions are chosen on the events their yields "
+         << "come from, so the best ones are biased up; take their yields "
+         << "from independent skims (another seed)" << endl;
+
+    cout.precision(4);
+    print_heading(cout, opt, "rank");
+    for (int i = 0; (i < opt.nTop) && (i < opt.nFrontier); i++){
+        cout << i + 1 << "\t";
+        print_candidate(cout, opt.candidates[i]);
+    }
+    cout << "SUS-12-017's signal regions on the same events:" << endl;
+    print_heading(cout, opt, "SR");
+    for (unsigned int r = 0; r < opt.reference.size(); r++){
+        cout << r << "\t";
+        print_candidate(cout, opt.reference[r]);
+    }
+} // end report_optimize
+
+
+
+void write_optimize(flipoptimize& opt){
+    // The frontier, best first
+
+    ofstream out(opt.outFile.c_str());
+    out.precision(6);
+    out << "# " << opt.manifest << ", " << opt.lumi << " fb^-1, background "
+        << "error " << opt.bgError << " (relative) + MC statistics" << endl;
+    out << "# ";
+    print_heading(out, opt, "rank");
+    for (int i = 0; i < opt.nFrontier; i++){
+        out << i + 1 << "\t";
+        print_candidate(out, opt.candidates[i]);
+    }
+    out.close();
+} // end write_optimize
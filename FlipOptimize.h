@@ -0,0 +1,155 @@
+// FlipOptimize.h
+// Signal regions of our own: every combination of jet, b jet, MET, HT and
+//  charge cuts on a grid, evaluated on skimmed signal and background
+//  events on a pool of threads, the dominated ones dropped, the rest
+//  ranked by a sensitivity
+// INCLUDE GUARD
+#ifndef __FLIPOPTIMIZE_H_INCLUDED__
+#define __FLIPOPTIMIZE_H_INCLUDED__
+
+#include "FlipEvent.h"
+#include "FlipSkim.h"                       // read_skim_event
+#include <pthread.h>                        // worker threads
+using namespace std;
+
+// The inputs are event records skimmed at same-sign or before (skim=ss2l
+//  skimfile=..., FlipSkim.h), listed in a manifest:
+//
+//      # file          signal/background   sigma (pb)  label
+//      s300_800.dat    signal              -           300/800
+//      ttWplus.dat     background          0.1487      ttW+
+//
+//  A cross section of - takes the .meta's. Each file is read once: the
+//  cuts up to same-sign are done with the dice of the run that skimmed
+//  it, and what's left of an event is what the signal region cuts look
+//  at (# jets, # b jets, MET, HT, the sign of the leptons) and its
+//  weight in expected events at the luminosity.
+// The MET and HT cuts are turn-on curves (FlipEfficiency.cpp), so an
+//  event counts with the probability to pass them rather than a roll of
+//  the dice; the curves are only known for minMET 0, 30, 50, 120 and
+//  minHT 80, 200, 320, and a value in between is the band below it.
+//
+// A region is dominated if another one has at least as much of every
+//  signal, no more background and no larger background error: it can't
+//  come out on top with any sensitivity that goes up with the signal and
+//  down with the background. That takes every region's yields, so those
+//  are dropped once all the jobs are done, before the ranking. What can
+//  be dropped earlier is a job whose candidates would all be below
+//  minbg: tightening jets or b jets only takes events away, so once a
+//  looser (jets, b jets) job with the same charge has nothing but those,
+//  the tighter ones aren't run at all. What's left (the frontier) is
+//  ranked by the smallest sensitivity over the signal points:
+//      asimov: the median discovery significance with a background
+//              error (the Asimov formula of Cowan et al., 1007.1727,
+//              with the background uncertainty folded in)
+//      simple: s / sqrt(b + db^2)
+//  with db^2 = (bgError b)^2 + the sum of the squared event weights.
+// The work is split by (jets, b jets, charge): each job goes through the
+//  events once for all the MET and HT cuts, so the # of threads doesn't
+//  change the answer (it can change which jobs are skipped, not what the
+//  skipped ones would have been).
+// The regions are chosen and their yields reported on the same events,
+//  so the best ones are biased up: out of many candidates, the ones the
+//  fluctuations favoured come out on top. Their yields should be taken
+//  from independent skims (another seed) before they're believed.
+
+struct optsample{
+    // One file of the manifest
+    string file;
+    string label;
+    bool signal;
+    double sigma;                       // pb, 0: the .meta's
+    int nEvent;                         // generated, from the .meta
+    unsigned int seed;                  // dice of the run that skimmed
+    int nRead;                          // records in the file
+    int iSignal;                        // which signal, -1: background
+
+    // per event past same-sign
+    vector<int> nJets;
+    vector<int> nbJets;
+    vector<bool> minus;                 // leptons are -- (id > 0)
+    vector<double> MET;
+    vector<double> HT;
+    vector<double> weight;              // expected events
+    vector<double> METpass;             // P(pass), per event per met= ...
+    vector<double> HTpass;              // ... and per ht= value
+};
+
+struct optcandidate{
+    signalregion region;
+    vector<double> signal;              // expected events, per signal
+    double background;
+    double bgError;                     // absolute
+    double sumw2;                       // of the background events
+    double metric;                      // smallest over the signals
+    bool ranked;                        // on the frontier, enough bg
+};
+
+struct flipoptimize{
+    // Settings
+    string manifest;
+    string outFile;                     // the frontier, best first
+    vector<int> jets;                   // minJets to try
+    vector<int> bjets;                  // minbJets
+    vector<double> met;                 // minMET
+    vector<double> ht;                  // minHT
+    vector<int> charges;                // 3: ++ or --, 1: ++, 2: --
+    double lumi;                        // fb^-1
+    double bgError;                     // relative background error
+    double minBackground;               // fewer expected bg events than
+                                        //  this: not ranked
+    string metric;                      // asimov or simple
+    int nWorkers;                       // threads, 0: one per core
+    int nTop;                           // # printed
+    int isoGrid;                        // as runoptions' (FlipIsoGrid.h)
+    effparams params;
+
+    // State
+    vector<optsample> samples;
+    int nSignal;
+    vector<optcandidate> candidates;
+    vector<optcandidate> reference;     // SUS-12-017's, for comparison
+    int nFrontier;                      // not dominated
+    int nLowBackground;                 // dropped for minBackground
+    unsigned int next;                  // next job to hand out ...
+    unsigned int nJobs;                 //  ... of these
+    vector<bool> jobDone;               // per job, run or skipped ...
+    vector<bool> jobLow;                //  ... and all of it below minbg
+    int nSkipped;                       // jobs not run, see above
+    double nLooked;                     // (event, candidate) pairs, added
+                                        //  up over the threads
+    pthread_mutex_t lock;               // next, the jobs and nLooked
+};
+
+
+void fill_optimize(flipoptimize&);
+    // Defaults: optimize.dat out, jets 2-8, b jets 2-4, MET 0 30 50 120,
+    //  HT 80 200 320, all charges, 10.5 fb^-1, 30% background error, at
+    //  least 0.5 background events, asimov, a thread per core, top 20,
+    //  PartonRPV's isogrid
+
+bool read_optimizeoption(flipoptimize&, string);
+    // key=value: jets=2:8 (or 2,4,6), bjets=, met=0,30,50,120, ht=,
+    //  charge=both,plus,minus, lumi=, bgerror=, minbg=, metric=, workers=,
+    //  top=, isogrid=. False if it's none of those
+
+bool read_optimizeinputs(flipoptimize&);
+    // Reads the manifest and every file in it. False (with a message) if
+    //  there's no signal, no background or a file can't be used
+
+double run_optimize(flipoptimize&);
+    // Yields of every candidate on nWorkers threads (but the jobs a looser
+    //  one shows are all below minbg), drops the dominated ones, ranks
+    //  the rest. Returns the # of (event, candidate) pairs looked at
+
+void report_optimize(flipoptimize&);
+    // The best nTop, and SUS-12-017's regions on the same events, with a
+    //  warning that the yields of the best are biased up
+
+void write_optimize(flipoptimize&);
+    // Every ranked candidate, best first
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPOPTIMIZE_H_INCLUDED__
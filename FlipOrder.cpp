@@ -0,0 +1,260 @@
+/********************************************************************************
+*   FlipOrder.cpp by Flip Tanedo (pt267@cornell.edu)                            *
+*   Profile-guided ordering of the cut stages:                                  *
+*   - warm up: run every stage over the first events, get pass bits and cost    *
+*   - pick an order greedily (cheap stages that reject a lot go first)          *
+*   - keep it only if it beats the canonical order on the warm-up events        *
+*   The cutflow is always counted in the canonical order, see FlipOrder.h.      *
+********************************************************************************/
+
+#include "FlipOrder.h"
+
+
+#define STAGEBIT(stage) (1u << (stage))
+
+static const unsigned int stage_needs[nCutStages] = {
+    // Which stages have to have run (and passed) before this one
+    0,                                      // cutGenerated
+    0,                                      // cutKinematic
+    STAGEBIT(cutKinematic),                 // cutLepID: kinematic leptons
+    STAGEBIT(cutLepID),                     // cutLepIso: ID'd leptons
+    0,                                      // cutbTag
+    STAGEBIT(cutLepIso),                    // cutDilepton: isolated leptons
+    STAGEBIT(cutDilepton),                  // cutDilepTrig: the two leptons
+    STAGEBIT(cutDilepton),                  // cutSS2L: the two leptons
+    0,                                      // cutJets
+    STAGEBIT(cutbTag),                      // cutbJets: tagged b's
+    0,                                      // cutMET
+    0,                                      // cutHT
+    STAGEBIT(cutDilepton)                   // cutCharge: the two leptons
+};
+
+
+
+void fill_order(fliporder& order, int nWarmup){
+    // Canonical order until warmed up
+
+    order.nWarmup   = nWarmup;
+    order.decided   = (nWarmup <= 0);
+    order.events.clear();
+    order.states.clear();
+    order.known.clear();
+    order.passed.clear();
+    order.order.clear();
+    for (int stage = cutKinematic; stage < nCutStages; stage++)
+        order.order.push_back(stage);
+    for (int stage = 0; stage < nCutStages; stage++) order.cost[stage] = 0;
+    order.canonicalCost = 0;
+    order.orderedCost   = 0;
+} // end fill_order
+
+
+
+static int count_event(unsigned int known, unsigned int passed,
+                       double weight, flipcounts& stagecounts){
+    // Canonical cutflow from the pass bits: count every stage up to the
+    //  first one that failed. Stages that didn't run come after that.
+    //  Returns the last one passed, as select_event leaves in state.passed
+
+    count_stage(stagecounts, cutGenerated, weight);
+    int last = cutGenerated;
+    for (int stage = cutKinematic; stage < nCutStages; stage++){
+        if (!(known & passed & STAGEBIT(stage))) break;
+        count_stage(stagecounts, stage, weight);
+        last = stage;
+    }
+    return last;
+} // end count_event
+
+
+
+static double simulate_order(fliporder& order, vector<int>& stages){
+    // Seconds per warm-up event if the stages ran in this order, including
+    //  the canonical stages run afterwards to find the first failure
+
+    double total = 0;
+    int nEvents = order.events.size();
+    for (int k = 0; k < nEvents; k++){
+        unsigned int ran = 0;
+        int failed = nCutStages;
+        for (unsigned int i = 0; i < stages.size(); i++){
+            total += order.cost[stages[i]];
+            ran |= STAGEBIT(stages[i]);
+            if (!(order.passed[k] & STAGEBIT(stages[i]))){
+                failed = stages[i];
+                break;
+            }
+        }
+        for (int stage = cutKinematic; stage < failed; stage++){
+            if (ran & STAGEBIT(stage)) continue;
+            total += order.cost[stage];
+            if (!(order.passed[k] & STAGEBIT(stage))) break;
+        }
+    }
+    return (nEvents > 0) ? total / nEvents : 0;
+} // end simulate_order
+
+
+
+static void warm_up(fliporder& order, signalregion& region,
+                    const effparams& params, unsigned int seed,
+                    flipcounts& stagecounts, fliphistos& histos){
+    // Every stage over all warm-up events, one stage at a time, then
+    //  choose the order and count (and histogram) the warm-up events
+
+    int nEvents = order.events.size();
+    order.known.assign(nEvents, 0);
+    order.passed.assign(nEvents, 0);
+    for (int k = 0; k < nEvents; k++) clear_state(order.states[k]);
+
+    // PASS BITS AND COSTS
+    // (canonical order, so what a stage needs has run before it)
+    // ----------------------------------------------------------
+    for (int stage = cutKinematic; stage < nCutStages; stage++){
+        int nCalls = 0;
+        double start = wall_seconds();
+        for (int k = 0; k < nEvents; k++){
+            if ((order.passed[k] & stage_needs[stage]) != stage_needs[stage])
+                continue;
+            nCalls++;
+            order.known[k] |= STAGEBIT(stage);
+            if (run_stage(stage, order.events[k], region, params, seed,
+                          order.states[k]))
+                order.passed[k] |= STAGEBIT(stage);
+        }
+        double elapsed = wall_seconds() - start;
+        order.cost[stage] = (nCalls > 0) ? elapsed / nCalls : 0;
+    }
+
+    for (int k = 0; k < nEvents; k++){
+        order.states[k].passed = count_event(order.known[k], order.passed[k],
+                                             order.events[k].weight,
+                                             stagecounts);
+        fill_histos(histos, order.events[k], region, params, seed,
+                    order.states[k]);
+    }
+
+
+    // GREEDY ORDER
+    // Of the stages whose needs are met, take the one with the lowest
+    //  cost per rejected event, among the events still alive
+    // ----------------------------------------------------------------
+    vector<int> greedy;
+    vector<bool> alive(nEvents, true);
+    unsigned int chosen = 0;
+    while (int(greedy.size()) < nCutStages - 1){
+        int best = -1;
+        double bestScore = 0;
+        for (int stage = cutKinematic; stage < nCutStages; stage++){
+            if (chosen & STAGEBIT(stage)) continue;
+            if ((chosen & stage_needs[stage]) != stage_needs[stage]) continue;
+
+            int nRejected = 0;
+            for (int k = 0; k < nEvents; k++)
+                if (alive[k] && !(order.passed[k] & STAGEBIT(stage)))
+                    nRejected++;
+
+            // never rejects anything: last, in canonical order
+            double score = (nRejected > 0) ? order.cost[stage] / nRejected
+                                           : 1.0e30 + stage;
+            if ((best < 0) || (score < bestScore)){
+                best = stage;
+                bestScore = score;
+            }
+        }
+        greedy.push_back(best);
+        chosen |= STAGEBIT(best);
+        for (int k = 0; k < nEvents; k++)
+            if (!(order.passed[k] & STAGEBIT(best))) alive[k] = false;
+    }
+
+
+    // KEEP WHICHEVER IS CHEAPER
+    // -------------------------
+    vector<int> canonical;
+    for (int stage = cutKinematic; stage < nCutStages; stage++)
+        canonical.push_back(stage);
+    order.canonicalCost = simulate_order(order, canonical);
+    order.orderedCost   = simulate_order(order, greedy);
+    if (order.orderedCost < order.canonicalCost) order.order = greedy;
+    else {
+        order.order = canonical;
+        order.orderedCost = order.canonicalCost;
+    }
+
+    order.decided = true;
+    order.events.clear();
+    order.states.clear();
+} // end warm_up
+
+
+
+void order_event(fliporder& order, flipevent& record, signalregion& region,
+                 const effparams& params, unsigned int seed,
+                 flipstate& state, flipcounts& stagecounts,
+                 fliphistos& histos){
+    // Run the stages in the chosen order until one fails
+
+    if (!order.decided){
+        order.events.push_back(record);
+        order.states.push_back(flipstate());
+        fill_state(order.states.back(), state.isogrid.from);
+        if (int(order.events.size()) >= order.nWarmup)
+            warm_up(order, region, params, seed, stagecounts, histos);
+        return;
+    }
+
+    clear_state(state);
+    unsigned int known = 0;
+    unsigned int passed = 0;
+    int failed = nCutStages;
+    for (unsigned int i = 0; i < order.order.size(); i++){
+        int stage = order.order[i];
+        known |= STAGEBIT(stage);
+        if (!run_stage(stage, record, region, params, seed, state)){
+            failed = stage;
+            break;
+        }
+        passed |= STAGEBIT(stage);
+    }
+
+    // Which canonical stage failed first? Only the ones before 'failed'
+    //  can have, and only if they haven't run yet.
+    for (int stage = cutKinematic; stage < failed; stage++){
+        if (known & STAGEBIT(stage)) continue;
+        known |= STAGEBIT(stage);
+        if (!run_stage(stage, record, region, params, seed, state)) break;
+        passed |= STAGEBIT(stage);
+    }
+
+    // every canonical stage up to the last one passed has run, so the
+    //  lists are the ones select_event would have left
+    state.passed = count_event(known, passed, record.weight, stagecounts);
+    fill_histos(histos, record, region, params, seed, state);
+} // end order_event
+
+
+
+void finish_order(fliporder& order, signalregion& region,
+                  const effparams& params, unsigned int seed,
+                  flipcounts& stagecounts, fliphistos& histos){
+    // Short run: warm up on what there is
+
+    if (!order.decided && !order.events.empty())
+        warm_up(order, region, params, seed, stagecounts, histos);
+} // end finish_order
+
+
+
+void report_order(fliporder& order){
+    // Which order, and what it was worth on the warm-up events
+
+    if (!order.decided || (order.canonicalCost <= 0)) return;
+
+    cout << "Cut order:";
+    for (unsigned int i = 0; i < order.order.size(); i++)
+        cout << " " << order.order[i];
+    cout << endl << "   " << 1.0e6 * order.orderedCost << " vs "
+         << 1.0e6 * order.canonicalCost
+         << " microseconds per event in canonical order" << endl;
+} // end report_order
@@ -0,0 +1,65 @@
+// FlipOrder.h
+// Runs the cut stages in whatever order is cheapest, measured on a warm-up
+//  sample, while still reporting the cutflow in the canonical order
+// INCLUDE GUARD
+#ifndef __FLIPORDER_H_INCLUDED__
+#define __FLIPORDER_H_INCLUDED__
+
+#include "FlipEvent.h"
+#include "FlipHisto.h"
+using namespace std;
+
+struct fliporder{
+    // The cutflow only ever counts "passed every cut up to this one", so
+    //  the order of the cuts doesn't change which events pass in the end,
+    //  only how much work it takes to find out. Some stages need others
+    //  first (isolation needs the ID'd leptons, ...), see stage_needs in
+    //  FlipOrder.cpp; the rest can go in any order.
+    //
+    // Warm-up: the first nWarmup events are stored and then every stage
+    //  is run across all of them, which gives each stage's pass bit per
+    //  event and its average cost. From that a new order is picked; it's
+    //  only used if it's cheaper on the warm-up events than the canonical
+    //  one, counting the extra work below.
+    //
+    // When an event fails a stage that comes later in the canonical order,
+    //  the cutflow needs to know which canonical stage it failed first, so
+    //  the canonical stages before it that haven't run yet are run (in
+    //  canonical order, until one fails). That keeps the counts exactly
+    //  what select_event gives.
+    int nWarmup;                        // # events to measure on
+    bool decided;                       // done warming up
+    vector<flipevent> events;           // warm-up events
+    vector<flipstate> states;           // their object lists
+    vector<unsigned int> known;         // per event: bit s = stage s ran
+    vector<unsigned int> passed;        // per event: bit s = stage s passed
+    double cost[nCutStages];            // seconds per call of each stage
+    vector<int> order;                  // stages in the order they're run
+    double canonicalCost;               // seconds per warm-up event ...
+    double orderedCost;                 // ... canonical and chosen order
+};
+
+
+void fill_order(fliporder&, int);
+    // Input: # warm-up events. Until warmed up, the order is canonical
+
+void order_event(fliporder&, flipevent&, signalregion&, const effparams&,
+                 unsigned int, flipstate&, flipcounts&, fliphistos&);
+    // Inputs: order, event, signal region, parameters, run seed, scratch
+    //  lists, cutflow, histograms
+    // Same counts and histograms as select_event and fill_histos. During
+    //  the warm-up the event is only stored; it's counted once the
+    //  warm-up is done.
+
+void finish_order(fliporder&, signalregion&, const effparams&,
+                  unsigned int, flipcounts&, fliphistos&);
+    // Counts (and histograms) warm-up events still waiting, if the run
+    //  was shorter than the warm-up
+
+void report_order(fliporder&);
+    // Prints the order and the cost per event it was chosen on
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPORDER_H_INCLUDED__
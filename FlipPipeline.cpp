@@ -0,0 +1,279 @@
+/********************************************************************************
+*   FlipPipeline.cpp by Flip Tanedo (pt267@cornell.edu)                         *
+*   Overlaps event generation with the analysis.                                *
+*   - the main thread runs pythia.next() and copies the visible final state     *
+*     straight into a slot of a ring buffer                                     *
+*   - each analysis thread takes records out of its own ring and cuts on them   *
+*   The rings are lock-free: one thread writes tail, the other writes head,     *
+*   with a memory barrier between touching a slot and moving the index.         *
+********************************************************************************/
+
+#include "FlipPipeline.h"
+#include <sched.h>                          // sched_yield
+
+
+void start_analysis(flipanalysis& analysis, signalregion& region,
+                    const effparams& params, unsigned int seed,
+                    const runoptions& options){
+    // Settings in, counts zeroed
+
+    analysis.region     = &region;
+    analysis.params     = params;
+    analysis.seed       = seed;
+    analysis.options    = options;
+    analysis.nMismatch  = 0;
+    fill_state(analysis.state, options.isoGrid, options.validate);
+    clear_counts(analysis.stagecounts);
+    clear_counts(analysis.checkcounts);
+    analysis.decisions.clear();
+    clear_batch(analysis.batch);
+    fill_order(analysis.order, options.reorder);
+    analysis.variations.clear();            // read_variations, if any
+    analysis.thresholds.clear();            // read_thresholds, if any
+    analysis.histos.histos.clear();         // read_histos, if any
+    read_masks(analysis.masks, false, "");  // read_masks, if any
+} // end start_analysis
+
+
+
+void analyse_event(flipanalysis& analysis, flipevent& record){
+    // The body of the event loop, after fill_event
+
+    // SYSTEMATIC VARIATIONS, THRESHOLD SCANS AND ALL-CUT MASKS,
+    //  always one event at a time
+    // ---------------------------------------------------------------------
+    vary_event(analysis.variations, record, *analysis.region, analysis.seed,
+               analysis.state);
+    scan_event(analysis.thresholds, record, *analysis.region, analysis.seed,
+               analysis.state);
+    mask_event(analysis.masks, record, *analysis.region, analysis.params,
+               analysis.seed, analysis.state);
+
+    // ONE EVENT AT A TIME
+    // -------------------
+    if ((analysis.options.batchSize <= 0) && 
+        (analysis.options.reorder > 0)){
+        order_event(analysis.order, record, *analysis.region, analysis.params,
+                    analysis.seed, analysis.state, analysis.stagecounts,
+                    analysis.histos);
+        return;
+    }
+    if (analysis.options.batchSize <= 0){
+        select_event(record, *analysis.region, analysis.params, analysis.seed,
+                     analysis.state, analysis.stagecounts);
+        fill_histos(analysis.histos, record, *analysis.region,
+                    analysis.params, analysis.seed, analysis.state);
+        return;
+    }
+
+    // BATCHES
+    // -------
+    add_to_batch(analysis.batch, record);
+    if (analysis.options.validate)
+        analysis.decisions.push_back(
+            select_event(record, *analysis.region, analysis.params,
+                         analysis.seed, analysis.state, analysis.checkcounts));
+
+    if (analysis.batch.nEvents < analysis.options.batchSize) return;
+    finish_analysis(analysis);
+} // end analyse_event
+
+
+
+void finish_analysis(flipanalysis& analysis){
+    // Cut on the batch as it is
+
+    finish_order(analysis.order, *analysis.region, analysis.params,
+                 analysis.seed, analysis.stagecounts, analysis.histos);
+
+    if (analysis.batch.nEvents == 0) return;
+
+    select_batch(analysis.batch, *analysis.region, analysis.params,
+                 analysis.seed, analysis.stagecounts);
+    fill_batch_histos(analysis.histos, analysis.batch, analysis.params);
+    if (analysis.options.validate)
+        analysis.nMismatch += check_batch(analysis.batch, analysis.decisions);
+    clear_batch(analysis.batch);
+} // end finish_analysis
+
+
+
+void veto_analysis(flipanalysis& analysis, int nVetoed, double weight){
+    // Once, after the workers are merged: there's no record to analyse
+
+    analysis.stagecounts.events[cutGenerated]  += nVetoed;
+    analysis.stagecounts.weights[cutGenerated] += weight;
+    analysis.checkcounts.events[cutGenerated]  += nVetoed;
+    analysis.checkcounts.weights[cutGenerated] += weight;
+    for (unsigned int i = 0; i < analysis.variations.size(); i++){
+        flipcounts& varied = analysis.variations[i].stagecounts;
+        varied.events[cutGenerated]  += nVetoed;
+        varied.weights[cutGenerated] += weight;
+    }
+    for (unsigned int i = 0; i < analysis.thresholds.size(); i++){
+        analysis.thresholds[i].nGenerated      += nVetoed;
+        analysis.thresholds[i].weightGenerated += weight;
+    }
+    analysis.histos.nVetoed      += nVetoed;
+    analysis.histos.weightVetoed += weight;
+    analysis.masks.nVetoed       += nVetoed;
+    analysis.masks.weightVetoed  += weight;
+} // end veto_analysis
+
+
+
+void merge_analysis(flipanalysis& total, flipanalysis& part){
+    // Counts and weights just add
+
+    add_counts(total.stagecounts, part.stagecounts);
+    add_counts(total.checkcounts, part.checkcounts);
+    total.nMismatch += part.nMismatch;
+    add_variations(total.variations, part.variations);
+    add_thresholds(total.thresholds, part.thresholds);
+    add_histos(total.histos, part.histos);
+    add_masks(total.masks, part.masks);
+    add_isogrid(total.state.isogrid, part.state.isogrid);
+    if (!total.order.decided) total.order = part.order;
+} // end merge_analysis
+
+
+
+/********************************************************************************
+*   The ring. Indices only ever go up; the slot is index & mask.                *
+********************************************************************************/
+
+static void start_ring(flipring& ring, int nSlots){
+    // Rounds up to a power of 2 so that the indices can wrap around
+
+    unsigned int size = 2;
+    while (size < (unsigned int) nSlots) size *= 2;
+
+    ring.slots.resize(size);
+    ring.mask = size - 1;
+    ring.head = 0;
+    ring.tail = 0;
+    ring.done = 0;
+} // end start_ring
+
+
+
+static flipevent* ring_read(flipring& ring){
+    // Consumer: the next filled slot, or 0 once the producer is done
+    //  and everything has been read
+
+    while (ring.head == ring.tail){
+        if (ring.done){
+            __sync_synchronize();           // done was set after the last push
+            if (ring.head == ring.tail) return 0;
+            break;
+        }
+        sched_yield();
+    }
+    __sync_synchronize();                   // read the slot after seeing tail
+    return &ring.slots[ring.head & ring.mask];
+} // end ring_read
+
+
+
+static void ring_release(flipring& ring){
+    // Consumer: done with the slot, the producer may refill it
+
+    __sync_synchronize();                   // finish reading before handing back
+    ring.head = ring.head + 1;
+} // end ring_release
+
+
+
+static void* analysis_thread(void* argument){
+    // Analyses events until the producer is done
+
+    flipworker& worker = *(flipworker*) argument;
+
+    flipevent* record;
+    while ((record = ring_read(worker.ring))){
+        analyse_event(worker.analysis, *record);
+        ring_release(worker.ring);
+    }
+    finish_analysis(worker.analysis);
+
+    return 0;
+} // end analysis_thread
+
+
+
+void start_pipeline(flippipeline& pipeline, flipanalysis& analysis){
+    // One ring and one thread per worker
+
+    int nWorkers = analysis.options.pipeline;
+    if (nWorkers < 1) nWorkers = 1;
+
+    pipeline.next = 0;
+    pipeline.workers.clear();
+    for (int iWorker = 0; iWorker < nWorkers; iWorker++){
+        flipworker* worker = new flipworker;
+        start_ring(worker->ring, analysis.options.ringSize);
+        start_analysis(worker->analysis, *analysis.region, analysis.params,
+                       analysis.seed, analysis.options);
+        worker->analysis.variations = analysis.variations;
+        clear_variations(worker->analysis.variations);
+        worker->analysis.thresholds = analysis.thresholds;
+        clear_thresholds(worker->analysis.thresholds);
+        worker->analysis.histos = analysis.histos;
+        clear_histos(worker->analysis.histos);
+        worker->analysis.masks = analysis.masks;
+        clear_masks(worker->analysis.masks);
+        pipeline.workers.push_back(worker);
+    }
+
+    // only start the threads once every worker is set up
+    for (int iWorker = 0; iWorker < nWorkers; iWorker++){
+        flipworker* worker = pipeline.workers[iWorker];
+        if (pthread_create(&worker->thread, 0, analysis_thread, worker)){
+            cout << endl << "ERROR: couldn't start analysis thread" << endl;
+            exit(1);
+        }
+    }
+} // end start_pipeline
+
+
+
+flipevent& pipeline_slot(flippipeline& pipeline){
+    // Producer: wait for room in the next worker's ring
+
+    flipring& ring = pipeline.workers[pipeline.next]->ring;
+    while (ring.tail - ring.head > ring.mask) sched_yield();
+    __sync_synchronize();                   // consumer is done with the slot
+    return ring.slots[ring.tail & ring.mask];
+} // end pipeline_slot
+
+
+
+void pipeline_push(flippipeline& pipeline){
+    // Producer: publish the slot, move on to the next worker
+
+    flipring& ring = pipeline.workers[pipeline.next]->ring;
+    __sync_synchronize();                   // finish writing before publishing
+    ring.tail = ring.tail + 1;
+
+    pipeline.next++;
+    if (pipeline.next == pipeline.workers.size()) pipeline.next = 0;
+} // end pipeline_push
+
+
+
+void stop_pipeline(flippipeline& pipeline, flipanalysis& analysis){
+    // Tell every worker that no more events are coming, collect the counts
+
+    for (unsigned int iWorker = 0; iWorker < pipeline.workers.size(); iWorker++){
+        __sync_synchronize();
+        pipeline.workers[iWorker]->ring.done = 1;
+    }
+
+    for (unsigned int iWorker = 0; iWorker < pipeline.workers.size(); iWorker++){
+        flipworker* worker = pipeline.workers[iWorker];
+        pthread_join(worker->thread, 0);
+        merge_analysis(analysis, worker->analysis);
+        delete worker;
+    }
+    pipeline.workers.clear();
+} // end stop_pipeline
@@ -0,0 +1,109 @@
+// FlipPipeline.h
+// Generation and analysis on different threads: Pythia fills event
+//  records into a ring of preallocated slots, analysis threads cut on them
+// INCLUDE GUARD
+#ifndef __FLIPPIPELINE_H_INCLUDED__
+#define __FLIPPIPELINE_H_INCLUDED__
+
+#include "FlipBatch.h"
+#include "FlipOrder.h"
+#include "FlipVariation.h"
+#include "FlipThreshold.h"
+#include "FlipHisto.h"
+#include "FlipMask.h"
+#include <pthread.h>                        // analysis threads
+using namespace std;
+
+struct flipanalysis{
+    // Everything the analysis side needs: what to cut on, how, and the
+    //  running counts. The serial loop keeps one of these, the pipeline
+    //  keeps one per analysis thread and adds them up at the end.
+    signalregion* region;
+    effparams params;
+    unsigned int seed;                      // run seed for the dice
+    runoptions options;
+    flipcounts stagecounts;                 // cutflow
+    flipcounts checkcounts;                 // same, per-event path (validate)
+    int nMismatch;                          // # events batch != per-event
+    flipstate state;                        // scratch for select_event
+    flipbatch batch;                        // events waiting for select_batch
+    vector<bool> decisions;                 // per-event results (validate)
+    fliporder order;                        // cut order, if reordering
+    vector<flipvariation> variations;       // shifted parameters, if any
+    vector<flipthreshold> thresholds;       // threshold scans, if any
+    fliphistos histos;                      // distributions, if any
+    flipmasks masks;                        // every cut, if asked for
+};
+
+struct flipring{
+    // Single producer, single consumer ring of event records.
+    // The slots are allocated once; fill_event clears and refills the
+    //  vectors in place, so once they've grown to the size of a typical
+    //  event nothing gets allocated any more.
+    // tail is only written by the producer, head only by the consumer.
+    vector<flipevent> slots;
+    unsigned int mask;                      // # slots - 1 (power of 2)
+    volatile unsigned int head;             // next slot to analyse
+    volatile unsigned int tail;             // next slot to fill
+    volatile int done;                      // producer has finished
+};
+
+struct flipworker{
+    // One analysis thread and the ring that feeds it
+    flipring ring;
+    flipanalysis analysis;
+    pthread_t thread;
+};
+
+struct flippipeline{
+    // Events are dealt round robin to the workers. Which worker gets an
+    //  event doesn't matter: the dice belong to the event (FlipEvent.h).
+    vector<flipworker*> workers;
+    unsigned int next;                      // worker for the next event
+};
+
+
+void start_analysis(flipanalysis&, signalregion&, const effparams&,
+                    unsigned int, const runoptions&);
+    // Inputs: analysis, signal region, parameters, run seed, options
+    // Zeroes the counts. No variations, threshold scans, histograms or
+    //  masks: read them into analysis.variations, .thresholds, .histos
+    //  and .masks afterwards (before start_pipeline)
+
+void analyse_event(flipanalysis&, flipevent&);
+    // Cuts on one event, either right away (in the canonical or the
+    //  measured order) or when its batch is full. The variations,
+    //  threshold scans and masks always see it right away
+
+void finish_analysis(flipanalysis&);
+    // Cuts on whatever is left in the last batch (or warm-up)
+
+void veto_analysis(flipanalysis&, int, double);
+    // Inputs: analysis, # events vetoed at process level, their weight
+    // Counts them as generated (and failed) in the cutflow, the batch
+    //  check, the variations, threshold scans, histograms and masks, so
+    //  every generated-stage count is the same
+
+void merge_analysis(flipanalysis&, flipanalysis&);
+    // Adds the counts of the second analysis to the first (and takes its
+    //  cut order, if the first doesn't have one)
+
+
+void start_pipeline(flippipeline&, flipanalysis&);
+    // Starts options.pipeline analysis threads, each with a ring of
+    //  options.ringSize slots and a copy of the analysis settings
+
+flipevent& pipeline_slot(flippipeline&);
+    // The slot to fill with the next event. Waits while the next
+    //  worker's ring is full (backpressure on the generator).
+
+void pipeline_push(flippipeline&);
+    // Hands the filled slot to its worker
+
+void stop_pipeline(flippipeline&, flipanalysis&);
+    // Waits for the workers to finish and adds their counts to the analysis
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPPIPELINE_H_INCLUDED__
@@ -0,0 +1,334 @@
+/********************************************************************************
+*   FlipProduction.cpp by Flip Tanedo (pt267@cornell.edu)                       *
+*   Gluino pair production shared by the stop masses of a scan:                 *
+*   - the key: command file, seed, and spectrum without the stop mass           *
+*   - making the file: the hard process only, gluinos left undecayed            *
+*   - using it: the run reads the gluinos back as LHE input                     *
+********************************************************************************/
+
+#include "FlipProduction.h"
+#include "FlipSkim.h"                       // write_lhe_event
+#include <sys/stat.h>                       // mkdir
+#include <sys/file.h>                       // flock
+#include <fcntl.h>                          // open
+#include <unistd.h>                         // getpid, close
+#include <cstdio>                           // rename
+#include <cctype>                           // tolower
+
+
+static string read_file(string filename){
+    // The whole file, "" if it isn't there
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+} // end read_file
+
+
+
+static string spectrum_file(string commandText){
+    // The value of the SLHA:file line (the last one wins, as in Pythia)
+
+    string spectrum = "";
+    stringstream lines(commandText);
+    string line;
+    while (getline(lines, line)){
+        if (line.find("SLHA:file") != 0) continue;
+        size_t equals = line.find('=');
+        if (equals == string::npos) continue;
+        stringstream value(line.substr(equals + 1));
+        value >> spectrum;                  // up to any ! comment
+    }
+    return spectrum;
+} // end spectrum_file
+
+
+
+static string setting_name(string line){
+    // "Random:Seed = 5" -> "random:seed", "" for a comment or blank line
+
+    string name = line.substr(0, line.find('='));
+    stringstream words(name);
+    name = "";
+    words >> name;
+    for (unsigned int i = 0; i < name.size(); i++)
+        name[i] = tolower(name[i]);
+    return name;
+} // end setting_name
+
+
+
+static string production_seed(string commandText, const runoptions& options){
+    // What make_production seeds Pythia with: seed= if it's given, else
+    //  the command file's own Random: lines (the last one wins)
+
+    stringstream seed;
+    if (options.seed != 0){
+        seed << "seed " << options.seed;
+        return seed.str();
+    }
+    string setSeed = "off";
+    string randomSeed = "-1";
+    stringstream lines(commandText);
+    string line;
+    while (getline(lines, line)){
+        string name = setting_name(line);
+        if ((name != "random:setseed") && (name != "random:seed")) continue;
+        stringstream value(line.substr(line.find('=') + 1));
+        value >> (name == "random:setseed" ? setSeed : randomSeed);
+    }
+    seed << "Random:setSeed " << setSeed << ", Random:seed " << randomSeed;
+    return seed.str();
+} // end production_seed
+
+
+
+static string production_key(string commandText, string spectrumText,
+                             string seed){
+    // The command file without SLHA:file and Random: (the spectrum is
+    //  here by its contents, not by its name, and the seed once, as the
+    //  production has it), the spectrum without the stop's line of
+    //  BLOCK MASS. Runs that write their files to new names and set a
+    //  seed of their own, as flip_efficiency and ServeRPV do, get the
+    //  same key when they make the same production
+
+    stringstream key;
+    stringstream commands(commandText);
+    string command;
+    while (getline(commands, command)){
+        string name = setting_name(command);
+        if ((name == "slha:file") || (name.find("random:") == 0)) continue;
+        key << command << "\n";
+    }
+    key << "! production seed: " << seed << "\n";
+    key << "! spectrum, without the stop mass\n";
+
+    bool massBlock = false;
+    stringstream lines(spectrumText);
+    string line;
+    while (getline(lines, line)){
+        stringstream words(line);
+        string first;
+        words >> first;
+        if ((first == "BLOCK") || (first == "Block") || (first == "DECAY")){
+            string name;
+            words >> name;
+            massBlock = (first != "DECAY") &&
+                        ((name == "MASS") || (name == "mass"));
+        }
+        else if (massBlock && (first == "1000006")) continue;
+        key << line << "\n";
+    }
+    return key.str();
+} // end production_key
+
+
+
+static bool read_production(flipproduction& production){
+    // filename.meta: only if its key is this key, word for word
+
+    ifstream meta((production.filename + ".meta").c_str());
+    if (!meta.is_open()) return false;
+
+    string word;
+    unsigned int hash = 0;
+    meta >> word >> hex >> hash >> dec;
+    if (!meta || (hash != hash_string(production.key))) return false;
+    meta >> word >> production.nEvent >> word >> production.sigma
+         >> word >> production.sigmaErr;
+    if (!meta) return false;
+
+    // ... and the key itself, after the numbers
+    string line;
+    getline(meta, line);
+    stringstream key;
+    key << meta.rdbuf();
+    return (key.str() == production.key) && (production.nEvent > 0);
+} // end read_production
+
+
+
+static bool make_production(flipproduction& production, string command_file,
+                            const runoptions& options){
+    // The command file as it is, with everything after the hard process
+    //  switched off: the gluinos stay in the record undecayed. Written to
+    //  temporary names and renamed, so an interrupted run never leaves
+    //  half a file behind
+
+    double startTime = wall_seconds();
+
+    Pythia8::Pythia maker;
+    maker.readFile(command_file);
+    maker.readString("ProcessLevel:resonanceDecays = off");
+    maker.readString("PartonLevel:all = off");
+    maker.readString("HadronLevel:all = off");
+    if (options.seed != 0){
+        stringstream seed;
+        seed << "Random:seed = "
+             << 1 + hash_string(production.key, options.seed) % 900000000u;
+        maker.readString("Random:setSeed = on");
+        maker.readString(seed.str());
+    }
+    if (options.quiet) maker.readString("Print:quiet = on");
+    if (!maker.init()) return false;
+
+    int nEvent = maker.mode("Main:numberOfEvents");
+    int nAbort = maker.mode("Main:timesAllowErrors");
+
+    stringstream pid;                       // if the lock couldn't be had
+    pid << "." << getpid() << ".tmp";
+    string temporary = production.filename + pid.str();
+    ofstream out(temporary.c_str(), ios::out | ios::binary);
+    if (!out.is_open()) return false;
+
+    // <init> needs the cross section, which is only known at the end, so
+    //  the events go to the file first and the header after
+    string events;
+    int code = 0;
+    int nMade = 0;
+    int iAbort = 0;
+    for (int iEvent = 0; iEvent < nEvent; iEvent++){
+        if (!maker.next()){
+            if (++iAbort < nAbort) continue;
+            cout << " Gluino pair production aborted prematurely, owing to "
+                 << "error!" << endl;
+            break;
+        }
+        if (nMade == 0) code = maker.info.code();
+        write_lhe_event(events, maker.process, maker.info, 1.0);
+        nMade++;
+        if (events.size() > (1 << 20)){
+            out.write(events.data(), events.size());
+            events.clear();
+        }
+    }
+    out.write(events.data(), events.size());
+    out << "</LesHouchesEvents>\n";
+    out.close();
+    if (nMade == 0){
+        remove(temporary.c_str());
+        return false;
+    }
+
+    production.nEvent   = nMade;
+    production.sigma    = 1e9 * maker.info.sigmaGen();
+    production.sigmaErr = 1e9 * maker.info.sigmaErr();
+
+    // strategy 3: unweighted events, the cross section is XSECUP's
+    stringstream header;
+    header << setprecision(10) << scientific;
+    header << "<LesHouchesEvents version=\"1.0\">\n"
+           << "<!--\n  Gluino pairs, undecayed (FlipProduction.h): "
+           << nMade << " events, key " << hex << hash_string(production.key)
+           << dec << "\n-->\n"
+           << "<init>\n"
+           << maker.info.idA() << " " << maker.info.idB() << " "
+           << maker.info.eA() << " " << maker.info.eB() << " 0 0 0 0 3 1\n"
+           << production.sigma << " " << production.sigmaErr << " 1. "
+           << code << "\n"
+           << "</init>\n";
+
+    string whole = production.filename + pid.str() + ".lhe";
+    ofstream lhe(whole.c_str(), ios::out | ios::binary);
+    ifstream body(temporary.c_str(), ios::in | ios::binary);
+    lhe << header.str() << body.rdbuf();
+    lhe.close();
+    body.close();
+    remove(temporary.c_str());
+    rename(whole.c_str(), production.filename.c_str());
+
+    string meta = production.filename + ".meta";
+    ofstream metaout((meta + pid.str()).c_str());
+    metaout << setprecision(17);
+    metaout << "key " << hex << hash_string(production.key) << dec << endl
+            << "nEvent " << production.nEvent << endl
+            << "sigma_pb " << production.sigma << endl
+            << "sigmaErr_pb " << production.sigmaErr << endl
+            << production.key;
+    metaout.close();
+    rename((meta + pid.str()).c_str(), meta.c_str());
+
+    production.seconds = wall_seconds() - startTime;
+    return true;
+} // end make_production
+
+
+
+bool use_production(flipproduction& production, Pythia8::Pythia& pythia,
+                    string command_file, const runoptions& options){
+    // Reuse if there's a file with this key, else make it
+
+    production.on       = false;
+    production.made     = false;
+    production.dir      = options.production;
+    production.nEvent   = 0;
+    production.sigma    = 0;
+    production.sigmaErr = 0;
+    production.seconds  = 0;
+    if (production.dir == "") return false;
+
+    string commandText = read_file(command_file);
+    string spectrum = spectrum_file(commandText);
+    if (spectrum == ""){
+        cout << endl << "ERROR: no SLHA:file in " << command_file
+             << ", the gluinos are made as usual" << endl;
+        return false;
+    }
+    production.key = production_key(commandText, read_file(spectrum),
+                                    production_seed(commandText, options));
+
+    stringstream name;
+    name << production.dir << "/gluinos_" << hex << setw(8) << setfill('0')
+         << hash_string(production.key) << ".lhe";
+    production.filename = name.str();
+
+    // One maker per key, whether the others are threads (FlipLibrary.h)
+    //  or processes: they wait on filename.lock and then read its file.
+    //  flock, so a maker that dies lets go. Points with other keys don't
+    //  wait; the lock file is left behind, removing it would be a race
+    if (!read_production(production)){
+        mkdir(production.dir.c_str(), 0755);
+        string lockName = production.filename + ".lock";
+        int lock = open(lockName.c_str(), O_RDWR | O_CREAT, 0644);
+        if (lock >= 0) flock(lock, LOCK_EX);
+        bool ok = read_production(production);
+        if (!ok){
+            ok = make_production(production, command_file, options);
+            production.made = ok;
+        }
+        if (lock >= 0){
+            flock(lock, LOCK_UN);
+            close(lock);
+        }
+        if (!ok){
+            cout << endl << "ERROR: couldn't make the gluino pairs in "
+                 << production.filename << ", they're made as usual" << endl;
+            return false;
+        }
+    }
+
+    // later settings win over the command file's
+    stringstream nEvent;
+    nEvent << "Main:numberOfEvents = " << production.nEvent;
+    pythia.readString("Beams:frameType = 4");
+    pythia.readString("Beams:LHEF = " + production.filename);
+    pythia.readString(nEvent.str());
+
+    production.on = true;
+    return true;
+} // end use_production
+
+
+
+void report_production(flipproduction& production){
+    // e.g. "Gluino pairs: 10000 from gluinos/gluinos_1a2b3c4d.lhe (reused)"
+
+    if (!production.on) return;
+    cout << "Gluino pairs: " << production.nEvent << " from "
+         << production.filename;
+    if (production.made)
+        cout << " (made in " << production.seconds << " s)";
+    else
+        cout << " (reused)";
+    cout << ", " << production.sigma << " pb" << endl;
+} // end report_production
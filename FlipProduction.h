@@ -0,0 +1,56 @@
+// FlipProduction.h
+// Gluino pairs made once per gluino mass: the hard process without its
+//  decays goes to an LHE file, and every stop mass of the scan decays the
+//  same gluinos with its own spectrum
+// INCLUDE GUARD
+#ifndef __FLIPPRODUCTION_H_INCLUDED__
+#define __FLIPPRODUCTION_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+struct flipproduction{
+    // gg, qqbar -> gluino gluino doesn't know about the stop (the squarks
+    //  in the qqbar t-channel are the light flavours), so along a column
+    //  of the scan at fixed mglu only the decays change. The file is keyed
+    //  by a hash of the command file, the production seed and the spectrum
+    //  with the stop mass line taken out, i.e. of everything the
+    //  production depends on. SLHA:file and the Random: lines aren't part
+    //  of it: the spectrum is there by its contents, and the seed as the
+    //  production is made with it (seed=, else the command file's). A
+    //  point whose key has a file decays those events instead of making
+    //  new ones (Beams:frameType = 4). Decays, showers and the rest happen
+    //  in that run as they always did, with its own random numbers.
+    // The same gluino pairs then go into every stop mass of the column, so
+    //  the points' statistical errors move together and differences
+    //  between neighbouring stop masses come out smoother.
+    bool on;
+    string dir;                         // where the files are kept
+    string filename;                    // dir/gluinos_<hash of key>.lhe
+    string key;
+    bool made;                          // made by this run, not reused
+    int nEvent;                         // # gluino pairs in the file
+    double sigma;                       // pb
+    double sigmaErr;
+    double seconds;                     // to make them (made)
+};
+
+
+bool use_production(flipproduction&, Pythia8::Pythia&, string,
+                    const runoptions&);
+    // Inputs: production, pythia (command file read, not initialized
+    //  yet), command file, options (production=dir)
+    // Points pythia at the gluino pairs of this command file and spectrum,
+    //  making them first if there's no file for them yet, and sets
+    //  Main:numberOfEvents to the # in the file. False (and pythia left
+    //  as it was) if production= is off or they can't be made
+    // Safe to call from several threads: runs that need the same file
+    //  wait for the one making it, the others go ahead
+
+void report_production(flipproduction&);
+    // Where the gluinos came from
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPPRODUCTION_H_INCLUDED__
@@ -0,0 +1,502 @@
+/********************************************************************************
+*   FlipServer.cpp by Flip Tanedo (pt267@cornell.edu)                           *
+*   flip_efficiency behind a Unix-domain socket:                                *
+*   - a reader thread per connection turns lines into jobs                      *
+*   - worker threads, each with its own Pythia, take jobs off one queue         *
+*   - answers go back on the job's connection as soon as they're known          *
+********************************************************************************/
+
+#include "FlipServer.h"
+#include <sys/socket.h>                     // socket, bind, listen, accept
+#include <sys/un.h>                         // sockaddr_un
+#include <sys/select.h>                     // select, to notice shutdown
+#include <unistd.h>                         // read, write, close, unlink
+#include <signal.h>                         // SIGPIPE
+#include <cstring>                          // strncpy
+#include <cstdlib>                          // atoi, atof, rand
+#include <cmath>                            // sqrt
+
+
+struct flipthread{
+    // What a reader or worker thread is handed
+    flipserver* server;
+    flipclient* client;                     // reader: its connection
+    int index;                              // worker: its generator
+};
+
+
+
+void fill_server(flipserver& server){
+    // Two warm generators behind ./flipeff.sock
+
+    server.socketPath   = "flipeff.sock";
+    server.nWorkers     = 2;
+    server.warm         = true;
+    fill_effpoint(server.defaults);
+    server.listenFd     = -1;
+    server.nRunning     = 0;
+    server.nServed      = 0;
+    server.stopping     = false;
+} // end fill_server
+
+
+
+bool read_serveroption(flipserver& server, string argument){
+    // key=value
+
+    size_t equals = argument.find('=');
+    if (equals == string::npos) return false;
+
+    string key   = argument.substr(0, equals);
+    string value = argument.substr(equals+1);
+
+    if      (key == "cmnd")     server.defaults.cmndTemplate = value;
+    else if (key == "spc")      server.defaults.spcTemplate  = value;
+    else if (key == "scratch")  server.defaults.scratchDir   = value;
+    else if (key == "warm")     server.warm = (atoi(value.c_str()) != 0);
+    else return read_runoption(server.defaults.options, argument);
+
+    return true;
+} // end read_serveroption
+
+
+
+// CONNECTIONS
+// -----------
+
+static void send_line(flipclient* client, string line){
+    // The whole line or nothing; a client that went away just misses it
+
+    line += "\n";
+    pthread_mutex_lock(&client->lock);
+    size_t sent = 0;
+    while (sent < line.size()){
+        ssize_t n = write(client->fd, line.c_str() + sent, line.size() - sent);
+        if (n <= 0) break;
+        sent += n;
+    }
+    pthread_mutex_unlock(&client->lock);
+} // end send_line
+
+
+
+static void hold_client(flipclient* client){
+    pthread_mutex_lock(&client->lock);
+    client->refs++;
+    pthread_mutex_unlock(&client->lock);
+} // end hold_client
+
+
+
+static void release_client(flipclient* client){
+    // The last one out closes the connection
+
+    pthread_mutex_lock(&client->lock);
+    int refs = --client->refs;
+    pthread_mutex_unlock(&client->lock);
+    if (refs > 0) return;
+
+    close(client->fd);
+    pthread_mutex_destroy(&client->lock);
+    delete client;
+} // end release_client
+
+
+
+// REQUESTS
+// --------
+
+static bool read_request(flipserver& server, string line, flipjob& job,
+                         string& error){
+    // mstop mglu [SR,SR,...] [key=value ...]; false (and why) if it isn't
+
+    job.point     = server.defaults;
+    job.nEvents   = 0;
+    job.precision = 0;
+    job.maxEvents = 100000;
+    job.seed      = server.defaults.seed;
+    job.request   = line;
+
+    vector<string> positional;
+    stringstream words(line);
+    string word;
+    while (words >> word){
+        size_t equals = word.find('=');
+        if (equals == string::npos){
+            positional.push_back(word);
+            continue;
+        }
+        string key   = word.substr(0, equals);
+        string value = word.substr(equals+1);
+        if      (key == "id")        job.id        = value;
+        else if (key == "events")    job.nEvents   = atoi(value.c_str());
+        else if (key == "precision") job.precision = atof(value.c_str());
+        else if (key == "maxevents") job.maxEvents = atoi(value.c_str());
+        else if (key == "seed")      job.seed = strtoul(value.c_str(), 0, 10);
+        else if (!read_runoption(job.point.options, word)){
+            error = "unknown option " + word;
+            return false;
+        }
+    }
+
+    if ((positional.size() < 2) || (positional.size() > 3)){
+        error = "expected: mstop mglu [SR,SR,...] [key=value ...]";
+        return false;
+    }
+    job.point.mstop = atof(positional[0].c_str());
+    job.point.mglu  = atof(positional[1].c_str());
+    if ((job.point.mstop <= 0) || (job.point.mglu <= 0)){
+        error = "masses must be positive";
+        return false;
+    }
+    if (positional.size() == 3){
+        job.point.signalRegions.clear();
+        stringstream regions(positional[2]);
+        string region;
+        while (getline(regions, region, ','))
+            if (region != "")
+                job.point.signalRegions.push_back(atoi(region.c_str()));
+    }
+    job.point.options.seed  = 0;            // per run, below
+    job.point.options.quiet = true;
+
+    job.nRuns       = 0;
+    job.nEvent      = 0;
+    job.weights.assign(job.point.signalRegions.size(), 0.0);
+    job.nPassed.assign(job.point.signalRegions.size(), 0);
+    job.sigmaSum    = 0;
+    job.setupSum    = 0;
+    return true;
+} // end read_request
+
+
+
+static void add_job(flipserver& server, flipjob* job){
+    // To the back of the queue
+
+    pthread_mutex_lock(&server.lock);
+    server.queue.push_back(job);
+    pthread_cond_signal(&server.ready);
+    pthread_mutex_unlock(&server.lock);
+} // end add_job
+
+
+
+static void finish_job(flipserver& server, flipjob* job){
+    // One result line per SR, then done
+
+    for (unsigned int i = 0; i < job->weights.size(); i++){
+        stringstream result;
+        result << setprecision(8) << "result " << job->id << " "
+               << job->point.mstop << " " << job->point.mglu << " "
+               << job->point.signalRegions[i] << " "
+               << job->weights[i] / double(job->nEvent) << " "
+               << job->sigmaSum / double(job->nEvent) * 1e9 << " "
+               << job->nEvent << " " << job->nPassed[i];
+        send_line(job->client, result.str());
+    }
+    double seconds = wall_seconds() - job->startTime;
+    stringstream done;
+    done << "done " << job->id << " " << seconds;
+    send_line(job->client, done.str());
+
+    pthread_mutex_lock(&server.lock);
+    server.nServed++;
+    cout << "Served " << job->request << ": " << job->nEvent << " events in "
+         << job->nRuns << " runs, " << seconds << " s (start-up "
+         << job->setupSum / job->nRuns << " s per run)" << endl;
+    pthread_mutex_unlock(&server.lock);
+
+    release_client(job->client);
+    delete job;
+} // end finish_job
+
+
+
+static void fail_job(flipjob* job, string error){
+    // Nothing more for this one
+
+    send_line(job->client, "error " + job->id + " " + error);
+    release_client(job->client);
+    delete job;
+} // end fail_job
+
+
+
+static void run_job(flipserver& server, flipjob* job, Pythia8::Pythia* pythia){
+    // One run of job->nEvents, with the next seed; then either the answer
+    //  or back in the queue for another run
+
+    flipeffpoint point = job->point;
+    point.seed = job->seed + job->nRuns;
+    stringstream randomSeed;
+    randomSeed << "Random:seed = " << 1 + point.seed % 900000000u;
+    point.settings.push_back("Random:setSeed = on");
+    point.settings.push_back(randomSeed.str());
+    if (job->nEvents > 0){
+        stringstream nEvents;
+        nEvents << "Main:numberOfEvents = " << job->nEvents;
+        point.settings.push_back(nEvents.str());
+    }
+
+    flipeffresult run = flip_efficiency(point, pythia);
+    if (!run.ok){
+        fail_job(job, run.error);
+        return;
+    }
+
+    job->nRuns++;
+    job->nEvent += run.nEvent;
+    job->sigmaSum += run.sigmaGen * run.nEvent;
+    job->setupSum += run.setupSeconds;
+    for (unsigned int i = 0; i < job->weights.size(); i++){
+        job->weights[i] += run.efficiencies[i] * run.nEvent;
+        job->nPassed[i] += run.cutflows[i].events[cutCharge];
+    }
+
+    if ((job->precision > 0) && (job->nEvent > 0)){
+        double relerr = (job->nPassed[0] > 0) ? 1 / sqrt(job->nPassed[0])
+                                              : 1;
+        stringstream progress;
+        progress << setprecision(8) << "progress " << job->id << " "
+                 << job->nEvent << " " << job->weights[0] / job->nEvent
+                 << " " << relerr;
+        send_line(job->client, progress.str());
+        if ((relerr > job->precision) && (job->nEvent < job->maxEvents)
+            && (run.nEvent > 0)){
+            add_job(server, job);
+            return;
+        }
+    }
+
+    if (job->nEvent <= 0){
+        fail_job(job, "no events");
+        return;
+    }
+    finish_job(server, job);
+} // end run_job
+
+
+
+// THREADS
+// -------
+
+static void* worker_thread(void* argument){
+    // Jobs off the front of the queue until shutdown
+
+    flipthread* thread = (flipthread*) argument;
+    flipserver& server = *thread->server;
+    Pythia8::Pythia* pythia = server.warm ? server.generators[thread->index]
+                                          : 0;
+    delete thread;
+
+    while (true){
+        pthread_mutex_lock(&server.lock);
+        while (server.queue.empty() && !server.stopping)
+            pthread_cond_wait(&server.ready, &server.lock);
+        if (server.stopping){
+            pthread_mutex_unlock(&server.lock);
+            break;
+        }
+        flipjob* job = server.queue.front();
+        server.queue.pop_front();
+        server.nRunning++;
+        pthread_mutex_unlock(&server.lock);
+
+        run_job(server, job, pythia);
+
+        pthread_mutex_lock(&server.lock);
+        server.nRunning--;
+        pthread_mutex_unlock(&server.lock);
+    }
+    return 0;
+} // end worker_thread
+
+
+
+static void* reader_thread(void* argument){
+    // Lines in, jobs out
+
+    flipthread* thread = (flipthread*) argument;
+    flipserver& server = *thread->server;
+    flipclient* client = thread->client;
+    delete thread;
+
+    string pending;
+    char buffer[4096];
+    while (true){
+        ssize_t n = read(client->fd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        pending.append(buffer, n);
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != string::npos){
+            string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if ((line != "") && (line[line.size()-1] == '\r'))
+                line.erase(line.size() - 1);
+            if ((line == "") || (line[0] == '#')) continue;
+
+            if ((line == "status") || (line == "shutdown")){
+                pthread_mutex_lock(&server.lock);
+                if (line == "shutdown"){
+                    server.stopping = true;
+                    pthread_cond_broadcast(&server.ready);
+                }
+                stringstream status;
+                status << "status " << server.queue.size() << " "
+                       << server.nRunning << " " << server.nWorkers << " "
+                       << server.nServed;
+                pthread_mutex_unlock(&server.lock);
+                send_line(client, status.str());
+                continue;
+            }
+
+            flipjob* job = new flipjob;
+            job->client = client;
+            stringstream id;
+            id << ++client->nRequests;
+            job->id = id.str();
+            string error;
+            if (!read_request(server, line, *job, error)){
+                send_line(client, "error " + job->id + " " + error);
+                delete job;
+                continue;
+            }
+
+            pthread_mutex_lock(&server.lock);
+            bool stopping = server.stopping;
+            if (job->seed == 0) job->seed = 1 + rand() % 900000000;
+            pthread_mutex_unlock(&server.lock);
+            if (stopping){
+                send_line(client, "error " + job->id + " shutting down");
+                delete job;
+                continue;
+            }
+
+            job->startTime = wall_seconds();
+            hold_client(client);
+            add_job(server, job);
+        }
+    }
+
+    release_client(client);
+    return 0;
+} // end reader_thread
+
+
+
+// SERVER
+// ------
+
+bool start_server(flipserver& server){
+    // Generators, workers, socket
+
+    signal(SIGPIPE, SIG_IGN);               // a client hanging up isn't fatal
+    pthread_mutex_init(&server.lock, 0);
+    pthread_cond_init(&server.ready, 0);
+    if (server.nWorkers < 1) server.nWorkers = 1;
+
+    struct sockaddr_un address;
+    if (server.socketPath.size() >= sizeof(address.sun_path)){
+        cout << endl << "ERROR: socket path too long: " << server.socketPath
+             << endl;
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, server.socketPath.c_str(),
+            sizeof(address.sun_path) - 1);
+
+    server.listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(server.socketPath.c_str());
+    if ((server.listenFd < 0) ||
+        bind(server.listenFd, (struct sockaddr*) &address, sizeof(address))
+        || listen(server.listenFd, 16)){
+        cout << endl << "ERROR: can't listen on " << server.socketPath << endl;
+        if (server.listenFd >= 0) close(server.listenFd);
+        return false;
+    }
+
+    // the expensive part, once
+    server.generators.clear();
+    if (server.warm)
+        for (int i = 0; i < server.nWorkers; i++)
+            server.generators.push_back(new Pythia8::Pythia);
+
+    server.workers.resize(server.nWorkers);
+    for (int i = 0; i < server.nWorkers; i++){
+        flipthread* thread = new flipthread;
+        thread->server = &server;
+        thread->client = 0;
+        thread->index  = i;
+        if (pthread_create(&server.workers[i], 0, worker_thread, thread)){
+            cout << endl << "ERROR: couldn't start worker thread" << endl;
+            exit(1);
+        }
+    }
+
+    cout << "Listening on " << server.socketPath << " with "
+         << server.nWorkers << (server.warm ? " warm" : "")
+         << " generators" << endl;
+    return true;
+} // end start_server
+
+
+
+void run_server(flipserver& server){
+    // Accept until shutdown; select() with a timeout so it notices
+
+    while (true){
+        pthread_mutex_lock(&server.lock);
+        bool stopping = server.stopping;
+        pthread_mutex_unlock(&server.lock);
+        if (stopping) break;
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(server.listenFd, &readable);
+        struct timeval timeout;
+        timeout.tv_sec  = 0;
+        timeout.tv_usec = 200000;
+        if (select(server.listenFd + 1, &readable, 0, 0, &timeout) <= 0)
+            continue;
+
+        int fd = accept(server.listenFd, 0, 0);
+        if (fd < 0) continue;
+
+        flipclient* client = new flipclient;
+        client->fd = fd;
+        client->refs = 1;                   // the reader
+        client->nRequests = 0;
+        pthread_mutex_init(&client->lock, 0);
+
+        flipthread* thread = new flipthread;
+        thread->server = &server;
+        thread->client = client;
+        thread->index  = -1;
+        pthread_t reader;
+        if (pthread_create(&reader, 0, reader_thread, thread)){
+            cout << endl << "ERROR: couldn't start reader thread" << endl;
+            close(fd);
+            delete client;
+            delete thread;
+            continue;
+        }
+        pthread_detach(reader);
+    }
+
+    // SHUTDOWN
+    close(server.listenFd);
+    unlink(server.socketPath.c_str());
+    for (int i = 0; i < server.nWorkers; i++)
+        pthread_join(server.workers[i], 0);
+    while (!server.queue.empty()){
+        fail_job(server.queue.front(), "shutting down");
+        server.queue.pop_front();
+    }
+    for (unsigned int i = 0; i < server.generators.size(); i++)
+        delete server.generators[i];
+    server.generators.clear();
+    cout << "Shut down after " << server.nServed << " requests" << endl;
+} // end run_server
@@ -0,0 +1,105 @@
+// FlipServer.h
+// Signal efficiencies on request: a long-running process keeps a few
+//  Pythia objects built and answers mass points sent over a local socket
+// INCLUDE GUARD
+#ifndef __FLIPSERVER_H_INCLUDED__
+#define __FLIPSERVER_H_INCLUDED__
+
+#include "FlipLibrary.h"
+#include <pthread.h>
+#include <deque>
+using namespace std;
+
+// Requests are lines of text, any number of them on one connection:
+//
+//      mstop mglu [SR,SR,...] [key=value ...]
+//
+//  e.g. "400 900 8,6 events=5000 seed=7" or "400 900 precision=0.05".
+//  Keys: id= (echoed back, default the # of the request on the
+//  connection), events= (per run, default the command file's),
+//  precision= (keep running events= more until the first SR's relative
+//  statistical error, 1/sqrt(# passed), is below it), maxevents= (stop
+//  there anyway, default 100000), seed= (0: drawn), and any PartonRPV
+//  option (batch=, force=, hadron=, ...). "status" and "shutdown" are
+//  requests too.
+//
+// Answers come back as they're ready, one line each:
+//
+//      progress id nEvent efficiency relerr       (precision=, per run)
+//      result id mstop mglu SR efficiency sigma(pb) nEvent nPassed
+//      done id seconds
+//      error id message
+//      status queued running workers served
+//
+//  so a client can send many points and read the answers as they come.
+
+struct flipclient{
+    // One connection. It stays open while it's being read or any of its
+    //  requests are waiting or running (refs); the last one closes it.
+    int fd;
+    int refs;
+    int nRequests;                      // for default ids
+    pthread_mutex_t lock;               // one line at a time, and refs
+};
+
+struct flipjob{
+    // One request. With precision= it goes back in the queue after every
+    //  run, so long requests take turns with short ones.
+    flipclient* client;
+    string id;
+    string request;                     // as sent, for the log
+    flipeffpoint point;
+    int nEvents;                        // per run, 0: the command file's
+    double precision;                   // 0: just one run
+    int maxEvents;
+    unsigned int seed;                  // of the first run
+    int nRuns;
+    double startTime;
+
+    // added up over the runs, per SR in the order asked for
+    int nEvent;
+    vector<double> weights;             // efficiency * nEvent
+    vector<int> nPassed;
+    double sigmaSum;                    // sigmaGen * nEvent (mb)
+    double setupSum;                    // start-up seconds of the runs
+};
+
+struct flipserver{
+    // Settings
+    string socketPath;
+    int nWorkers;
+    bool warm;                          // keep a Pythia per worker
+    flipeffpoint defaults;              // templates, scratch, options
+
+    // State
+    int listenFd;
+    deque<flipjob*> queue;
+    int nRunning;
+    int nServed;
+    bool stopping;
+    pthread_mutex_t lock;               // queue and counts
+    pthread_cond_t ready;               // something in the queue, or stop
+    vector<Pythia8::Pythia*> generators;
+    vector<pthread_t> workers;
+};
+
+
+void fill_server(flipserver&);
+    // Defaults: flipeff.sock, 2 workers, warm, flip_efficiency's defaults
+
+bool read_serveroption(flipserver&, string);
+    // cmnd=, spc=, scratch=, warm=0/1, or a run option (read_runoption)
+    //  that every request starts from. False if it's none of those
+
+bool start_server(flipserver&);
+    // Builds the generators, starts the workers and listens on the
+    //  socket (an old socket file is replaced). False if it can't listen
+
+void run_server(flipserver&);
+    // Takes connections until a shutdown request, then stops the workers
+    //  and answers what's left in the queue with an error
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPSERVER_H_INCLUDED__
@@ -0,0 +1,382 @@
+/********************************************************************************
+*   FlipSkim.cpp by Flip Tanedo (pt267@cornell.edu)                             *
+*   Skims: the events past a chosen cut stage, written out as they come.        *
+*   - skim_event: cuts (same dice as the cutflow), bytes into a buffer          *
+*   - the writer thread: buffers off the queue, into the file                   *
+*   - write_skim_meta: cross section etc., to normalise the skim later          *
+********************************************************************************/
+
+#include "FlipSkim.h"
+#include <iomanip>                          // setprecision, scientific
+#include <cstdio>                           // remove
+
+
+static const unsigned int skim_buffer_size = 1 << 16;   // bytes per hand-over
+
+
+
+
+int read_skim_stage(string name){
+    // Name or number
+
+    for (int iStage = 0; iStage < nCutStages; iStage++)
+        if (name == cutstage_name(iStage)) return iStage;
+
+    char* end = 0;
+    long stage = strtol(name.c_str(), &end, 10);
+    if ((name != "") && !*end && (stage >= 0) && (stage < nCutStages))
+        return stage;
+    return -1;
+} // end read_skim_stage
+
+
+
+/********************************************************************************
+*   Bytes. Records are ints and doubles as they sit in memory.                  *
+********************************************************************************/
+
+static void put_int(string& bytes, int value){
+    bytes.append((const char*) &value, sizeof(value));
+} // end put_int
+
+static void put_double(string& bytes, double value){
+    bytes.append((const char*) &value, sizeof(value));
+} // end put_double
+
+static void put_particles(string& bytes,
+                          vector< pair<int, fastjet::PseudoJet> >& particles){
+    // count, then id px py pz e for each
+    put_int(bytes, particles.size());
+    for (unsigned int i = 0; i < particles.size(); i++){
+        fastjet::PseudoJet& p = particles[i].second;
+        put_int(bytes, particles[i].first);
+        put_double(bytes, p.px());
+        put_double(bytes, p.py());
+        put_double(bytes, p.pz());
+        put_double(bytes, p.e());
+    }
+} // end put_particles
+
+static bool get_int(istream& in, int& value){
+    return in.read((char*) &value, sizeof(value)).good();
+} // end get_int
+
+static bool get_double(istream& in, double& value){
+    return in.read((char*) &value, sizeof(value)).good();
+} // end get_double
+
+static bool get_particles(istream& in,
+                          vector< pair<int, fastjet::PseudoJet> >& particles){
+    particles.clear();
+    int n = 0;
+    if (!get_int(in, n) || (n < 0)) return false;
+    for (int i = 0; i < n; i++){
+        int id;
+        double px, py, pz, e;
+        if (!(get_int(in, id) && get_double(in, px) && get_double(in, py) &&
+              get_double(in, pz) && get_double(in, e)))
+            return false;
+        particles.push_back(make_pair(id, fastjet::PseudoJet(px, py, pz, e)));
+    }
+    return true;
+} // end get_particles
+
+
+
+static void write_record(string& bytes, flipevent& record){
+    // iEvent weight HT MET(px py pz e) leptons partons bpartons
+
+    put_int(bytes, record.iEvent);
+    put_double(bytes, record.weight);
+    put_double(bytes, record.HT);
+    put_double(bytes, record.METvec.px());
+    put_double(bytes, record.METvec.py());
+    put_double(bytes, record.METvec.pz());
+    put_double(bytes, record.METvec.e());
+    put_particles(bytes, record.preleptons);
+    put_particles(bytes, record.prepartons);
+    put_particles(bytes, record.bpartons);
+} // end write_record
+
+
+
+bool read_skim_event(istream& in, flipevent& record){
+    // The other way round
+
+    double px, py, pz, e;
+    if (!(get_int(in, record.iEvent) && get_double(in, record.weight) &&
+          get_double(in, record.HT) && get_double(in, px) &&
+          get_double(in, py) && get_double(in, pz) && get_double(in, e)))
+        return false;
+    record.METvec = fastjet::PseudoJet(px, py, pz, e);
+
+    return get_particles(in, record.preleptons) &&
+           get_particles(in, record.prepartons) &&
+           get_particles(in, record.bpartons);
+} // end read_skim_event
+
+
+
+void write_lhe_event(string& bytes, Pythia8::Event& process,
+                     Pythia8::Info& info, double weight){
+    // Les Houches event from the hard process record. Entry 0 (the whole
+    //  system) and the beams aren't particles of the event, so the rest
+    //  get renumbered from 1 and the mothers with them.
+
+    vector<int> line(process.size(), 0);    // LHE line of each entry
+    int nLines = 0;
+    for (int iPart = 1; iPart < process.size(); iPart++){
+        int status = abs(process[iPart].status());
+        if ((status == 11) || (status == 12)) continue;
+        line[iPart] = ++nLines;
+    }
+
+    stringstream lhe;
+    lhe << setprecision(10) << scientific;
+    lhe << "<event>\n"
+        << nLines << " " << info.code() << " " << weight << " "
+        << info.QFac() << " " << info.alphaEM() << " " << info.alphaS()
+        << "\n";
+
+    for (int iPart = 1; iPart < process.size(); iPart++){
+        if (line[iPart] == 0) continue;
+        Pythia8::Particle& particle = process[iPart];
+        int status = particle.isFinal() ? 1 : 2;
+        if (particle.status() == -21) status = -1;      // incoming
+
+        lhe << particle.id() << " " << status << " "
+            << line[particle.mother1()] << " " << line[particle.mother2()]
+            << " " << particle.col() << " " << particle.acol() << " "
+            << particle.px() << " " << particle.py() << " "
+            << particle.pz() << " " << particle.e() << " "
+            << particle.m() << " " << particle.tau() << " 9.\n";
+    }
+    lhe << "</event>\n";
+
+    bytes += lhe.str();
+} // end write_lhe_event
+
+
+
+/********************************************************************************
+*   The writer thread and the hand-over                                         *
+********************************************************************************/
+
+static void* skim_thread(void* argument){
+    // Writes whatever is on the queue until told there's no more
+
+    flipskim& skim = *(flipskim*) argument;
+    vector<string> writing;
+
+    while (true){
+        pthread_mutex_lock(&skim.lock);
+        while (skim.queue.empty() && !skim.done)
+            pthread_cond_wait(&skim.wake, &skim.lock);
+        writing.swap(skim.queue);
+        bool finished = skim.done && writing.empty();
+        pthread_mutex_unlock(&skim.lock);
+
+        for (unsigned int i = 0; i < writing.size(); i++)
+            skim.out.write(writing[i].data(), writing[i].size());
+        writing.clear();
+
+        if (finished) break;
+    }
+    return 0;
+} // end skim_thread
+
+
+
+static void hand_over(flipskim& skim){
+    // The buffer goes on the queue (no copy), a new one is started
+
+    pthread_mutex_lock(&skim.lock);
+    skim.queue.push_back(string());
+    skim.queue.back().swap(skim.buffer);
+    pthread_cond_signal(&skim.wake);
+    pthread_mutex_unlock(&skim.lock);
+
+    skim.buffer.reserve(skim_buffer_size + skim_buffer_size / 4);
+} // end hand_over
+
+
+
+bool start_skim(flipskim& skim, const runoptions& options){
+    // File (and for records, its header), thread
+
+    skim.stage          = -1;
+    skim.nSkimmed       = 0;
+    skim.weightSkimmed  = 0;
+    skim.maxWeight      = 0;
+    skim.done           = false;
+    skim.queue.clear();
+    skim.buffer.clear();
+    fill_state(skim.state, options.isoGrid);
+    if (options.skim == "") return false;
+
+    int stage = read_skim_stage(options.skim);
+    if (stage < 0){
+        cout << endl << "ERROR: no cut stage called " << options.skim
+             << ", not skimming" << endl;
+        return false;
+    }
+
+    skim.filename = options.skimFile;
+    size_t dot = skim.filename.rfind('.');
+    skim.lhe = (dot != string::npos) && (skim.filename.substr(dot) == ".lhe");
+
+    // LHE: the events go to a file of their own, the header (which
+    //  needs the cross section) goes in front of them at the end
+    string events = skim.lhe ? skim.filename + ".events.tmp" : skim.filename;
+    skim.out.open(events.c_str(), ios::out | ios::binary);
+    if (!skim.out.is_open()){
+        cout << endl << "ERROR: can't write " << events
+             << ", not skimming" << endl;
+        return false;
+    }
+
+    // HEADER
+    // ------
+    skim.buffer.reserve(skim_buffer_size + skim_buffer_size / 4);
+    if (!skim.lhe) skim.buffer.append("FLIPSKM1", 8);
+
+    if (pthread_mutex_init(&skim.lock, 0) ||
+        pthread_cond_init(&skim.wake, 0) ||
+        pthread_create(&skim.thread, 0, skim_thread, &skim)){
+        cout << endl << "ERROR: couldn't start the skim writer" << endl;
+        skim.out.close();
+        return false;
+    }
+
+    skim.stage = stage;
+    return true;
+} // end start_skim
+
+
+
+void skim_event(flipskim& skim, flipevent& record, Pythia8::Event& process,
+                Pythia8::Info& info, signalregion& region,
+                const effparams& params, unsigned int seed){
+    // Every cut up to the stage, in the canonical order, same dice
+
+    if (skim.stage < 0) return;
+
+    clear_state(skim.state);
+    for (int stage = cutKinematic; stage <= skim.stage; stage++)
+        if (!run_stage(stage, record, region, params, seed, skim.state))
+            return;
+
+    skim.nSkimmed++;
+    skim.weightSkimmed += record.weight;
+    skim.maxWeight = max(skim.maxWeight, record.weight);
+    if (skim.lhe) write_lhe_event(skim.buffer, process, info, record.weight);
+    else write_record(skim.buffer, record);
+
+    if (skim.buffer.size() >= skim_buffer_size) hand_over(skim);
+} // end skim_event
+
+
+
+void stop_skim(flipskim& skim){
+    // Last buffer, then wait for the writer to finish
+
+    if (skim.stage < 0) return;
+
+    hand_over(skim);
+
+    pthread_mutex_lock(&skim.lock);
+    skim.done = true;
+    pthread_cond_signal(&skim.wake);
+    pthread_mutex_unlock(&skim.lock);
+
+    pthread_join(skim.thread, 0);
+    pthread_mutex_destroy(&skim.lock);
+    pthread_cond_destroy(&skim.wake);
+    skim.out.close();
+} // end stop_skim
+
+
+
+static void finish_lhe(flipskim& skim, Pythia8::Info& info, double sigma,
+                       double sigmaErr, int nEvent){
+    // <init> with IDWTUP = 4 (weighted, XWGTUP in pb, the cross section
+    //  is the mean XWGTUP), then the events with their weights in pb:
+    //  XWGTUP = sigma * weight * nSkimmed / nEvent, so the mean is sigma
+    //  * weightSkimmed / nEvent, the skim's cross section (XSECUP)
+
+    string events = skim.filename + ".events.tmp";
+    double pb = 1e9 * sigma * skim.nSkimmed / double(nEvent);
+    double efficiency = skim.weightSkimmed / double(nEvent);
+
+    ofstream out(skim.filename.c_str(), ios::out | ios::binary);
+    out << setprecision(10) << scientific;
+    out << "<LesHouchesEvents version=\"1.0\">\n"
+        << "<!--\n  Events past the " << cutstage_name(skim.stage)
+        << " cut, weighted: XWGTUP is the cross section * the event weight"
+        << " (FlipBias.h) * " << skim.nSkimmed << " / " << nEvent
+        << " generated. More in " << skim.filename << ".meta\n-->\n"
+        << "<init>\n"
+        << info.idA() << " " << info.idB() << " "
+        << info.eA() << " " << info.eB() << " 0 0 0 0 4 1\n"
+        << 1e9 * sigma * efficiency << " " << 1e9 * sigmaErr * efficiency
+        << " " << pb * skim.maxWeight << " " << info.code() << "\n"
+        << "</init>\n";
+
+    // NUP IDPRUP XWGTUP ...: the line after <event>, weight in pb
+    ifstream in(events.c_str(), ios::in | ios::binary);
+    string line;
+    bool first = false;
+    while (getline(in, line)){
+        if (first){
+            stringstream words(line);
+            int nLines, code;
+            double weight;
+            words >> nLines >> code >> weight;
+            string rest;
+            getline(words, rest);
+            out << nLines << " " << code << " " << pb * weight << rest
+                << "\n";
+        }
+        else out << line << "\n";
+        first = (line == "<event>");
+    }
+    out << "</LesHouchesEvents>\n";
+    out.close();
+    in.close();
+    remove(events.c_str());
+} // end finish_lhe
+
+
+
+void write_skim_meta(flipskim& skim, Pythia8::Pythia& pythia,
+                     const runoptions& options, int nEvent, int iSR,
+                     unsigned int seed, double sigma, double sigmaErr){
+    // key value, one per line. The skim is sigma * weight / nEvent of
+    //  the cross section (that's the efficiency of the stage)
+
+    if (skim.stage < 0) return;
+    if (skim.lhe && (nEvent > 0))
+        finish_lhe(skim, pythia.info, sigma, sigmaErr, nEvent);
+
+    string metafile = skim.filename + ".meta";
+    ofstream meta(metafile.c_str());
+    meta << setprecision(10);
+    meta << "# " << skim.filename << ": events past the "
+         << cutstage_name(skim.stage) << " cut" << endl;
+    meta << "format\t"          << (skim.lhe ? "lhe" : "records") << endl;
+    meta << "stage\t"           << cutstage_name(skim.stage) << endl;
+    meta << "mstop\t"           << pythia.particleData.m0(1000006) << endl;
+    meta << "mglu\t"            << pythia.particleData.m0(1000021) << endl;
+    meta << "signalregion\t"    << iSR << endl;
+    meta << "seed\t"            << seed << endl;
+    meta << "forced\t"          << options.forced << endl;
+    meta << "hadron\t"          << options.hadron << endl;
+    meta << "sigmaGen_mb\t"     << sigma << endl;
+    meta << "sigmaErr_mb\t"     << sigmaErr << endl;
+    meta << "nEvent\t"          << nEvent << endl;
+    meta << "nSkimmed\t"        << skim.nSkimmed << endl;
+    meta << "weightSkimmed\t"   << skim.weightSkimmed << endl;
+    meta << "efficiency\t"      << skim.weightSkimmed / double(nEvent)
+         << endl;
+    meta.close();
+} // end write_skim_meta
@@ -0,0 +1,87 @@
+// FlipSkim.h
+// Writes out the events that get past a chosen cut stage, as LHE (the
+//  hard process, to shower/decay again) or as compact event records (to
+//  run the selection on again), on a thread of its own
+// INCLUDE GUARD
+#ifndef __FLIPSKIM_H_INCLUDED__
+#define __FLIPSKIM_H_INCLUDED__
+
+#include "FlipEvent.h"
+#include <pthread.h>                        // writer thread
+using namespace std;
+
+struct flipskim{
+    // The event loop decides whether an event makes it past the stage
+    //  (the same cuts and dice as the cutflow, so the skim has exactly the
+    //  events counted there), turns it into bytes and appends them to
+    //  buffer. Full buffers go on the queue, and the writer thread takes
+    //  them from there to the file; the event loop only ever holds the
+    //  lock for as long as it takes to hand over a buffer.
+    //
+    // LHE: pythia.process as a Les Houches event, weighted (IDWTUP = 4):
+    //  XWGTUP is the cross section in pb times the event weight
+    //  (FlipBias.h) times nSkimmed / nEvent, so a reader that averages
+    //  them gets the skim's cross section, which is XSECUP. Neither is
+    //  known until the end of the run, so the events go to a file of
+    //  their own and write_skim_meta puts the header in front and the
+    //  weights in.
+    // Records: the flipevent (FlipEvent.h) as it is, in the machine's
+    //  own byte order; read_skim_event reads them back. Starts with the
+    //  8 bytes "FLIPSKM1".
+    // Either way, skimfile.meta gets what's needed to normalise: the
+    //  cross section, # events generated, the weights, the options.
+    int stage;                              // cutstage to pass, -1: off
+    bool lhe;                               // LHE, or records
+    string filename;
+    int nSkimmed;                           // # events written ...
+    double weightSkimmed;                   // ... and their weights
+    double maxWeight;                       // for XMAXUP
+    flipstate state;                        // scratch for the cuts
+    string buffer;                          // being filled by the event loop
+    vector<string> queue;                   // full buffers to write
+    bool done;                              // no more buffers coming
+    pthread_mutex_t lock;                   // queue and done
+    pthread_cond_t wake;                    // something on the queue
+    pthread_t thread;
+    ofstream out;                           // only the writer touches it
+};
+
+
+int read_skim_stage(string);
+    // Stage name (kinematic, lepid, lepiso, btag, dilepton, trigger, ss2l,
+    //  jets, bjets, met, ht, charge) or number to cutstage; -1 if neither
+
+bool start_skim(flipskim&, const runoptions&);
+    // Inputs: skim, options (skim=stage, skimfile=name)
+    // Opens the file and starts the writer
+    // Returns false (and skims nothing) if skim is off or can't start
+
+void skim_event(flipskim&, flipevent&, Pythia8::Event&, Pythia8::Info&,
+                signalregion&, const effparams&, unsigned int);
+    // Inputs: skim, event record, pythia.process, pythia.info, signal
+    //  region, parameters, run seed
+    // Writes the event if it passes every cut up to the stage
+
+void stop_skim(flipskim&);
+    // Hands over the last buffer, waits for the writer, closes the file
+
+void write_skim_meta(flipskim&, Pythia8::Pythia&, const runoptions&,
+                     int, int, unsigned int, double, double);
+    // Inputs: skim, pythia (after the run), options, nEvent, signal
+    //  region, run seed, the run's cross section and its error (mb, as
+    //  signal_efficiency_b works them out: the stored production's with
+    //  cascade=, the vetoed events and forced decays put back).
+    //  Writes filename.meta, and finishes an LHE skim
+
+bool read_skim_event(istream&, flipevent&);
+    // Reads the next event record back (after the 8 byte header);
+    //  false at the end of the file
+
+void write_lhe_event(string&, Pythia8::Event&, Pythia8::Info&, double);
+    // Inputs: bytes, pythia.process, pythia.info, event weight
+    // Appends the hard process as an LHE <event> (also FlipProduction.h)
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPSKIM_H_INCLUDED__
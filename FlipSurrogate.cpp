@@ -0,0 +1,202 @@
+/********************************************************************************
+*   FlipSurrogate.cpp by Flip Tanedo (pt267@cornell.edu)                        *
+*   Gaussian process interpolation of the signal efficiency                     *
+*   Each signal region gets its own fit to the points we already ran. The       *
+*   predicted uncertainty tells us which new points are worth running.          *
+********************************************************************************/
+
+#include "FlipSurrogate.h"
+
+
+int read_efficiencies(string datafile,
+                      map<int, vector<surrogatepoint> >& data){
+    // Reads the efficiencies and averages repeated runs of the same point
+
+    ifstream instream;
+    instream.open(datafile.c_str());
+
+    // running sums, keyed by (SR, mstop, mglu)
+    map< pair<int, pair<double, double> >, pair<double, int> > sums;
+
+    int nUsed = 0;
+    string line;
+    while (getline(instream, line)){
+
+        if (line.empty() || (line[0] == '#')) continue;
+
+        stringstream linestream(line);
+        double mstop, mglu, eff;
+        int iSR;
+        if (!(linestream >> mstop >> mglu >> iSR >> eff)) continue;
+
+        pair<double, double> masses(mstop, mglu);
+        pair<double, int>& sum = sums[make_pair(iSR, masses)];
+        sum.first += eff;
+        sum.second++;
+        nUsed++;
+    }
+    instream.close();
+
+    map< pair<int, pair<double, double> >, pair<double, int> >::iterator it;
+    for (it = sums.begin(); it != sums.end(); it++){
+        surrogatepoint point;
+        point.mstop      = it->first.second.first;
+        point.mglu       = it->first.second.second;
+        point.efficiency = it->second.first / it->second.second;
+        point.nRuns      = it->second.second;
+        data[it->first.first].push_back(point);
+    }
+
+    return nUsed;
+} // end read_efficiencies
+
+
+
+double surrogate_kernel(surrogate& model, double mstop1, double mglu1,
+                                          double mstop2, double mglu2){
+    // squared exponential covariance between two points
+
+    double dstop = (mstop1 - mstop2) / model.lengthStop;
+    double dglu  = (mglu1  - mglu2 ) / model.lengthGlu;
+    return model.amplitude * model.amplitude
+            * exp(-0.5 * (dstop*dstop + dglu*dglu));
+} // end surrogate_kernel
+
+
+
+bool fit_surrogate(surrogate& model){
+    // K = L L^T with K_ij = k(x_i, x_j) + delta_ij noise^2/nRuns_i
+    // then alpha = K^-1 (y - mean)
+
+    int n = model.points.size();
+    if (n == 0) return false;
+
+    // prior mean and amplitude from the data themselves. The amplitude is
+    //  also what the uncertainty goes back to far from the data, so on a
+    //  flat or sparse scan the spread alone would make it too small to
+    //  flag anything: it has a floor
+    double sum = 0;
+    double sumsq = 0;
+    for (int i = 0; i < n; i++){
+        sum   += model.points[i].efficiency;
+        sumsq += model.points[i].efficiency * model.points[i].efficiency;
+    }
+    model.mean = sum / n;
+    double variance = sumsq/n - model.mean*model.mean;
+    model.amplitude = (variance > 0) ? sqrt(variance) : model.noise;
+    if (model.amplitude < model.minAmplitude)
+        model.amplitude = model.minAmplitude;
+    if (model.amplitude <= 0) model.amplitude = 1.0e-6;
+
+    // covariance matrix, lower triangle is all we need
+    vector<double>& L = model.chol;
+    L.assign(n*n, 0.0);
+    for (int i = 0; i < n; i++){
+        for (int j = 0; j <= i; j++)
+            L[i*n + j] = surrogate_kernel(model,
+                            model.points[i].mstop, model.points[i].mglu,
+                            model.points[j].mstop, model.points[j].mglu);
+        L[i*n + i] += model.noise * model.noise / model.points[i].nRuns;
+    }
+
+    // Cholesky, in place
+    for (int j = 0; j < n; j++){
+        double diag = L[j*n + j];
+        for (int k = 0; k < j; k++) diag -= L[j*n + k] * L[j*n + k];
+        if (diag <= 0) return false;
+        diag = sqrt(diag);
+        L[j*n + j] = diag;
+        for (int i = j+1; i < n; i++){
+            double entry = L[i*n + j];
+            for (int k = 0; k < j; k++) entry -= L[i*n + k] * L[j*n + k];
+            L[i*n + j] = entry / diag;
+        }
+    }
+
+    // alpha = L^-T L^-1 (y - mean)
+    vector<double>& alpha = model.alpha;
+    alpha.assign(n, 0.0);
+    for (int i = 0; i < n; i++){
+        double entry = model.points[i].efficiency - model.mean;
+        for (int k = 0; k < i; k++) entry -= L[i*n + k] * alpha[k];
+        alpha[i] = entry / L[i*n + i];
+    }
+
+    // log marginal likelihood, while we still have L^-1 (y - mean)
+    double logL = 0;
+    for (int i = 0; i < n; i++)
+        logL -= 0.5 * alpha[i]*alpha[i] + log(L[i*n + i]);
+    model.logLikelihood = logL - 0.5 * n * log(2.0 * M_PI);
+
+    for (int i = n-1; i >= 0; i--){
+        double entry = alpha[i];
+        for (int k = i+1; k < n; k++) entry -= L[k*n + i] * alpha[k];
+        alpha[i] = entry / L[i*n + i];
+    }
+
+    return true;
+} // end fit_surrogate
+
+
+
+bool tune_surrogate(surrogate& model){
+    // Grid search over the length scales. The efficiency changes on scales
+    //  of about a hundred GeV, so that's the range we look in.
+
+    double lengths[6] = {50.0, 100.0, 150.0, 200.0, 300.0, 400.0};
+
+    double bestStop = model.lengthStop;
+    double bestGlu  = model.lengthGlu;
+    double bestLogL = 0;
+    bool foundone = false;
+
+    for (int i = 0; i < 6; i++){
+        for (int j = 0; j < 6; j++){
+            model.lengthStop = lengths[i];
+            model.lengthGlu  = lengths[j];
+            if (!fit_surrogate(model)) continue;
+            if (!foundone || (model.logLikelihood > bestLogL)){
+                bestLogL = model.logLikelihood;
+                bestStop = lengths[i];
+                bestGlu  = lengths[j];
+                foundone = true;
+            }
+        }
+    }
+
+    if (!foundone) return false;
+
+    model.lengthStop = bestStop;
+    model.lengthGlu  = bestGlu;
+    return fit_surrogate(model);
+} // end tune_surrogate
+
+
+
+void predict_surrogate(surrogate& model, double mstop, double mglu,
+                       double& efficiency, double& uncertainty){
+    // mean = mean + k*^T alpha,  variance = k(x,x) - |L^-1 k*|^2
+
+    int n = model.points.size();
+    vector<double>& L = model.chol;
+
+    vector<double> kstar(n);
+    for (int i = 0; i < n; i++)
+        kstar[i] = surrogate_kernel(model, mstop, mglu,
+                                    model.points[i].mstop,
+                                    model.points[i].mglu);
+
+    efficiency = model.mean;
+    for (int i = 0; i < n; i++) efficiency += kstar[i] * model.alpha[i];
+
+    // forward substitution for v = L^-1 k*
+    double variance = model.amplitude * model.amplitude;
+    for (int i = 0; i < n; i++){
+        double entry = kstar[i];
+        for (int k = 0; k < i; k++) entry -= L[i*n + k] * kstar[k];
+        kstar[i] = entry / L[i*n + i];
+        variance -= kstar[i] * kstar[i];
+    }
+
+    uncertainty = (variance > 0) ? sqrt(variance) : 0.0;
+} // end predict_surrogate
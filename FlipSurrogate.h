@@ -0,0 +1,67 @@
+// FlipSurrogate.h
+// Interpolating the stored efficiencies across the (mstop, mglu) plane
+// INCLUDE GUARD
+#ifndef __FLIPSURROGATE_H_INCLUDED__
+#define __FLIPSURROGATE_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <sstream>              // for string stream
+#include <iostream>             // for i don't know
+#include <fstream>              // for file in/out
+using namespace std;
+
+struct surrogatepoint{
+    // one stored efficiency, repeated runs of the same point are averaged
+    double mstop;
+    double mglu;
+    double efficiency;
+    int nRuns;              // how many output.dat lines went into this
+};
+
+struct surrogate{
+    // Gaussian process fit to the efficiencies of one signal region.
+    // The kernel is a squared exponential in (mstop, mglu):
+    //   k(x, x') = amplitude^2 exp( -dstop^2/2 lengthStop^2
+    //                               -dglu^2/2 lengthGlu^2 )
+    // and each stored point has its own noise, noise^2 / nRuns.
+    int iSR;
+    vector<surrogatepoint> points;
+    double lengthStop;      // GeV
+    double lengthGlu;       // GeV
+    double amplitude;       // prior spread of the efficiency
+    double minAmplitude;    // ... never less than this, so a point far
+                            //  from every stored one is as uncertain as this
+    double noise;           // statistical error of a single run
+    double mean;            // prior mean, the average stored efficiency
+    vector<double> chol;    // Cholesky factor of the covariance, n x n
+    vector<double> alpha;   // covariance^-1 (efficiency - mean)
+    double logLikelihood;   // log marginal likelihood of this fit
+};
+
+int read_efficiencies(string, map<int, vector<surrogatepoint> >&);
+    // Reads an output.dat (or adaptive.dat) style file:
+    //  mstop  mglu  SR  efficiency  [anything else]
+    // Lines that don't start with numbers (e.g. background runs) are skipped
+    // Returns the number of lines that were used
+
+bool fit_surrogate(surrogate&);
+    // Factorizes the covariance for the current length scales
+    // Returns false if the matrix isn't positive definite
+
+bool tune_surrogate(surrogate&);
+    // Picks the length scales that maximize the marginal likelihood
+    //  from a small grid, then refits
+    // Returns false (and leaves the fit unusable) if no length scales on
+    //  the grid give a positive definite covariance
+
+void predict_surrogate(surrogate&, double, double, double&, double&);
+    // Inputs: fitted surrogate, mstop, mglu
+    // Outputs: interpolated efficiency and its uncertainty
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPSURROGATE_H_INCLUDED__
@@ -0,0 +1,207 @@
+/********************************************************************************
+*   FlipThreshold.cpp by Flip Tanedo (pt267@cornell.edu)                        *
+*   One-pass scans of the kinematic thresholds:                                 *
+*   - the event's object pT's or |eta|'s, sorted, are the breakpoints           *
+*   - threshold values between the same two breakpoints share one selection     *
+*   - difference arrays turn "passed for values i..j" into per-value counts     *
+********************************************************************************/
+
+#include "FlipThreshold.h"
+#include <algorithm>                    // sort, unique, lower_bound
+#include <cmath>                        // fabs
+
+
+static bool fill_breakpoints(string name, flipevent& record,
+                             vector<double>& points){
+    // The values of the event's objects that the threshold is compared
+    //  to (see lepton_kinematic_cut and jet_kinematic_cut). Returns false
+    //  if name isn't one of the kinematic thresholds
+
+    points.clear();
+
+    bool electrons = (name == "electron_pT") || (name == "eta_bar")
+                  || (name == "eta_end");
+    bool muons     = (name == "muon_pT");
+    bool leptons   = (name == "lepton_eta");
+    bool jets      = (name == "jet_pT") || (name == "jet_eta");
+    bool pT        = (name == "electron_pT") || (name == "muon_pT")
+                  || (name == "jet_pT");
+
+    if (!(electrons || muons || leptons || jets)) return false;
+
+    if (jets){
+        for (unsigned int i = 0; i < record.prepartons.size(); i++){
+            fastjet::PseudoJet& jet = record.prepartons[i].second;
+            points.push_back(pT ? jet.pt() : fabs(jet.eta()));
+        }
+        return true;
+    }
+
+    for (unsigned int i = 0; i < record.preleptons.size(); i++){
+        int id = abs(record.preleptons[i].first);
+        if (electrons && (id != 11)) continue;
+        if (muons && (id != 13)) continue;
+        fastjet::PseudoJet& lepton = record.preleptons[i].second;
+        points.push_back(pT ? lepton.pt() : fabs(lepton.eta()));
+    }
+    return true;
+} // end fill_breakpoints
+
+
+
+bool read_thresholds(vector<flipthreshold>& scans, string declaration,
+                     const effparams& nominal){
+    // name:value,value,...;name:value,...
+
+    scans.clear();
+    if ((declaration == "") || (declaration == "none")) return true;
+
+    bool ok = true;
+    stringstream parameters(declaration);
+    string parameter;
+    while (getline(parameters, parameter, ';')){
+        if (parameter == "") continue;
+
+        flipthreshold scan;
+        size_t colon = parameter.find(':');
+        scan.name = parameter.substr(0, colon);
+        scan.params = nominal;
+
+        // values, in order, each once
+        if (colon != string::npos){
+            stringstream values(parameter.substr(colon+1));
+            string value;
+            while (getline(values, value, ','))
+                if (value != "") scan.values.push_back(atof(value.c_str()));
+        }
+        sort(scan.values.begin(), scan.values.end());
+        scan.values.erase(unique(scan.values.begin(), scan.values.end()),
+                          scan.values.end());
+
+        flipevent nothing;
+        if (scan.values.empty() ||
+            !fill_breakpoints(scan.name, nothing, scan.breakpoints)){
+            cout << endl << "ERROR: can't scan " << parameter
+                 << " (kinematic thresholds only; see vary= for the rest)"
+                 << ", leaving it out" << endl;
+            ok = false;
+            continue;
+        }
+
+        vector<double*> members;
+        effparam_members(scan.params, scan.name, members);
+        scan.nominalValue = *members[0];
+
+        scan.weightDiff.assign(scan.values.size() + 1, 0.0);
+        scan.eventDiff.assign(scan.values.size() + 1, 0);
+        scan.nGenerated = 0;
+        scan.weightGenerated = 0;
+        scans.push_back(scan);
+    }
+    return ok;
+} // end read_thresholds
+
+
+
+void clear_thresholds(vector<flipthreshold>& scans){
+    // Same values, no events yet
+
+    for (unsigned int i = 0; i < scans.size(); i++){
+        scans[i].weightDiff.assign(scans[i].values.size() + 1, 0.0);
+        scans[i].eventDiff.assign(scans[i].values.size() + 1, 0);
+        scans[i].nGenerated = 0;
+        scans[i].weightGenerated = 0;
+    }
+} // end clear_thresholds
+
+
+
+void scan_event(vector<flipthreshold>& scans, flipevent& record,
+                signalregion& region, unsigned int seed, flipstate& state){
+    // For every scan: one selection per group of values
+
+    flipcounts scratch;                 // select_event wants a cutflow
+    clear_counts(scratch);
+    vector<double*> members;
+
+    for (unsigned int iScan = 0; iScan < scans.size(); iScan++){
+        flipthreshold& scan = scans[iScan];
+        scan.nGenerated++;
+        scan.weightGenerated += record.weight;
+        fill_breakpoints(scan.name, record, scan.breakpoints);
+        sort(scan.breakpoints.begin(), scan.breakpoints.end());
+
+        effparam_members(scan.params, scan.name, members);
+        double& threshold = *members[0];
+
+        int nValues = scan.values.size();
+        int first = 0;
+        while (first < nValues){
+
+            // the group: values up to the next breakpoint (a value right
+            //  on a breakpoint is a group of its own)
+            vector<double>::iterator next =
+                lower_bound(scan.breakpoints.begin(), scan.breakpoints.end(),
+                            scan.values[first]);
+            int last = first;
+            while ((last + 1 < nValues) &&
+                   ((next == scan.breakpoints.end()) ||
+                    (scan.values[last + 1] < *next)))
+                last++;
+
+            threshold = scan.values[first];
+            if (select_event(record, region, scan.params, seed, state,
+                             scratch)){
+                scan.weightDiff[first]    += record.weight;
+                scan.weightDiff[last + 1] -= record.weight;
+                scan.eventDiff[first]++;
+                scan.eventDiff[last + 1]--;
+            }
+            first = last + 1;
+        }
+    }
+} // end scan_event
+
+
+
+void add_thresholds(vector<flipthreshold>& total,
+                    vector<flipthreshold>& part){
+    // Differences add just like counts
+
+    for (unsigned int i = 0; (i < total.size()) && (i < part.size()); i++){
+        total[i].nGenerated      += part[i].nGenerated;
+        total[i].weightGenerated += part[i].weightGenerated;
+        for (unsigned int j = 0; j < total[i].weightDiff.size(); j++){
+            total[i].weightDiff[j] += part[i].weightDiff[j];
+            total[i].eventDiff[j]  += part[i].eventDiff[j];
+        }
+    }
+} // end add_thresholds
+
+
+
+void report_thresholds(vector<flipthreshold>& scans, int nEvent,
+                       double nominal){
+    // e.g. "jet_pT = 40:    0.0064   (6 events)"
+
+    for (unsigned int i = 0; i < scans.size(); i++){
+        flipthreshold& scan = scans[i];
+        cout << "Threshold scan (same dice as the nominal, "
+             << scan.nGenerated << " of " << nEvent
+             << " generated events):" << endl;
+
+        double weight = 0;
+        int events = 0;
+        for (unsigned int j = 0; j < scan.values.size(); j++){
+            weight += scan.weightDiff[j];
+            events += scan.eventDiff[j];
+            cout << "  " << scan.name << " = " << scan.values[j] << ":\t"
+                 << weight / double(nEvent) << "\t(" << events
+                 << " events)";
+            if ((scan.values[j] == scan.nominalValue) &&
+                (fabs(weight / double(nEvent) - nominal) > 1e-9 * nominal))
+                cout << "\tNOT the nominal " << nominal << ": other dice?";
+            cout << endl;
+        }
+    }
+} // end report_thresholds
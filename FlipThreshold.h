@@ -0,0 +1,65 @@
+// FlipThreshold.h
+// Efficiency as a function of a kinematic threshold (jet pT, lepton eta,
+//  ...) for a whole list of values, in one run
+// INCLUDE GUARD
+#ifndef __FLIPTHRESHOLD_H_INCLUDED__
+#define __FLIPTHRESHOLD_H_INCLUDED__
+
+#include "FlipVariation.h"
+using namespace std;
+
+struct flipthreshold{
+    // One kinematic cut parameter (electron_pT, muon_pT, lepton_eta,
+    //  eta_bar, eta_end, jet_pT or jet_eta) and the values to try.
+    //
+    // For one event, moving a threshold only changes anything when it
+    //  goes past the pT (or |eta|) of one of the event's objects. So the
+    //  event's object values are sorted, and all the threshold values
+    //  with none of them in between get the same answer: select_event
+    //  runs once per group of values, not once per value, with the same
+    //  dice as the nominal selection (the lepton ID dice go by the place
+    //  in preleptons, so moving a lepton threshold doesn't move anyone's
+    //  roll, see cutLepID). The answer is added to the first
+    //  value of the group and taken off after the last one (a difference
+    //  array); adding up along the values at the end gives the passed
+    //  weight at every value.
+    string name;                        // which member of effparams
+    vector<double> values;              // increasing
+    effparams params;                   // nominal, scratch for the value
+    vector<double> weightDiff;          // passed weight, as differences
+    vector<int> eventDiff;              // passed events, as differences
+    vector<double> breakpoints;         // scratch: this event's values
+    double nominalValue;                // of the parameter, for the check
+    int nGenerated;                     // events scanned, and the vetoed
+    double weightGenerated;             //  ones (veto=1): the denominator
+};
+
+
+bool read_thresholds(vector<flipthreshold>&, string, const effparams&);
+    // Inputs: list to fill, declaration, nominal parameters
+    // The declaration is name:value,value,...;name:value,... e.g.
+    //  jet_pT:30,35,40,45,50;lepton_eta:2.1,2.4
+    // Returns false (and drops that parameter) if something can't be read
+
+void clear_thresholds(vector<flipthreshold>&);
+    // Zeroes the counts
+
+void scan_event(vector<flipthreshold>&, flipevent&, signalregion&,
+                unsigned int, flipstate&);
+    // Inputs: scans, event, signal region, run seed, scratch lists
+    // Counts the event at every value of every scanned parameter
+
+void add_thresholds(vector<flipthreshold>&, vector<flipthreshold>&);
+    // Adds the counts of the second list to the first (same scans)
+
+void report_thresholds(vector<flipthreshold>&, int, double);
+    // Input: scans, nEvent, nominal efficiency
+    // Prints the efficiency at every value, and whether every generated
+    //  event was counted. At the nominal value (if it's scanned) the
+    //  same dice have to give the nominal efficiency exactly; it says so
+    //  if they don't
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPTHRESHOLD_H_INCLUDED__
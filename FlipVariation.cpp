@@ -0,0 +1,211 @@
+/********************************************************************************
+*   FlipVariation.cpp by Flip Tanedo (pt267@cornell.edu)                        *
+*   Systematic variations of the detector parameters in one pass:               *
+*   - read_variations: "b_plateau-0.05,ID_e*0.97,..." into shifted effparams    *
+*   - vary_event: the selection again for every shift, with the same dice       *
+*   - report_variations: varied efficiencies next to the nominal one            *
+********************************************************************************/
+
+#include "FlipVariation.h"
+#include <cmath>                        // fabs
+
+
+static const string standard_variations =
+    // Rough +- shifts for a first look, not a careful set of systematics
+    "b_plateau+0.05,b_plateau-0.05,"
+    "ID_e+0.02,ID_e-0.02,ID_mu+0.02,ID_mu-0.02,"
+    "MET_x12*1.1,MET_x12*0.9,HT_x12*1.1,HT_x12*0.9";
+
+
+
+void effparam_members(effparams& params, string name,
+                      vector<double*>& members){
+    // The member(s) of params called name; empty if there isn't one
+
+    members.clear();
+
+    // one element of an array, e.g. MET_x12[0]
+    int index = -1;
+    size_t bracket = name.find('[');
+    if (bracket != string::npos){
+        index = atoi(name.substr(bracket+1).c_str());
+        name = name.substr(0, bracket);
+    }
+
+    double* first = 0;
+    int size = 1;
+    if      (name == "electron_pT") first = &params.electron_pT;
+    else if (name == "muon_pT")     first = &params.muon_pT;
+    else if (name == "lepton_eta")  first = &params.lepton_eta;
+    else if (name == "eta_bar")     first = &params.eta_bar;
+    else if (name == "eta_end")     first = &params.eta_end;
+    else if (name == "jet_pT")      first = &params.jet_pT;
+    else if (name == "jet_eta")     first = &params.jet_eta;
+    else if (name == "ID_e")        first = &params.ID_e;
+    else if (name == "ID_mu")       first = &params.ID_mu;
+    else if (name == "lepton_dR")   first = &params.lepton_dR;
+    else if (name == "Iiso")        first = &params.Iiso;
+    else if (name == "b_plateau")   first = &params.b_plateau;
+    else if (name == "b_lowpT")     first = &params.b_lowpT;
+    else if (name == "b_highpT")    first = &params.b_highpT;
+    else if (name == "b_lowslope")  first = &params.b_lowslope;
+    else if (name == "b_highslope") first = &params.b_highslope;
+    else if (name == "b_minpT")     first = &params.b_minpT;
+    else if (name == "eff_ee")      first = &params.eff_ee;
+    else if (name == "eff_emu")     first = &params.eff_emu;
+    else if (name == "eff_mumu")    first = &params.eff_mumu;
+    else if (name == "MET_x12"){    first = params.MET_x12;  size = 3; }
+    else if (name == "MET_sig"){    first = params.MET_sig;  size = 3; }
+    else if (name == "HT_x12"){     first = params.HT_x12;   size = 2; }
+    else if (name == "HT_sig"){     first = params.HT_sig;   size = 2; }
+    else return;
+
+    if (index >= size) return;
+    if ((bracket != string::npos) && (index < 0)) return;
+
+    for (int i = 0; i < size; i++)
+        if ((index < 0) || (i == index)) members.push_back(first + i);
+} // end effparam_members
+
+
+
+bool read_variations(vector<flipvariation>& variations, string declaration,
+                     const effparams& nominal){
+    // name+delta,name-delta,name*factor,name=value,standard
+
+    variations.clear();
+    if ((declaration == "") || (declaration == "none")) return true;
+
+    bool ok = true;
+    stringstream shifts(declaration);
+    string shift;
+    while (getline(shifts, shift, ',')){
+        if (shift == "") continue;
+
+        if (shift == "standard"){
+            vector<flipvariation> standard;
+            read_variations(standard, standard_variations, nominal);
+            variations.insert(variations.end(), standard.begin(),
+                              standard.end());
+            continue;
+        }
+
+        // the operator is the first +, -, * or = after the name
+        size_t op = shift.find_first_of("+-*=", 1);
+        char* end = 0;
+        double value = 0;
+        if (op != string::npos)
+            value = strtod(shift.c_str() + op + 1, &end);
+
+        flipvariation variation;
+        variation.name = shift;
+        variation.params = nominal;
+        variation.ownRegion = false;
+        clear_counts(variation.stagecounts);
+
+        vector<double*> members;
+        if (op != string::npos)
+            effparam_members(variation.params, shift.substr(0, op), members);
+
+        if (members.empty() || (end == shift.c_str() + op + 1) || *end){
+            cout << endl << "ERROR: can't read the variation " << shift
+                 << ", leaving it out" << endl;
+            ok = false;
+            continue;
+        }
+
+        for (unsigned int i = 0; i < members.size(); i++){
+            if      (shift[op] == '+') *members[i] += value;
+            else if (shift[op] == '-') *members[i] -= value;
+            else if (shift[op] == '*') *members[i] *= value;
+            else                       *members[i]  = value;
+        }
+        variations.push_back(variation);
+    }
+    return ok;
+} // end read_variations
+
+
+
+bool read_regions(vector<flipvariation>& variations, string declaration,
+                  vector<signalregion>& signal_region,
+                  const effparams& nominal){
+    // 1,2,8
+
+    bool ok = true;
+    stringstream regions(declaration);
+    string region;
+    while (getline(regions, region, ',')){
+        if (region == "") continue;
+
+        char* end = 0;
+        long iSR = strtol(region.c_str(), &end, 10);
+        if (*end || (iSR < 0) || (iSR >= (long) signal_region.size())){
+            cout << endl << "ERROR: there's no signal region " << region
+                 << ", leaving it out" << endl;
+            ok = false;
+            continue;
+        }
+
+        flipvariation variation;
+        variation.name = "SR " + region;
+        variation.params = nominal;
+        variation.ownRegion = true;
+        variation.region = signal_region[iSR];
+        clear_counts(variation.stagecounts);
+        variations.push_back(variation);
+    }
+    return ok;
+} // end read_regions
+
+
+
+void clear_variations(vector<flipvariation>& variations){
+    // Same shifts, no events yet
+
+    for (unsigned int i = 0; i < variations.size(); i++)
+        clear_counts(variations[i].stagecounts);
+} // end clear_variations
+
+
+
+void vary_event(vector<flipvariation>& variations, flipevent& record,
+                signalregion& region, unsigned int seed, flipstate& state){
+    // Same event, same seed (so same dice), other parameters or cuts
+
+    for (unsigned int i = 0; i < variations.size(); i++)
+        select_event(record,
+                     variations[i].ownRegion ? variations[i].region : region,
+                     variations[i].params, seed, state,
+                     variations[i].stagecounts);
+} // end vary_event
+
+
+
+void add_variations(vector<flipvariation>& total,
+                    vector<flipvariation>& part){
+    // The lists come from the same declaration, so they line up
+
+    for (unsigned int i = 0; (i < total.size()) && (i < part.size()); i++)
+        add_counts(total[i].stagecounts, part[i].stagecounts);
+} // end add_variations
+
+
+
+void report_variations(vector<flipvariation>& variations, double efficiency,
+                       int nEvent){
+    // e.g. "  b_plateau-0.05      0.0058     -8.8%"
+
+    if (variations.empty()) return;
+
+    cout << "Variations (same dice as the nominal " << efficiency << "):"
+         << endl;
+    for (unsigned int i = 0; i < variations.size(); i++){
+        double varied = variations[i].stagecounts.weights[cutCharge]
+                      / double(nEvent);
+        cout << "  " << variations[i].name << "\t" << varied;
+        if (fabs(efficiency) > 0)
+            cout << "\t" << 100.0 * (varied - efficiency) / efficiency << "%";
+        cout << endl;
+    }
+} // end report_variations
@@ -0,0 +1,71 @@
+// FlipVariation.h
+// Detector systematics in the same run: every event also goes through the
+//  selection with shifted parameters, one cutflow per shift
+// INCLUDE GUARD
+#ifndef __FLIPVARIATION_H_INCLUDED__
+#define __FLIPVARIATION_H_INCLUDED__
+
+#include "FlipEvent.h"
+using namespace std;
+
+struct flipvariation{
+    // One shift of the numbers in effparams, e.g. b_plateau-0.05.
+    // The event goes through select_event again with these parameters and
+    //  the same run seed, so it rolls the same dice as the nominal
+    //  selection: a lepton that passed ID with ID_e = 0.76 only fails with
+    //  ID_e = 0.74 if its dice landed in between. The lepton ID dice go
+    //  by the lepton's place in preleptons, not in the list that passed
+    //  the kinematics, so a shift of electron_pT, muon_pT or the eta cuts
+    //  doesn't hand one lepton's roll to another. The difference to the
+    //  nominal efficiency is then the effect of the shift, not the noise
+    //  of two independent runs.
+    // The same goes for other signal regions (read_regions): nominal
+    //  parameters, another set of cuts, and the same events and dice.
+    string name;                        // as declared, e.g. "ID_e*0.97"
+    effparams params;                   // nominal, with the shift
+    bool ownRegion;                     // cut on region, not the run's
+    signalregion region;                // ... if ownRegion
+    flipcounts stagecounts;             // cutflow with these parameters
+};
+
+
+bool read_variations(vector<flipvariation>&, string, const effparams&);
+    // Inputs: list to fill, declaration, nominal parameters
+    // The declaration is a comma separated list of shifts, each one
+    //  name+delta, name-delta, name*factor or name=value, where name is a
+    //  member of effparams (MET_x12[0] for one element of an array,
+    //  MET_x12 for all of them). "standard" adds a rough set of +- shifts
+    //  of the b-tag, lepton ID and turn-ons. Returns false (and drops
+    //  that shift) if something can't be read
+
+bool read_regions(vector<flipvariation>&, string, vector<signalregion>&,
+                  const effparams&);
+    // Inputs: list to add to, declaration, all signal regions, nominal
+    //  parameters
+    // The declaration is a comma separated list of signal region numbers,
+    //  e.g. 1,2,8; each one is added as "SR 1" etc. Returns false (and
+    //  leaves it out) if a number isn't a signal region
+
+void effparam_members(effparams&, string, vector<double*>&);
+    // Inputs: parameters, member name (e.g. ID_e, MET_x12[0], MET_x12),
+    //  list to fill with pointers to the member(s); empty if unknown
+
+void clear_variations(vector<flipvariation>&);
+    // Zeroes the cutflows
+
+void vary_event(vector<flipvariation>&, flipevent&, signalregion&,
+                unsigned int, flipstate&);
+    // Inputs: variations, event, signal region, run seed, scratch lists
+    // Counts the event in every variation's cutflow
+
+void add_variations(vector<flipvariation>&, vector<flipvariation>&);
+    // Adds the cutflows of the second list to the first (same shifts)
+
+void report_variations(vector<flipvariation>&, double, int);
+    // Inputs: variations, nominal efficiency, nEvent
+    // Prints every varied efficiency and its change from the nominal
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPVARIATION_H_INCLUDED__
@@ -0,0 +1,93 @@
+/********************************************************************************
+*   FlipVeto.cpp by Flip Tanedo (pt267@cornell.edu)                             *
+*   Process-level veto for events that can't give two same-sign leptons         *
+*   and two b tags. Saves the decays/showers of events that would be thrown     *
+*   away anyway; see FlipVeto.h for why the efficiency doesn't change.          *
+********************************************************************************/
+
+#include "FlipVeto.h"
+
+
+flipveto::flipveto(){
+    // Nothing vetoed yet; setup() before use
+
+    fill_effparams(params);
+    vetoLeptons = false;
+    vetoed      = false;
+    nChecked    = 0;
+    nVetoed     = 0;
+    weightVetoed = 0;
+    bias        = 0;
+    nNoB        = 0;
+    nNoSS       = 0;
+} // end flipveto
+
+
+
+void flipveto::setup(const effparams& effparameters, bool leptons,
+                     flipbias* forced){
+    // Same numbers as the selection
+
+    params      = effparameters;
+    vetoLeptons = leptons;
+    bias        = forced;
+    otherParams.clear();
+} // end setup
+
+
+
+void flipveto::also_tag(const effparams& effparameters){
+    // Taggable by any of them is taggable
+
+    otherParams.push_back(effparameters);
+} // end also_tag
+
+
+
+bool flipveto::doVetoProcessLevel(Pythia8::Event& process){
+    // true: throw the event away
+
+    nChecked++;
+    vetoed = false;
+
+    int nTaggable = 0;      // could be b-tagged
+    int nPlus = 0;          // e+, mu+, tau+
+    int nMinus = 0;         // e-, mu-, tau-
+
+    for (int iPart = 0; iPart < process.size(); iPart++){
+        if (!process[iPart].isFinal()) continue;
+
+        int id = process[iPart].id();
+        if ((abs(id) == 11) || (abs(id) == 13) || (abs(id) == 15)){
+            if (id > 0) nMinus++;
+            else nPlus++;
+        }
+
+        // the same particles fill_event takes as b candidates
+        if (!process[iPart].isVisible()) continue;
+        if (abs(process[iPart].eta()) >= 5.0) continue;
+
+        // random number 0 passes whenever the efficiency isn't zero
+        bool taggable = b_selection_efficiency(process[iPart].pT(), 0.0,
+                                               params);
+        for (unsigned int i = 0; (i < otherParams.size()) && !taggable; i++)
+            taggable = b_selection_efficiency(process[iPart].pT(), 0.0,
+                                              otherParams[i]);
+        if (taggable) nTaggable++;
+    }
+
+    if (nTaggable < 2){
+        nNoB++;
+        vetoed = true;
+    }
+    else if (vetoLeptons && (nPlus < 2) && (nMinus < 2)){
+        nNoSS++;
+        vetoed = true;
+    }
+
+    if (vetoed){
+        nVetoed++;
+        weightVetoed += bias ? event_weight(*bias, process) : 1.0;
+    }
+    return vetoed;
+} // end doVetoProcessLevel
@@ -0,0 +1,66 @@
+// FlipVeto.h
+// Throws away events at the process level, before showers and hadron
+//  decays, when they can't possibly pass the SS2L selection
+// INCLUDE GUARD
+#ifndef __FLIPVETO_H_INCLUDED__
+#define __FLIPVETO_H_INCLUDED__
+
+#include "FlipEfficiency.h"
+#include "FlipBias.h"
+using namespace std;
+
+class flipveto : public Pythia8::UserHooks{
+    // Pythia calls doVetoProcessLevel once the hard process and its
+    //  resonance decays (gluino -> stop, stop -> b, t -> b W, W -> l nu)
+    //  are in pythia.process, before any showering or hadronization.
+    // An event is vetoed only if it fails for sure, whatever the dice:
+    //  - fewer than two visible final particles in the hard process that
+    //    b_selection_efficiency could tag (this is what the b-tag stage
+    //    looks at, see fill_event in FlipEvent.cpp), or
+    //  - with showers, MPI and hadronization off: fewer than two e, mu or
+    //    tau of the same sign, so no same-sign pair can come out.
+    //    (With them on, leptons can also come from photons and hadron
+    //    decays, so this part is switched off.)
+    // Use it with Check:abortIfVeto = on, so that a vetoed event makes
+    //  pythia.next() return false instead of quietly generating another
+    //  one. The event loop then counts it as generated and failed, and
+    //  the efficiency stays nPassed / nEvent exactly. The number vetoed
+    //  and their weights are the hook's own counts, whatever next() did.
+    // The pT it tags with is the parton's. With maps= (FlipCalibration.h)
+    //  the b-tag sees the pT scaled by a response and a Gaussian
+    //  resolution, which has no upper end, so no pT here is safe to veto
+    //  on: the run refuses veto= with maps=.
+public:
+    flipveto();
+
+    void setup(const effparams&, bool, flipbias* = 0);
+        // Inputs: parameters (for the b-tag), whether to veto on leptons,
+        //  forced decays (for the weights of the events vetoed), if any
+
+    void also_tag(const effparams&);
+        // A particle counts as taggable if these parameters could tag it
+        //  too (systematic variations, FlipVariation.h), so that nothing
+        //  a variation would have kept gets vetoed
+
+    virtual bool canVetoProcessLevel() { return true; }
+    virtual bool doVetoProcessLevel(Pythia8::Event&);
+
+    bool vetoed;            // was the last event vetoed? Set to false
+                            //  before each pythia.next()
+    int nChecked;           // # events looked at
+    int nVetoed;            // # of those vetoed
+    double weightVetoed;    // ... and their weights (FlipBias.h)
+    int nNoB;               // # vetoed for the b's
+    int nNoSS;              // # vetoed for the leptons
+
+private:
+    effparams params;
+    vector<effparams> otherParams;      // from also_tag
+    flipbias* bias;                     // 0: every event weighs 1
+    bool vetoLeptons;
+};
+
+
+
+// END INCLUDE GUARD
+#endif // __FLIPVETO_H_INCLUDED__
@@ -0,0 +1,109 @@
+/********************************************************************************
+*   LimitRPV.cc by Flip Tanedo (pt267@cornell.edu)                              *
+*   CLs exclusion of the stop/gluino plane from the stored efficiencies         *
+*   - uses FlipLimits.h: toys for every (point, SR) on all the cores            *
+*   - the best expected SR per point decides whether it's excluded              *
+*   - writes the map and the contour, no Pythia needed                          *
+********************************************************************************/
+
+// Inputs: efficiencies, signal regions, map output, contour output
+//  For example:
+//  ./LimitRPV output.dat regions.dat limits.dat limitcontour.dat xsec=gluino.xsec
+// Options of the form key=value can go anywhere: xsec= (mglu sigma(pb),
+//  unless the efficiency file has a cross section column), lumi=, cl=,
+//  toys=, workers= (0: every core), seed=, prefactor=
+
+
+
+#include "FlipLimits.h"             // all of my functions
+#include <cstdlib>                  // for srand
+#include <ctime>                    // for time
+#include <sys/time.h>               // for gettimeofday
+
+
+using namespace std;
+
+
+static double wall_clock(){
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.0e-6 * now.tv_usec;
+}
+
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    srand((unsigned)time(0));               // Initialize random numbers
+
+    fliplimits limits;                      // see FlipLimits.h
+    fill_limits(limits);
+
+
+    // Take in external values
+    // -----------------------
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_limitoption(limits, argv[iArg])) args.push_back(argv[iArg]);
+    int nArgs = args.size();
+
+    if (nArgs > 1)  limits.efficiencyFile = args[1];    // stored efficiencies
+    if (nArgs > 2)  limits.regionFile     = args[2];    // obs. and background
+    if (nArgs > 3)  limits.mapFile        = args[3];    // output filenames
+    if (nArgs > 4)  limits.contourFile    = args[4];
+
+    if (!read_limitinputs(limits)) return 1;
+
+
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    double start = wall_clock();
+    double nThrown = run_limits(limits);
+    double seconds = wall_clock() - start;
+
+    vector< vector<double> > segments;
+    limit_contour(limits, segments);
+    write_limits(limits, segments);
+
+
+    // What came out
+    // -------------
+    cout << endl << "Signal regions (" << limits.nToys << " toys, seed "
+         << limits.seed << "):" << endl;
+    cout << "SR \t observed \t background \t median \t CLb" << endl;
+    for (unsigned int r = 0; r < limits.regions.size(); r++){
+        limitregion& region = limits.regions[r];
+        cout << region.iSR << " \t " << region.nObserved << " \t\t "
+             << region.background << " +/- " << region.bgError << " \t "
+             << region.nMedian << " \t " << region.CLb << endl;
+    }
+
+    int nPoints = 0;
+    int nExcluded = 0;
+    vector<int> nBest(limits.regions.size(), 0);
+    for (unsigned int i = 0; i < limits.points.size(); i++){
+        if (limits.points[i].best < 0) continue;
+        nPoints++;
+        nBest[limits.points[i].best]++;
+        if (limits.points[i].excluded) nExcluded++;
+    }
+
+    cout << endl << nExcluded << " of " << nPoints << " points excluded at "
+         << 100 * limits.CL << "% CL, " << segments.size()
+         << " contour segments" << endl;
+    cout << "Best SR:";
+    for (unsigned int r = 0; r < limits.regions.size(); r++)
+        cout << " SR" << limits.regions[r].iSR << " " << nBest[r];
+    cout << endl;
+    cout << nThrown << " toys in " << seconds << " s on " << limits.nWorkers
+         << " threads" << endl << endl;
+
+
+    return 0;
+
+}
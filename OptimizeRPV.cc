@@ -0,0 +1,70 @@
+/********************************************************************************
+*   OptimizeRPV.cc by Flip Tanedo (pt267@cornell.edu)                           *
+*   Signal regions for the RPV model instead of SUS-12-017's:                   *
+*   - uses FlipOptimize.h: skimmed signal and background, read once             *
+*   - every combination of the SR cuts on all the cores                         *
+*   - the dominated ones dropped, the rest ranked                               *
+********************************************************************************/
+
+// Inputs: manifest of skimmed event records, output filename
+//  For example, skim at same-sign:
+//  ./PartonRPV 300 800 8 skim=ss2l skimfile=s300_800.dat
+//  ./PartonBGRPV ttW.dataset background.cmnd 8 bg.dat skim=ss2l
+//      skimfile=bg.dat cache=none          (bg_<label>.dat per file)
+//  then list them (see FlipOptimize.h) and:
+//  ./OptimizeRPV optimize.samples optimize.dat
+// Options of the form key=value can go anywhere: jets=, bjets=, met=, ht=,
+//  charge=, lumi=, bgerror=, minbg=, metric=, workers= (0: every core),
+//  top=, isogrid=
+
+
+
+#include "FlipOptimize.h"           // all of my functions
+
+
+using namespace std;
+
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    flipoptimize opt;                       // see FlipOptimize.h
+    fill_optimize(opt);
+
+
+    // Take in external values
+    // -----------------------
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_optimizeoption(opt, argv[iArg])) args.push_back(argv[iArg]);
+    int nArgs = args.size();
+
+    if (nArgs > 1)  opt.manifest = args[1];     // skimmed events
+    if (nArgs > 2)  opt.outFile  = args[2];     // the ranked regions
+
+    cout << "Reading " << opt.manifest << endl;
+    if (!read_optimizeinputs(opt)) return 1;
+
+
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    double start = wall_seconds();
+    double nLooked = run_optimize(opt);
+    double seconds = wall_seconds() - start;
+
+    report_optimize(opt);
+    write_optimize(opt);
+
+    cout << nLooked << " (event, region) pairs in " << seconds << " s on "
+         << opt.nWorkers << " threads; the frontier is in " << opt.outFile
+         << endl << endl;
+
+
+    return 0;
+
+}
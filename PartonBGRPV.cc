@@ -4,11 +4,23 @@
 *   Focuses on checking background generated from an LHE file                   *
 *   7 Oct 2012                                                                  *
 *   - debugging                                                                 *
+*   - several LHE files at once from a manifest (FlipDataset.h)                 *
 ********************************************************************************/
 
+// Inputs: LHE file, command file, signal region, output filename
+//  For example:
+//  ./PartonBGRPV eventsplus.lhe background.cmnd 8 output.dat
+// If the first argument isn't a .lhe file, it's a manifest of LHE files
+//  and cross sections (see FlipDataset.h), e.g.
+//  ./PartonBGRPV ttW.dataset background.cmnd 8 output.dat workers=4
+// Options of the form key=value can go anywhere: workers=, cache=, lumi=
+//  for the dataset, the rest as in PartonRPV (see runoptions in FlipEvent.h)
+
 #include "FlipEfficiency.h"         // all of my functions
 #include "FlipCommandFileFixer.h"   // all of my functions
 #include "FlipLHE.h"
+#include "FlipDataset.h"            // manifests of LHE files
+#include "FlipBias.h"               // force=, for the single file
 #include <sstream>                  // for string stream
 #include <fstream>                  // for file in/out
 
@@ -29,14 +41,46 @@ int main(int argc, char *argv[]) {
                                                 //  defined in SUS-12-017
     vector< pair<string, int> > counts;         // counts @ each cut 
                                                 //  with descriptions
-    int nEvents         = getnevents(input_lhe);// read number of events
+    int nEvents         = 0;                    // read from the LHE file
+    
+    flipdataset dataset;                        // if it's a manifest
+    fill_dataset(dataset);
     
     // TAKE IN EXTERNAL VALUES
     // -----------------------
-    if (argc > 1)  input_lhe    = argv[1];       // input LHE file
-    if (argc > 2)  command_file = argv[2];       // command file
-    if (argc > 3)  iSR          = atoi(argv[3]); // signal region
-    if (argc > 4)  outfile      = argv[4];       // output file
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_datasetoption(dataset, argv[iArg]) &&
+            !read_runoption(dataset.options, argv[iArg]))
+            args.push_back(argv[iArg]);
+    int nArgs = args.size();
+    
+    if (nArgs > 1)  input_lhe    = args[1];       // input LHE file
+    if (nArgs > 2)  command_file = args[2];       // command file
+    if (nArgs > 3)  iSR          = atoi(args[3]); // signal region
+    if (nArgs > 4)  outfile      = args[4];       // output file
+    
+    
+    // DATASET: MANY LHE FILES
+    // -----------------------
+    size_t dot = input_lhe.rfind('.');
+    if ((dot == string::npos) || (input_lhe.substr(dot) != ".lhe")){
+        dataset.commandFile = command_file;
+        dataset.signalRegions.assign(1, iSR);
+        stringstream regions(dataset.options.regions);  // regions=6,7
+        string region;
+        while (getline(regions, region, ','))
+            if (region != "") 
+                dataset.signalRegions.push_back(atoi(region.c_str()));
+        
+        if (!read_manifest(dataset, input_lhe)) return 1;
+        if (run_dataset(dataset) < 0) return 1;
+        report_dataset(dataset);
+        write_dataset(dataset, outfile);
+        return 0;
+    }
+    nEvents = getnevents(input_lhe);            // read number of events
     
     
     // SET UP THE PYTHIA OBJECT
@@ -44,6 +88,12 @@ int main(int argc, char *argv[]) {
     Pythia8::Pythia pythia;                 // Declare Pythia object
     // Pythia8::Event& event = pythia.event;   // Declare event as a shortcut
     pythia.readFile(command_file);          // Read in command file
+    
+    // W decays forced to leptons (force=), which background.cmnd used to
+    //  do itself; this path counts events, so the prefactor still applies
+    flipbias bias;
+    read_bias(bias, dataset.options.forced);
+    apply_bias(bias, pythia);
 
     // int nEvent = pythia.mode("Main:numberOfEvents");
     // int nAbort = pythia.mode("Main:timesAllowErrors");
@@ -10,11 +10,14 @@
 // Inputs: command file, stop mass, gluino mass, signal region, output filename
 //  For example:
 //  ./RPVHscanFlip RPVgluinoScan.cmnd 400.0 800.0 8
+// Options of the form key=value can go anywhere, e.g. batch=64 validate=1
+//  (see runoptions in FlipEvent.h)
 
 
 
 #include "FlipEfficiency.h"         // all of my functions
 #include "FlipCommandFileFixer.h"   // all of my functions
+#include "FlipEvent.h"              // runoptions
 #include <sstream>                  // for string stream
 #include <fstream>                  // for file in/out
 
@@ -40,52 +43,37 @@ int main(int argc, char *argv[]) {
     string spctemp      = "template.spc";       // default spc template
     string spcint       = "intermediate.spc";   // intermediate spc file
     string spcRun       = "spcRun.spc";         // output spc file for run
-    //
-    string cmndspc      = "SLHA:file = ";       // line to change in cmnd file
-    string cmndspcnew   = cmndspc + spcRun;     // ... replace with this
-    //
-    string blockmass    = "BLOCK MASS";         
-    string blockdiv     = "BLOCK";
-    string gluinoID     = "1000021";
-    string stopID       = "1000006";
     
     
     // Other definitions for the run
     // -----------------------------
     int iSR = 8;        // Signal region #, defined in SUS-12-017
+    runoptions options; // batching etc., see FlipEvent.h
+    fill_runoptions(options);
     
     
     // Take in external values
     // -----------------------
-    if (argc > 1)  mstop    = argv[1];       // stop mass
-    if (argc > 2)  mgluino  = argv[2];       // gluino mass
-    if (argc > 3)  iSR      = atoi(argv[3]); // signal region
-    if (argc > 4)  cmndtemp = argv[4];       // template command file
-    if (argc > 5)  outfile  = argv[5];       // output filename
-    if (argc > 6)  spctemp  = argv[6];       // template spectrum file
-
-
-    // Lines for updating the spectrum
-    // --------------------------------
-    string gluinoNew    = "   1000021   " + mgluino;    // line replacement
-    string stopNew      = "   1000006   " + mstop;      // line replacement
-
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_runoption(options, argv[iArg])) args.push_back(argv[iArg]);
+    int nArgs = args.size();
+    
+    if (nArgs > 1)  mstop    = args[1];       // stop mass
+    if (nArgs > 2)  mgluino  = args[2];       // gluino mass
+    if (nArgs > 3)  iSR      = atoi(args[3]); // signal region
+    if (nArgs > 4)  cmndtemp = args[4];       // template command file
+    if (nArgs > 5)  outfile  = args[5];       // output filename
+    if (nArgs > 6)  spctemp  = args[6];       // template spectrum file
 
 
     // UPDATE SPECTRUM
     // ---------------
+    // Points the command file at spcRun and writes both masses into it,
+    // see FixMassPoint in FlipCommandFileFixer.h
 
-    // Make sure command file is using the same spc file that we're creating
-    if(!FixCommand(cmndtemp, cmndrun, cmndspc, cmndspcnew)) 
-        cout << endl << " ERROR in FixCommand, setting " << cmndspcnew << endl;
-
-    // Using template spectrum, set gluino mass. Save to intermediate spectrum
-    if(!FixSpectrum(spctemp, spcint, blockmass, blockdiv, gluinoID, gluinoNew))
-        cout << endl << "ERROR: FixSpectrum, setting mass " << gluinoNew << endl;
-    
-    // Using intermediate spectrum, set stop mass. Save to final spectrum
-    if(!FixSpectrum(spcint, spcRun, blockmass, blockdiv, stopID, stopNew))
-        cout << endl << "ERROR: FixSpectrum, setting mass " << stopNew << endl;
+    FixMassPoint(cmndtemp, cmndrun, spctemp, spcint, spcRun, mstop, mgluino);
         
         
     // OUTPUT FILE STREAM
@@ -103,11 +91,11 @@ int main(int argc, char *argv[]) {
     *****************************************************************************/
 
     outstream << mstop << "\t" << mgluino << "\t" << iSR << "\t" 
-        << (signal_efficiency_b(cmndrun, counts, iSR) * 0.10608) << endl;
+        << signal_efficiency_b(cmndrun, counts, iSR, 0, &options) << endl;
         // << (signal_efficiency(cmndrun, counts, iSR) * 0.10608) << endl;
-        // 0.10608 = 0.3257^2 from W decays forced to go to leptons (for stats)
-        // Why? Because we assume you forced the W to decay leptonically in
-        // the command file.
+        // The W decays are forced to go to leptons (for stats), and each
+        // event is weighted with the real W branching ratios, so there's no
+        // 0.10608 = 0.3257^2 prefactor any more. See force= in FlipBias.h
 
     // // IF YOU WANT VERBOSE SCREEN OUTPUT:
     // cout << "STOP: " << mstop << endl;
@@ -0,0 +1,86 @@
+/********************************************************************************
+*   ReplayRPV.cc by Flip Tanedo (pt267@cornell.edu)                             *
+*   The selection again on events PartonRPV skimmed (skim=, FlipSkim.h),        *
+*   with other cuts, without generating anything                                *
+*   - only the stages whose cuts changed are worked out again                   *
+*   - uses FlipIncremental.h                                                    *
+********************************************************************************/
+
+// Inputs: skimmed event records, signal region, output filename
+//  For example, skim once:
+//  ./PartonRPV 300 800 8 skim=generated skimfile=events.dat seed=7
+//  then try cuts:
+//  ./ReplayRPV events.dat 8 replay.dat set=minHT=400,minMET=100
+// Options of the form key=value can go anywhere: set=, cache= (see
+//  FlipIncremental.h), and seed=, validate=1 as in PartonRPV
+
+
+
+#include "FlipIncremental.h"        // all of my functions
+#include <sstream>                  // for string stream
+#include <fstream>                  // for file in/out
+
+
+using namespace std;
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    string eventfile = "events.dat";        // skimmed records
+    string outfile   = "replay.dat";        // Output filename
+    int iSR          = 8;                   // Signal region #
+
+    flipincremental replay;                 // see FlipIncremental.h
+    fill_incremental(replay);
+    runoptions options;                     // seed, validate and isogrid
+    fill_runoptions(options);
+
+
+    // Take in external values
+    // -----------------------
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_incrementaloption(replay, argv[iArg]) &&
+            !read_runoption(options, argv[iArg]))
+            args.push_back(argv[iArg]);
+    int nArgs = args.size();
+
+    if (nArgs > 1)  eventfile = args[1];        // skimmed records
+    if (nArgs > 2)  iSR       = atoi(args[2]);  // signal region
+    if (nArgs > 3)  outfile   = args[3];        // output filename
+
+
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    if (!read_incremental(replay, eventfile, iSR)) return 1;
+    if (options.seed != 0) replay.seed = options.seed;  // over the .meta's
+    if (!run_incremental(replay)) return 1;
+    report_incremental(replay);
+    if (options.validate) validate_incremental(replay, options);
+
+
+    // OUTPUT FILE STREAM
+    // ------------------
+    // Same columns as PartonRPV's, then what was set
+
+    ofstream outstream;
+    outstream.open(outfile.c_str(), ios::app); // append to end of file
+    outstream.precision(6);
+    outstream.setf(ios::fixed);
+    outstream.setf(ios::showpoint);
+
+    outstream << replay.mstop << "\t" << replay.mglu << "\t" << iSR << "\t"
+        << replay.stagecounts.weights[cutCharge] / double(replay.nEvent)
+        << "\t" << (replay.settings == "" ? "-" : replay.settings) << endl;
+
+    outstream.close();
+
+
+    return 0;
+
+}
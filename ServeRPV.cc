@@ -0,0 +1,60 @@
+/********************************************************************************
+*   ServeRPV.cc by Flip Tanedo (pt267@cornell.edu)                              *
+*   Signal efficiencies on request, for a fit that asks for one mass point      *
+*   at a time, without paying for Pythia's start-up every time                  *
+*   - uses FlipServer.h (and so flip_efficiency, FlipLibrary.h)                 *
+*   - AskRPV.cc is a client for trying it out                                   *
+********************************************************************************/
+
+// Inputs: socket, number of workers
+//  For example:
+//  ./ServeRPV flipeff.sock 4 &
+//  ./AskRPV flipeff.sock 400 900 8,6 events=5000
+//  ./AskRPV flipeff.sock shutdown
+// Options of the form key=value can go anywhere: cmnd=, spc=, scratch=,
+//  warm=0 (a new Pythia for every run), and run options (batch=, force=,
+//  ...) that every request starts from; requests can add their own, see
+//  FlipServer.h for what a request looks like
+
+
+
+#include "FlipServer.h"             // all of my functions
+
+
+using namespace std;
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    srand((unsigned)time(0));               // Initialize random numbers
+
+    flipserver server;                      // see FlipServer.h
+    fill_server(server);
+
+
+    // Take in external values
+    // -----------------------
+    // key=value arguments are options, the rest are positional as always
+    vector<char*> args(1, argv[0]);
+    for (int iArg = 1; iArg < argc; iArg++)
+        if (!read_serveroption(server, argv[iArg]))
+            args.push_back(argv[iArg]);
+    int nArgs = args.size();
+
+    if (nArgs > 1)  server.socketPath = args[1];        // socket file
+    if (nArgs > 2)  server.nWorkers   = atoi(args[2]);  // # generators
+
+
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    if (!start_server(server)) return 1;
+    run_server(server);
+
+
+    return 0;
+
+}
@@ -0,0 +1,146 @@
+/********************************************************************************
+*   SurrogateRPV.cc by Flip Tanedo (pt267@cornell.edu)                          *
+*   Interpolates stored SS2L efficiencies across the stop/gluino plane          *
+*   - fits a Gaussian process to every point in output.dat for one SR           *
+*   - predicts efficiency +/- uncertainty on a grid, no Pythia needed           *
+*   - flags the points whose uncertainty is too big, those are the ones         *
+*     worth running PartonRPV on                                                *
+********************************************************************************/
+
+// Inputs: data file, signal region, query grid, uncertainty threshold, output
+//  For example:
+//  ./SurrogateRPV output.dat 8 200 800 400 1400 25 0.001 surrogate.dat
+//  then optionally the error of a single run, and the least prior spread
+//  (the uncertainty far from every stored point; keep it above threshold)
+
+
+
+#include "FlipSurrogate.h"          // all of my functions
+#include <sstream>                  // for string stream
+#include <fstream>                  // for file in/out
+#include <cstdlib>                  // for atof
+
+
+using namespace std;
+
+
+int main(int argc, char *argv[]) {
+
+    // INITIALIZE
+    // ----------
+    string datafile     = "output.dat";     // stored efficiencies
+    string outfile      = "surrogate.dat";  // predictions go here
+    int iSR             = 8;                // Signal region #
+    double mstopMin     = 200.0;            // query grid
+    double mstopMax     = 800.0;
+    double mgluMin      = 400.0;
+    double mgluMax      = 1400.0;
+    double step         = 25.0;
+    double threshold    = 0.001;            // flag if uncertainty above this
+    double noise        = 0.001;            // stat. error of a single run
+                                            //  (about 10^4 events at 1%)
+    double minAmplitude = 0.01;             // least prior spread, above
+                                            //  threshold so the gaps in
+                                            //  the scan get flagged
+
+
+    // Take in external values
+    // -----------------------
+    if (argc > 1)  datafile     = argv[1];        // stored efficiencies
+    if (argc > 2)  iSR          = atoi(argv[2]);  // signal region
+    if (argc > 3)  mstopMin     = atof(argv[3]);  // stop mass range
+    if (argc > 4)  mstopMax     = atof(argv[4]);
+    if (argc > 5)  mgluMin      = atof(argv[5]);  // gluino mass range
+    if (argc > 6)  mgluMax      = atof(argv[6]);
+    if (argc > 7)  step         = atof(argv[7]);  // grid spacing
+    if (argc > 8)  threshold    = atof(argv[8]);  // uncertainty threshold
+    if (argc > 9)  outfile      = argv[9];        // output filename
+    if (argc > 10) noise        = atof(argv[10]); // single run error
+    if (argc > 11) minAmplitude = atof(argv[11]); // least prior spread
+
+
+    // FIT
+    // ---
+    map<int, vector<surrogatepoint> > data;
+    read_efficiencies(datafile, data);
+
+    if (data[iSR].empty()){
+        cout << endl << "ERROR: no points for Signal Region " << iSR
+             << " in " << datafile << endl;
+        return 1;
+    }
+
+    surrogate model;
+    model.iSR           = iSR;
+    model.points        = data[iSR];
+    model.lengthStop    = 150.0;
+    model.lengthGlu     = 150.0;
+    model.noise         = noise;
+    model.minAmplitude  = minAmplitude;
+    if (!tune_surrogate(model)){
+        cout << endl << "ERROR: no length scales give a usable fit to the "
+             << model.points.size() << " points of Signal Region " << iSR
+             << " (same masses twice with noise 0?)" << endl;
+        return 1;
+    }
+
+    cout << endl << "Signal Region " << iSR << ": " << model.points.size()
+         << " stored points" << endl;
+    cout << "Length scales: " << model.lengthStop << " GeV (stop), "
+         << model.lengthGlu << " GeV (gluino)" << endl;
+    cout << "Prior spread: " << model.amplitude << " (at least "
+         << model.minAmplitude << ")" << endl;
+
+
+    // OUTPUT FILE STREAM
+    // ------------------
+    ofstream outstream;
+    outstream.open(outfile.c_str());
+    outstream.precision(6);
+    outstream.setf(ios::fixed);
+    outstream.setf(ios::showpoint);
+    outstream << "# mstop \t mglu \t SR \t efficiency \t uncertainty \t"
+              << " flagged" << endl;
+
+
+    /****************************************************************************
+    *   THIS PART DOES THE CALCULATION                                          *
+    *****************************************************************************/
+
+    int nFlagged = 0;
+    cout << endl << "Points to simulate (mstop mglu):" << endl;
+
+    for (double mstop = mstopMin; mstop <= mstopMax + 1.0e-6; mstop += step){
+        for (double mglu = mgluMin; mglu <= mgluMax + 1.0e-6; mglu += step){
+
+            double efficiency = 0;
+            double uncertainty = 0;
+            predict_surrogate(model, mstop, mglu, efficiency, uncertainty);
+
+            bool flagged = (uncertainty > threshold);
+            if (flagged){
+                cout << mstop << "\t" << mglu << endl;
+                nFlagged++;
+            }
+
+            outstream << mstop << "\t" << mglu << "\t" << iSR << "\t"
+                      << efficiency << "\t" << uncertainty << "\t"
+                      << flagged << endl;
+        }
+    }
+
+    cout << endl << nFlagged << " points above uncertainty " << threshold
+         << endl << endl;
+
+
+    /****************************************************************************
+    *   CLEAN UP: close filestreams, etc.                                       *
+    *****************************************************************************/
+
+    outstream.close();
+
+
+    return 0;
+
+}
+